@@ -0,0 +1,70 @@
+"""
+Build the C micro-benchmark `bench/microbench` from the extension sources.
+
+The templated `.c.src` sources are expanded with NumPy's `conv_template`
+(like `setup.py` does through `numpy.distutils`) and the program is linked
+against libpython, since it embeds the interpreter to use the NumPy C-API.
+
+    python bench/build_microbench.py [--debug]
+"""
+import argparse
+import glob
+import os
+import sys
+import sysconfig
+import tempfile
+
+import numpy
+from numpy.distutils.ccompiler import new_compiler
+from numpy.distutils.conv_template import process_file
+from distutils.sysconfig import customize_compiler
+
+
+bench_dir = os.path.dirname(os.path.abspath(__file__))
+src_dir = os.path.join(os.path.dirname(bench_dir), "src")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--debug", action="store_true",
+                        help="build without optimizations and with asserts")
+    args = parser.parse_args()
+
+    compiler = new_compiler()
+    customize_compiler(compiler)
+
+    with tempfile.TemporaryDirectory() as build_dir:
+        sources = [os.path.join(bench_dir, "microbench.c")]
+        for fname in sorted(glob.glob(os.path.join(src_dir, "*.c"))):
+            sources.append(fname)
+        for fname in sorted(glob.glob(os.path.join(src_dir, "*.c.src"))):
+            out = os.path.join(build_dir, os.path.basename(fname)[:-4])
+            with open(out, "w") as f:
+                f.write(process_file(fname))
+            sources.append(out)
+
+        if sys.platform == "win32":
+            extra_args = ["/Od"] if args.debug else ["/O2"]
+        else:
+            extra_args = ["-O0", "-g"] if args.debug else ["-O2"]
+        objects = compiler.compile(
+                sources, output_dir=build_dir,
+                include_dirs=[numpy.get_include(), src_dir,
+                              sysconfig.get_paths()["include"]],
+                macros=[] if args.debug else [("NDEBUG", None)],
+                extra_postargs=extra_args)
+
+        libdir = sysconfig.get_config_var("LIBDIR")
+        libraries = ["python" + sysconfig.get_config_var("LDVERSION")]
+        if sys.platform != "win32":
+            libraries += ["m", "pthread"]
+        compiler.link_executable(
+                objects, "microbench", output_dir=bench_dir,
+                libraries=libraries, library_dirs=[libdir],
+                runtime_library_dirs=[libdir] if sys.platform != "win32" else [])
+
+    print("built", os.path.join(bench_dir, "microbench"))
+
+
+if __name__ == "__main__":
+    main()
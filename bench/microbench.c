@@ -0,0 +1,490 @@
+/*
+ * Micro-benchmark of the tokenizer and the converters in isolation.
+ *
+ * The data is generated in memory, so neither reading the file nor creating
+ * the result array is measured.  For each case the best of several runs
+ * is reported in MB/s (of the text as 1-byte characters) and rows/s (or
+ * fields/s for the converters).  Build and run with:
+ *
+ *     python bench/build_microbench.py
+ *     bench/microbench [nrows]
+ *
+ * This embeds Python (NumPy must be importable) since the converters and
+ * the module initialization need the NumPy C-API.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL npreadtext_ARRAY_API
+#include "numpy/arrayobject.h"
+
+#include "parser_config.h"
+#include "stream.h"
+#include "stream_file.h"
+#include "tokenize.h"
+#include "field_types.h"
+#include "conversions.h"
+#include "str_to_int.h"
+
+
+PyMODINIT_FUNC
+PyInit__readtextmodule(void);
+
+
+/* Run each case at least this long (seconds) and at least three times */
+#define MIN_TIME 0.2
+#define MIN_RUNS 3
+/* Characters returned by each call of the chunked stream */
+#define CHUNKSIZE 16384
+
+
+static double
+now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1e-9 * t.tv_nsec;
+#endif
+}
+
+
+static uint64_t rng_state = 0x853c49e6748fea9bULL;
+
+static uint32_t
+rng_next(void)
+{
+    /* A small xorshift generator, the data only has to look random */
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+
+/*
+ * A growing text buffer holding the generated data.
+ */
+typedef struct {
+    char *data;
+    size_t size;
+    size_t allocated;
+} text;
+
+
+static void
+text_append(text *t, const char *str)
+{
+    size_t len = strlen(str);
+    if (t->size + len + 1 > t->allocated) {
+        t->allocated = 2 * (t->size + len + 1);
+        t->data = realloc(t->data, t->allocated);
+        if (t->data == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    memcpy(t->data + t->size, str, len + 1);
+    t->size += len;
+}
+
+
+typedef enum {
+    COLUMNS_FLOAT,
+    COLUMNS_INT,
+    COLUMNS_ID,  /* large integers */
+    COLUMNS_MIXED,
+    COLUMNS_QUOTED,
+} columns_kind;
+
+
+static void
+append_field(text *t, columns_kind kind, int col)
+{
+    static const char *words[] = {"abc", "def", "ghi", "apple", "orange"};
+    char field[64];
+
+    if (kind == COLUMNS_MIXED) {
+        /* Same mix as `npreadtext/tests/generate_big_mixed.py` */
+        kind = col < 10 ? COLUMNS_INT : col < 14 ? COLUMNS_QUOTED : COLUMNS_FLOAT;
+    }
+    switch (kind) {
+        case COLUMNS_FLOAT:
+            snprintf(field, sizeof(field), "%.17g",
+                    (double)rng_next() / UINT32_MAX);
+            break;
+        case COLUMNS_INT:
+            snprintf(field, sizeof(field), "%u", rng_next() % 1000000);
+            break;
+        case COLUMNS_ID:
+            snprintf(field, sizeof(field), "%llu",
+                    ((unsigned long long)rng_next() << 24) ^ rng_next());
+            break;
+        default:
+            snprintf(field, sizeof(field), "\"%s, %s\"",
+                    words[rng_next() % 5], words[rng_next() % 5]);
+    }
+    text_append(t, field);
+}
+
+
+static text
+generate(columns_kind kind, Py_ssize_t nrows, int ncols, const char *delimiter)
+{
+    text t = {NULL, 0, 0};
+    text_append(&t, "");
+    for (Py_ssize_t i = 0; i < nrows; i++) {
+        for (int j = 0; j < ncols; j++) {
+            if (j != 0) {
+                text_append(&t, delimiter);
+            }
+            append_field(&t, kind, j);
+        }
+        text_append(&t, "\n");
+    }
+    return t;
+}
+
+
+/*
+ * A stream returning the data in chunks of a given unicode kind (like
+ * reading a Python file object).
+ */
+typedef struct {
+    char *data;
+    size_t pos;
+    size_t size;
+    int kind;
+} chunked_buffer;
+
+
+static int
+cb_nextbuf(chunked_buffer *cb, char **start, char **end, int *kind)
+{
+    size_t chunk = CHUNKSIZE * cb->kind;
+    if (chunk > cb->size - cb->pos) {
+        chunk = cb->size - cb->pos;
+    }
+    *start = cb->data + cb->pos;
+    *end = *start + chunk;
+    *kind = cb->kind;
+    cb->pos += chunk;
+    return chunk == 0 ? BUFFER_IS_FILEEND : BUFFER_MAY_CONTAIN_NEWLINE;
+}
+
+
+static int
+cb_del(stream *strm)
+{
+    free(strm);
+    return 0;
+}
+
+
+static stream *
+stream_chunked(chunked_buffer *cb)
+{
+    stream *strm = malloc(sizeof(stream));
+    if (strm == NULL) {
+        return NULL;
+    }
+    cb->pos = 0;
+    strm->stream_data = cb;
+    strm->stream_nextbuf = (void *)&cb_nextbuf;
+    strm->stream_close = &cb_del;
+    strm->stream_rawdata = NULL;
+    return strm;
+}
+
+
+/* Copy the 1-byte text into a buffer of the given unicode kind */
+static char *
+widen(const text *t, int kind)
+{
+    char *data = malloc(t->size * kind + 1);
+    if (data == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < t->size; i++) {
+        Py_UCS1 c = (Py_UCS1)t->data[i];
+        if (kind == PyUnicode_1BYTE_KIND) {
+            ((Py_UCS1 *)data)[i] = c;
+        }
+        else if (kind == PyUnicode_2BYTE_KIND) {
+            ((Py_UCS2 *)data)[i] = c;
+        }
+        else {
+            ((Py_UCS4 *)data)[i] = c;
+        }
+    }
+    return data;
+}
+
+
+static void
+report(const char *name, double seconds, size_t nbytes,
+        Py_ssize_t nitems, const char *items)
+{
+    printf("%-44s %9.1f MB/s %12.0f %s/s\n", name,
+            nbytes / seconds / 1e6, nitems / seconds, items);
+}
+
+
+/*
+ * Tokenize all of the data, returns the number of rows or -1 on error.
+ * `chunked` is NULL to use the (raw) memory stream.
+ */
+static Py_ssize_t
+tokenize_all(const text *t, chunked_buffer *chunked,
+        parser_config *pconfig, size_t max_fields)
+{
+    tokenizer_state ts;
+    stream *s;
+    if (chunked == NULL) {
+        s = stream_memory(t->data, t->data + t->size);
+    }
+    else {
+        s = stream_chunked(chunked);
+    }
+    if (s == NULL || tokenizer_init(&ts, pconfig) < 0) {
+        return -1;
+    }
+    ts.max_fields = max_fields;
+
+    Py_ssize_t nrows = 0;
+    int ts_result = 0;
+    while (ts_result == 0) {
+        ts_result = tokenize(s, &ts, pconfig);
+        if (ts_result < 0) {
+            nrows = -1;
+            break;
+        }
+        nrows += ts.num_fields != 0;
+    }
+    tokenizer_clear(&ts);
+    stream_close(s);
+    return nrows;
+}
+
+
+static int
+bench_tokenize(const char *name, const text *t, int kind,
+        parser_config *pconfig, size_t max_fields)
+{
+    chunked_buffer cb = {NULL, 0, t->size * kind, kind};
+    if (kind != 0) {
+        cb.data = widen(t, kind);
+    }
+
+    double best = -1, total = 0;
+    Py_ssize_t nrows = 0;
+    for (int run = 0; run < MIN_RUNS || total < MIN_TIME; run++) {
+        double start = now();
+        nrows = tokenize_all(t, kind == 0 ? NULL : &cb, pconfig, max_fields);
+        double seconds = now() - start;
+        if (nrows < 0) {
+            free(cb.data);
+            return -1;
+        }
+        total += seconds;
+        if (best < 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+    free(cb.data);
+    report(name, best, t->size, nrows, "rows");
+    return 0;
+}
+
+
+/*
+ * Convert all fields of `t` (one per line) into an array of `typenum`.
+ */
+static int
+bench_converter(const char *name, set_from_ucs1_function *convert,
+        int typenum, const text *t, parser_config *pconfig)
+{
+    PyArray_Descr *descr = PyArray_DescrFromType(typenum);
+    Py_ssize_t nfields = 0;
+    for (size_t i = 0; i < t->size; i++) {
+        nfields += t->data[i] == '\n';
+    }
+    size_t *ends = malloc(nfields * sizeof(size_t));
+    char *result = malloc(nfields * descr->elsize);
+    if (ends == NULL || result == NULL) {
+        free(ends);
+        free(result);
+        Py_DECREF(descr);
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (size_t i = 0, j = 0; i < t->size; i++) {
+        if (t->data[i] == '\n') {
+            ends[j++] = i;
+        }
+    }
+
+    const Py_UCS1 *data = (const Py_UCS1 *)t->data;
+    double best = -1, total = 0;
+    for (int run = 0; run < MIN_RUNS || total < MIN_TIME; run++) {
+        double start = now();
+        size_t field_start = 0;
+        for (Py_ssize_t i = 0; i < nfields; i++) {
+            if (convert(descr, data + field_start, data + ends[i],
+                        result + i * descr->elsize, pconfig) < 0) {
+                PyErr_Format(PyExc_ValueError,
+                        "%s: could not convert field %zd", name, i);
+                free(ends);
+                free(result);
+                Py_DECREF(descr);
+                return -1;
+            }
+            field_start = ends[i] + 1;
+        }
+        double seconds = now() - start;
+        total += seconds;
+        if (best < 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+    report(name, best, t->size, nfields, "fields");
+    free(ends);
+    free(result);
+    Py_DECREF(descr);
+    return 0;
+}
+
+
+static const parser_config default_parser_config = {
+    .delimiter = ',',
+    .comment = '#',
+    .quote = '"',
+    .imaginary_unit = 'j',
+    .allow_float_for_int = true,
+    .allow_embedded_newline = true,
+    .delimiter_is_whitespace = false,
+    .ignore_leading_whitespace = false,
+    .python_byte_converters = false,
+    .c_byte_converters = false,
+};
+
+
+static int
+run(Py_ssize_t nrows)
+{
+    parser_config pconfig = default_parser_config;
+    parser_config ws_config = default_parser_config;
+    ws_config.delimiter_is_whitespace = true;
+    ws_config.ignore_leading_whitespace = true;
+
+    text floats = generate(COLUMNS_FLOAT, nrows, 5, ",");
+    text floats_wide = generate(COLUMNS_FLOAT, nrows / 10, 50, ",");
+    text ints = generate(COLUMNS_INT, nrows, 50, ",");
+    text mixed = generate(COLUMNS_MIXED, nrows, 22, ",");
+    text quoted = generate(COLUMNS_QUOTED, nrows, 10, ",");
+    text spaced = generate(COLUMNS_FLOAT, nrows, 5, "  ");
+    text float_fields = generate(COLUMNS_FLOAT, nrows * 5, 1, "");
+    text int_fields = generate(COLUMNS_INT, nrows * 5, 1, "");
+    text id_fields = generate(COLUMNS_ID, nrows * 5, 1, "");
+
+    printf("tokenize (%zd rows):\n", nrows);
+    int res = (
+        bench_tokenize("  float 5 columns, memory", &floats, 0, &pconfig,
+                SIZE_MAX) < 0 ||
+        bench_tokenize("  float 50 columns, memory", &floats_wide, 0,
+                &pconfig, SIZE_MAX) < 0 ||
+        bench_tokenize("  float 50 columns, usecols up to 2, memory",
+                &floats_wide, 0, &pconfig, 2) < 0 ||
+        bench_tokenize("  int 50 columns, memory", &ints, 0, &pconfig,
+                SIZE_MAX) < 0 ||
+        bench_tokenize("  mixed 22 columns, memory", &mixed, 0, &pconfig,
+                SIZE_MAX) < 0 ||
+        bench_tokenize("  quoted 10 columns, memory", &quoted, 0, &pconfig,
+                SIZE_MAX) < 0 ||
+        bench_tokenize("  float 5 columns, whitespace, memory", &spaced, 0,
+                &ws_config, SIZE_MAX) < 0 ||
+        bench_tokenize("  float 5 columns, UCS1 chunks", &floats,
+                PyUnicode_1BYTE_KIND, &pconfig, SIZE_MAX) < 0 ||
+        bench_tokenize("  float 5 columns, UCS2 chunks", &floats,
+                PyUnicode_2BYTE_KIND, &pconfig, SIZE_MAX) < 0 ||
+        bench_tokenize("  float 5 columns, UCS4 chunks", &floats,
+                PyUnicode_4BYTE_KIND, &pconfig, SIZE_MAX) < 0 ||
+        bench_tokenize("  mixed 22 columns, UCS4 chunks", &mixed,
+                PyUnicode_4BYTE_KIND, &pconfig, SIZE_MAX) < 0);
+
+    if (res == 0) {
+        printf("converters (%zd fields):\n", nrows * 5);
+        res = (
+            bench_converter("  to_double", &to_double_Py_UCS1, NPY_DOUBLE,
+                    &float_fields, &pconfig) < 0 ||
+            bench_converter("  to_float", &to_float_Py_UCS1, NPY_FLOAT,
+                    &float_fields, &pconfig) < 0 ||
+            bench_converter("  to_int64", &to_int64_Py_UCS1, NPY_INT64,
+                    &int_fields, &pconfig) < 0 ||
+            bench_converter("  to_int32", &to_int32_Py_UCS1, NPY_INT32,
+                    &int_fields, &pconfig) < 0 ||
+            bench_converter("  to_int64, large integers", &to_int64_Py_UCS1,
+                    NPY_INT64, &id_fields, &pconfig) < 0);
+    }
+
+    free(floats.data);
+    free(floats_wide.data);
+    free(ints.data);
+    free(mixed.data);
+    free(quoted.data);
+    free(spaced.data);
+    free(float_fields.data);
+    free(int_fields.data);
+    free(id_fields.data);
+    return res ? -1 : 0;
+}
+
+
+int
+main(int argc, char **argv)
+{
+    Py_ssize_t nrows = 100000;
+    if (argc > 1) {
+        nrows = atol(argv[1]);
+    }
+    if (nrows < 10) {
+        fprintf(stderr, "usage: %s [nrows]\n", argv[0]);
+        return 2;
+    }
+
+    Py_Initialize();
+    /* Imports the NumPy C-API and initializes the parsers */
+    PyObject *mod = PyInit__readtextmodule();
+    int res = mod == NULL ? -1 : run(nrows);
+    Py_XDECREF(mod);
+    if (res < 0) {
+        if (PyErr_Occurred()) {
+            PyErr_Print();
+        }
+        else {
+            fprintf(stderr, "benchmark failed\n");
+        }
+    }
+    if (Py_FinalizeEx() < 0) {
+        res = -1;
+    }
+    return res < 0;
+}
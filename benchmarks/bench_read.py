@@ -0,0 +1,119 @@
+"""
+Benchmarks of `npreadtext.read` for different data shapes and sources.
+
+The source is the file name (read natively by the C reader), the file read
+through a Python file object in chunks, or a list of lines.  The tokenizer
+and the converters are benchmarked in isolation by `bench/microbench.c`.
+"""
+import numpy as np
+
+from npreadtext import read
+
+from .common import ReadBenchmark, compressed, dataset
+
+
+SOURCES = ["path", "file", "lines"]
+
+
+class _SourceBenchmark(ReadBenchmark):
+    def setup_source(self, source, fname, nrows, **kwargs):
+        self.fname = fname
+        self.nrows = nrows
+        self.kwargs = kwargs
+        self.encoding = "utf-8"
+        if source == "path":
+            self.source = fname
+        elif source == "file":
+            # The C reader does not decode "utf-8-sig" itself, so that the
+            # file is opened and read by Python (there is no BOM).
+            self.source = fname
+            self.encoding = "utf-8-sig"
+        else:
+            with open(fname, encoding="utf-8") as f:
+                self.source = f.readlines()
+
+    def read(self):
+        return read(self.source, encoding=self.encoding, **self.kwargs)
+
+
+class Numeric(_SourceBenchmark):
+    params = [["float64", "int64"],
+              ["10000x5", "100000x5", "10000x50"],
+              SOURCES]
+    param_names = ["dtype", "shape", "source"]
+
+    def setup(self, dtype, shape, source):
+        nrows, ncols = map(int, shape.split("x"))
+        kind = "float" if dtype == "float64" else "int"
+        self.setup_source(source, dataset(kind, nrows, ncols), nrows,
+                          dtype=dtype)
+
+
+class Mixed(_SourceBenchmark):
+    # The text columns are ASCII, or need the UCS2 or UCS4 unicode kind
+    params = [["ascii", "ucs2", "ucs4"], [10000, 100000], SOURCES]
+    param_names = ["text", "nrows", "source"]
+
+    def setup(self, text, nrows, source):
+        dtype = np.dtype(",".join(["i4"] * 10 + ["U8"] * 4 + ["f8"] * 8))
+        self.setup_source(source, dataset(text, nrows), nrows, dtype=dtype)
+
+
+class Quoted(_SourceBenchmark):
+    params = [[10000, 100000], SOURCES]
+    param_names = ["nrows", "source"]
+
+    def setup(self, nrows, source):
+        dtype = np.dtype("i8,U16,f8")
+        self.setup_source(source, dataset("quoted", nrows), nrows,
+                          dtype=dtype)
+
+
+class Usecols(_SourceBenchmark):
+    params = [["all", "first", "last", "first_and_last"], SOURCES]
+    param_names = ["usecols", "source"]
+
+    def setup(self, usecols, source):
+        nrows, ncols = 10000, 50
+        usecols = {"all": None, "first": [0], "last": [ncols - 1],
+                   "first_and_last": [0, ncols - 1]}[usecols]
+        self.setup_source(source, dataset("float", nrows, ncols), nrows,
+                          usecols=usecols)
+
+
+class Whitespace(_SourceBenchmark):
+    params = [[10000, 100000], SOURCES]
+    param_names = ["nrows", "source"]
+
+    def setup(self, nrows, source):
+        self.setup_source(source, dataset("whitespace", nrows, 5), nrows,
+                          delimiter=None)
+
+
+class Compressed(ReadBenchmark):
+    # Decompressed natively (on a helper thread) or by a Python file object,
+    # the throughput is relative to the decompressed size.
+    params = [[".gz", ".bz2", ".xz"], ["path", "file"]]
+    param_names = ["compression", "source"]
+
+    def setup(self, compression, source):
+        self.nrows = 100000
+        self.fname = dataset("float", self.nrows, 5)
+        self.cname = compressed(self.fname, compression)
+        self.source = source
+
+    def read(self):
+        if self.source == "path":
+            return read(self.cname, encoding="utf-8")
+        with np.lib._datasource.open(self.cname, "rt", encoding="utf-8") as f:
+            return read(f, encoding="utf-8")
+
+
+class Threads(_SourceBenchmark):
+    params = [[1, 2, 4]]
+    param_names = ["num_threads"]
+
+    def setup(self, num_threads):
+        nrows = 100000
+        self.setup_source("path", dataset("float", nrows, 5), nrows,
+                          num_threads=num_threads)
@@ -0,0 +1,143 @@
+"""
+Datasets for the benchmarks and helpers to report the throughput.
+
+Datasets are generated on first use (with a fixed seed) and cached in the
+temporary directory, so that they are shared by all benchmark processes.
+"""
+import os
+import tempfile
+import time
+
+import numpy as np
+
+
+DATA_DIR = os.path.join(tempfile.gettempdir(), "npreadtext-benchmark-data")
+
+# Strings for text columns, the UCS2 and UCS4 ones force the wider kinds
+WORDS = {
+    "ascii": ["abc", "def", "ghi", "apple", "orange"],
+    "ucs2": ["abc", "def", "αβγ", "äpfel", "orange"],
+    "ucs4": ["abc", "def", "αβγ", "äpfel", "\U0001F34A"],
+}
+
+
+def _float_rows(rng, nrows, ncols):
+    values = rng.random((nrows, ncols))
+    return [",".join(map(repr, row)) for row in values.tolist()]
+
+
+def _int_rows(rng, nrows, ncols):
+    values = rng.integers(-100_000, 100_000, size=(nrows, ncols))
+    return [",".join(map(str, row)) for row in values.tolist()]
+
+
+def _mixed_rows(rng, nrows, words):
+    # Same layout as `npreadtext/tests/generate_big_mixed.py`
+    ints = rng.integers(1, 1000, size=(nrows, 10)).tolist()
+    strs = rng.choice(words, size=(nrows, 4)).tolist()
+    floats = (rng.integers(0, 100, size=(nrows, 8)) / 8).tolist()
+    return [",".join(map(str, i + s + f))
+            for i, s, f in zip(ints, strs, floats)]
+
+
+def _quoted_rows(rng, nrows):
+    # Quoted fields with delimiters, escaped quotes and some newlines
+    words = np.array(WORDS["ascii"])
+    first = rng.choice(words, size=nrows)
+    second = rng.choice(words, size=nrows)
+    sep = rng.choice([", ", '""', "\n"], size=nrows, p=[0.5, 0.49, 0.01])
+    values = rng.random(nrows).tolist()
+    return [f'{k},"{a}{s}{b}",{v!r}'
+            for k, a, s, b, v in zip(range(nrows), first, sep, second, values)]
+
+
+def _whitespace_rows(rng, nrows, ncols):
+    values = rng.random((nrows, ncols)).round(6)
+    return ["  ".join(map(repr, row)) + " " for row in values.tolist()]
+
+
+def _generate(kind, nrows, ncols, rng):
+    if kind == "float":
+        return _float_rows(rng, nrows, ncols)
+    elif kind == "int":
+        return _int_rows(rng, nrows, ncols)
+    elif kind in WORDS:
+        return _mixed_rows(rng, nrows, WORDS[kind])
+    elif kind == "quoted":
+        return _quoted_rows(rng, nrows)
+    elif kind == "whitespace":
+        return _whitespace_rows(rng, nrows, ncols)
+    raise ValueError(f"unknown dataset kind {kind!r}")
+
+
+def dataset(kind, nrows, ncols=None):
+    """
+    Return the path of the dataset, generating it if necessary.  `kind` is
+    one of "float", "int", "ascii"/"ucs2"/"ucs4" (mixed columns with text
+    of that width), "quoted" or "whitespace".
+    """
+    name = f"{kind}_{nrows}" + ("" if ncols is None else f"x{ncols}")
+    fname = os.path.join(DATA_DIR, name + ".csv")
+    if not os.path.exists(fname):
+        os.makedirs(DATA_DIR, exist_ok=True)
+        rng = np.random.default_rng(12345)
+        rows = _generate(kind, nrows, ncols, rng)
+        tmpname = f"{fname}.{os.getpid()}.tmp"
+        with open(tmpname, "w", encoding="utf-8", newline="\n") as f:
+            f.write("\n".join(rows) + "\n")
+        os.replace(tmpname, fname)
+    return fname
+
+
+def compressed(fname, ext):
+    """
+    Return the path of a copy of the dataset `fname` compressed according to
+    `ext` (".gz", ".bz2" or ".xz"), creating it if necessary.
+    """
+    import bz2
+    import gzip
+    import lzma
+
+    open_compressed = {".gz": gzip.open, ".bz2": bz2.open, ".xz": lzma.open}
+    cname = fname + ext
+    if not os.path.exists(cname):
+        tmpname = f"{cname}.{os.getpid()}.tmp"
+        with open(fname, "rb") as src, open_compressed[ext](tmpname, "wb") as f:
+            f.write(src.read())
+        os.replace(tmpname, cname)
+    return cname
+
+
+def best_time(func, repeat=3):
+    """The best time of `repeat` calls of `func`."""
+    best = float("inf")
+    for _ in range(repeat):
+        start = time.perf_counter()
+        func()
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+class ReadBenchmark:
+    """
+    Base class timing `self.read()` on `self.fname`, which must be set up
+    along with `self.nrows` by `setup`.  Besides the time, the throughput is
+    tracked in MB/s (of the file) and rows/s.
+    """
+    timeout = 300
+
+    def read(self):
+        raise NotImplementedError
+
+    def time_read(self, *params):
+        self.read()
+
+    def track_throughput(self, *params):
+        return os.path.getsize(self.fname) / best_time(self.read) / 1e6
+
+    track_throughput.unit = "MB/s"
+
+    def track_rows_per_second(self, *params):
+        return self.nrows / best_time(self.read)
+
+    track_rows_per_second.unit = "rows/s"
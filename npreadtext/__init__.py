@@ -1,4 +1,6 @@
-from ._readers import read
+from ._readers import (
+        read, read_many, read_arrow, ArrowBatch, Reader, RowIndex,
+        build_row_index, trim_buffers)
 from ._loadtxt import _loadtxt
 
 __version__ = "0.0.1.dev1"
@@ -1,9 +1,15 @@
 
+import io
 import os
+import json
+import codecs
+import locale
 import operator
 import contextlib
 import numpy as np
-from ._readtextmodule import _readtext_from_file_object
+from ._readtextmodule import (
+        _readtext_from_file_object, _build_row_index, _readtext_many,
+        _arrow_export, _trim_buffers, TextReader, _native_compressions)
 
 
 def _check_nonneg_int(value, name="argument"):
@@ -33,97 +39,231 @@ def _preprocess_comments(iterable, comments, encoding):
         yield line
 
 
+# Multiple or multi-character comments are handled by the C tokenizer if
+# they start with the same character (see `MAX_COMMENTS` and
+# `MAX_COMMENT_LENGTH` in `parser_config.h`), otherwise they are stripped
+# in Python.
+_MAX_COMMENTS = 4
+_MAX_COMMENT_LENGTH = 32
+
+
+def _native_comments(comments, delimiter, quote):
+    """Whether the C tokenizer can handle the comments itself."""
+    if not 1 <= len(comments) <= _MAX_COMMENTS:
+        return False
+    for c in comments:
+        if (not isinstance(c, str) or not 1 <= len(c) <= _MAX_COMMENT_LENGTH
+                or "\r" in c or "\n" in c):
+            return False
+    first = comments[0][0]
+    if any(c[0] != first for c in comments):
+        return False
+    return first != delimiter and first != quote
+
+
 # The number of rows we read in one go if confronted with a parametric dtype
 _CHUNK_SIZE = 50000
 
+# The initial size of an `out_file` and the largest step it is grown by
+_MEMMAP_MIN_BYTES = 1 << 26
+_MEMMAP_MAX_GROW_BYTES = 1 << 32
 
-def read(fname, *, delimiter=',', comment='#', quote='"', imaginary_unit='j',
-         usecols=None, skiprows=0,
-         max_rows=None, converters=None, ndmin=None, unpack=False,
-         dtype=np.float64, encoding="bytes"):
-    r"""
-    Read a NumPy array from a text file.
+# Encodings (as normalized by `codecs`) for which the C reader can read the
+# file bytes directly, bypassing the Python file object.
+_NATIVE_ENCODINGS = {"utf-8", "ascii", "iso8859-1"}
+# File extensions which `np.lib._datasource.open` decompresses, and the
+# compression the C reader uses for them (if it was built with it).
+_COMPRESSED_EXTENSIONS = {
+    ".gz": "gzip", ".bz2": "bz2", ".xz": "xz", ".lzma": "xz"}
 
-    Parameters
-    ----------
-    fname : str or file object
-        The filename or the file to be read.
-    delimiter : str, optional
-        Field delimiter of the fields in line of the file.
-        Default is a comma, ','.
-    comment : str or sequence of str, optional
-        Character that begins a comment.  All text from the comment
-        character to the end of the line is ignored.
-        Multiple comments or multiple-character comment strings are supported,
-        but may be slower and `quote` must be empty if used.
-    quote : str, optional
-        Character that is used to quote string fields. Default is '"'
-        (a double quote).
-    imaginary_unit : str, optional
-        Character that represent the imaginay unit `sqrt(-1)`.
-        Default is 'j'.
-    usecols : array_like, optional
-        A one-dimensional array of integer column numbers.  These are the
-        columns from the file to be included in the array.  If this value
-        is not given, all the columns are used.
-    skiprows : int, optional
-        Number of lines to skip before interpreting the data in the file.
-    max_rows : int, optional
-        Maximum number of rows of data to read.  Default is to read the
-        entire file.
-    converters : dict, optional
-        A dictionary mapping column number to a function that will parse the
-        column string into the desired value. E.g. if column 0 is a date
-        string: ``converters = {0: datestr2num}``. Converters can also be used
-        to provide a default value for missing data, e.g.
-        ``converters = {3: lambda s: float(s.strip() or 0)}``.
-        Default: None
-    ndmin : int, optional
-        Minimum dimension of the array returned.
-        Allowed values are 0, 1 or 2.  Default is 0.
-    unpack : bool, optional
-        If True, the returned array is transposed, so that arguments may be
-        unpacked using ``x, y, z = read(...)``.  When used with a structured
-        data-type, arrays are returned for each field.  Default is False.
-    dtype : numpy data type
-        A NumPy dtype instance, can be a structured dtype to map to the
-        columns of the file.
-    encoding : str, optional
-        Encoding used to decode the inputfile. The special value 'bytes'
-        (the default) enables backwards-compatible behavior for `converters`,
-        ensuring that inputs to the converter functions are encoded
-        bytes objects. The special value 'bytes' has no additional effect if
-        ``converters=None``. If encoding is ``'bytes'`` or ``None``, the
-        default system encoding is used.
 
-    Returns
-    -------
-    ndarray
-        NumPy array.
+def _native_file(fname, encoding):
+    """
+    Return the normalized encoding and the compression (or None) if `fname`
+    is a local file which the C reader can open, decompress and decode
+    itself; otherwise None.
+    """
+    compression = None
+    ext = os.path.splitext(fname)[1]
+    if ext in _COMPRESSED_EXTENSIONS:
+        compression = _COMPRESSED_EXTENSIONS[ext]
+        if compression not in _native_compressions:
+            return None
+    if not os.path.isfile(fname):
+        return None
+    encoding = _native_encoding(encoding)
+    if encoding is None:
+        return None
+    return encoding, compression
 
-    Examples
-    --------
-    First we create a file for the example.
 
-    >>> s1 = '1.0,2.0,3.0\n4.0,5.0,6.0\n'
-    >>> with open('example1.csv', 'w') as f:
-    ...     f.write(s1)
-    >>> a1 = read_from_filename('example1.csv')
-    >>> a1
-    array([[1., 2., 3.],
-           [4., 5., 6.]])
+def _native_encoding(encoding):
+    """
+    Return the normalized `encoding` if the C reader can decode it itself,
+    otherwise None.
+    """
+    if encoding is None:
+        # The same default that opening the file in text mode uses
+        encoding = locale.getpreferredencoding(False)
+    try:
+        encoding = codecs.lookup(encoding).name
+    except LookupError:
+        return None  # The Python file object will raise the error
+    if encoding not in _NATIVE_ENCODINGS:
+        return None
+    return encoding
 
-    The second example has columns with different data types, so a
-    one-dimensional array with a structured data type is returned.
-    The tab character is used as the field delimiter.
 
-    >>> s2 = '1.0\t10\talpha\n2.3\t25\tbeta\n4.5\t16\tgamma\n'
-    >>> with open('example2.tsv', 'w') as f:
-    ...     f.write(s2)
-    >>> a2 = read_from_filename('example2.tsv', delimiter='\t')
-    >>> a2
-    array([(1. , 10, b'alpha'), (2.3, 25, b'beta'), (4.5, 16, b'gamma')],
-          dtype=[('f0', '<f8'), ('f1', 'u1'), ('f2', 'S5')])
+def _is_binary_file(obj):
+    """Whether `obj` is a binary file object supporting `readinto`."""
+    return (not isinstance(obj, io.TextIOBase)
+            and callable(getattr(obj, "readinto", None)))
+
+
+def _column_major_possible(dtype):
+    """
+    Whether the C reader can store the result of `dtype` column by column
+    (it must not contain objects, be flexible or have nested fields).
+    """
+    if dtype.hasobject or dtype.itemsize == 0 or dtype.shape != ():
+        return False
+    if dtype.names is None:
+        return True
+    return all(dtype[name].names is None and dtype[name].shape == ()
+               for name in dtype.names)
+
+
+def _column_major_result(arr, dtype):
+    """
+    Swap the (natively converted) column-major result to the byte order of
+    `dtype`.  The fields of a structured result are returned as a dict.
+    """
+    if dtype.names is None:
+        if not dtype.isnative:
+            arr = arr.byteswap(inplace=True).view(dtype)
+        return arr
+    fields = {}
+    for name, field in zip(dtype.names, arr):
+        if not dtype[name].isnative:
+            field = field.byteswap(inplace=True).view(dtype[name])
+        fields[name] = field
+    return fields
+
+
+def _fill_categories(categories, categorical):
+    """
+    Add empty categories for the `categorical` columns which the C reader
+    did not report (because no row was read).
+    """
+    empty = np.array([], dtype="U1")
+    return {col: categories.get(col, empty) for col in categorical}
+
+
+def _missing_sentinels(values):
+    if values is None:
+        return ()
+    if isinstance(values, (str, bytes)):
+        values = [values]
+    return tuple((v.decode("latin1") if isinstance(v, bytes) else str(v)).strip()
+                 for v in values)
+
+
+def _normalize_missing(missing_values, filling_values):
+    """
+    Returns the dictionary mapping columns (None for all columns) to the
+    tuple ``(sentinels, fill)`` for the C reader.  The sentinels of a column
+    include those given for all columns.
+    """
+    sentinels, column_sentinels = (), {}
+    if isinstance(missing_values, dict):
+        for col, values in missing_values.items():
+            if col is None:
+                sentinels = _missing_sentinels(values)
+            else:
+                column_sentinels[col] = _missing_sentinels(values)
+    else:
+        sentinels = _missing_sentinels(missing_values)
+
+    fill, column_fills = None, {}
+    if isinstance(filling_values, dict):
+        column_fills = dict(filling_values)
+        fill = column_fills.pop(None, None)
+    else:
+        fill = filling_values
+
+    missing = {None: (sentinels, fill)}
+    for col in {**column_sentinels, **column_fills}:
+        missing[col] = (sentinels + column_sentinels.get(col, ()),
+                        column_fills.get(col, fill))
+    return missing
+
+
+def _missing_mask(arr, positions):
+    """
+    Create the mask of `arr` from the ``(rows, fields)`` positions of the
+    missing fields reported by the C reader.
+    """
+    rows, fields = positions
+    if arr.dtype.names is None:
+        mask = np.zeros(arr.shape, dtype=bool)
+        mask[rows, fields] = True
+        return mask
+    mask = np.zeros(arr.shape, dtype=np.ma.make_mask_descr(arr.dtype))
+    for i, name in enumerate(arr.dtype.names):
+        mask[name][rows[fields == i]] = True
+    return mask
+
+
+def _read_into_file(reader, filename, dtype, max_rows):
+    """
+    Read the rows into the file `filename`, which is grown as needed and
+    remapped (the rows read are not copied), and return it as a memmap.
+    """
+    # The first row gives the number of columns of a homogeneous result
+    first = reader.read_batch(min(max_rows, 1) if max_rows >= 0 else 1)
+    row_shape = first.shape[1:]
+    row_size = dtype.itemsize * int(np.prod(row_shape))
+    if len(first) == 0 or row_size == 0:
+        return first  # an empty file cannot be mapped
+
+    num_rows = 1
+    capacity = max(_MEMMAP_MIN_BYTES // row_size, 1)
+    with open(filename, "w+b") as f:
+        while True:
+            # Growing the file does not touch the rows already written
+            f.truncate(capacity * row_size)
+            mm = np.memmap(f, dtype=dtype, mode="r+",
+                           shape=(capacity,) + row_shape)
+            if first is not None:
+                mm[0] = first[0]
+                first = None
+            want = capacity - num_rows
+            if max_rows >= 0:
+                want = min(want, max_rows - num_rows)
+            got = 0
+            if want > 0:
+                got = len(reader.read_batch(
+                        want, out=mm[num_rows:num_rows + want]))
+            num_rows += got
+            mm.flush()
+            del mm  # unmap before resizing
+            if got < want or want == 0:
+                break
+            capacity += min(capacity,
+                            max(_MEMMAP_MAX_GROW_BYTES // row_size, 1))
+        f.truncate(num_rows * row_size)
+    return np.memmap(filename, dtype=dtype, mode="r+",
+                     shape=(num_rows,) + row_shape)
+
+
+def _normalize_args(*, delimiter, comment, quote, imaginary_unit, usecols,
+                    skiprows, converters, batch_converters, dtype, encoding):
+    """
+    Validate and normalize the arguments shared by `read` and `Reader`.
+
+    Returns the keyword arguments for the C reader (without the file), the
+    multiple or multi-character comments which are stripped in Python (or
+    None), and the flexible dtype the result has to be cast to (or None).
     """
     # Handle special 'bytes' keyword for encoding
     byte_converters = False
@@ -138,11 +278,13 @@ def read(fname, *, delimiter=',', comment='#', quote='"', imaginary_unit='j',
     read_dtype_via_object_chunks = None
     if dtype.kind in 'SUM' and (
             dtype == "S0" or dtype == "U0" or  dtype == "M8" or dtype == 'm8'):
-        # This is a legacy "flexible" dtype.  We do not truly support
-        # parametric dtypes currently (no dtype discovery step in the core),
-        # but have to support these for backward compatibility.
-        read_dtype_via_object_chunks = dtype
-        dtype = np.dtype(object)
+        # This is a legacy "flexible" dtype.  The C reader discovers the
+        # string length itself, but the datetime unit (and the result of
+        # Python converters) is discovered by casting object arrays.
+        if dtype.kind not in "SU" or not (
+                converters is None or converters == {}):
+            read_dtype_via_object_chunks = dtype
+            dtype = np.dtype(object)
 
     if usecols is not None:
         # Allow usecols to be a single int or a sequence of ints
@@ -165,9 +307,6 @@ def read(fname, *, delimiter=',', comment='#', quote='"', imaginary_unit='j',
         usecols = np.array([operator.index(i) for i in usecols_as_list],
                            dtype=np.int32)
 
-    if ndmin not in [None, 0, 1, 2]:
-        raise ValueError(f'ndmin must be None, 0, 1, or 2; got {ndmin}')
-
     if not isinstance(comment, str):
         # assume comments are a sequence of strings
         comments = tuple(comment)
@@ -185,11 +324,12 @@ def read(fname, *, delimiter=',', comment='#', quote='"', imaginary_unit='j',
         comments = None
 
     # comment is now either a 1 or 0 character string or a tuple:
-    if comments is not None:
+    if comments is not None and _native_comments(comments, delimiter, quote):
+        # The tokenizer handles them (also within quotes)
+        comment = comments
+        comments = None
+    elif comments is not None:
         assert comment == ''
-        # Note: An earlier version support two character comments (and could
-        #       have been extended to multiple characters, we assume this is
-        #       rare enough to not optimize for.
         if quote != "":
             raise ValueError(
                 "when multiple comments or a multi-character comment is given, "
@@ -203,22 +343,52 @@ def read(fname, *, delimiter=',', comment='#', quote='"', imaginary_unit='j',
         raise ValueError('len(imaginary_unit) must be 1.')
 
     _check_nonneg_int(skiprows)
-    if max_rows is not None:
-        _check_nonneg_int(max_rows)
-    else:
-        # Passing -1 to the C code means "read the entire file".
-        max_rows = -1
 
+    c_kwargs = dict(
+        delimiter=delimiter, comment=comment, quote=quote,
+        imaginary_unit=imaginary_unit, usecols=usecols, skiprows=skiprows,
+        converters=converters, dtype=dtype, encoding=encoding,
+        byte_converters=byte_converters,
+        batch_converters=bool(batch_converters))
+    return c_kwargs, comments, read_dtype_via_object_chunks
+
+
+@contextlib.contextmanager
+def _open_data(fname, encoding, comments):
+    """
+    Context manager opening `fname` (if necessary) for the C reader.  Yields
+    the file related keyword arguments for the C reader.
+    """
     fh_closing_ctx = contextlib.nullcontext()
     filelike = False
+    binary_file = False
+    native_file = False
+    compression = None
     try:
         if isinstance(fname, os.PathLike):
             fname = os.fspath(fname)
         # TODO: loadtxt actually uses `file + ''` to decide this?!
-        if isinstance(fname, str):
-            fh = np.lib._datasource.open(fname, 'rt', encoding=encoding)
-            if encoding is None:
-                encoding = getattr(fh, 'encoding', 'latin1')
+        native = None
+        if isinstance(fname, str) and comments is None:
+            native = _native_file(fname, encoding)
+        if native is not None:
+            # The C reader maps/reads (and decompresses) the file itself
+            data = fname
+            encoding, compression = native
+            native_file = True
+        elif isinstance(fname, str):
+            native_encoding = None
+            if comments is None:
+                native_encoding = _native_encoding(encoding)
+            if native_encoding is not None:
+                # The C reader decodes the bytes read with `readinto`
+                fh = np.lib._datasource.open(fname, 'rb')
+                encoding = native_encoding
+                binary_file = True
+            else:
+                fh = np.lib._datasource.open(fname, 'rt', encoding=encoding)
+                if encoding is None:
+                    encoding = getattr(fh, 'encoding', 'latin1')
 
             fh_closing_ctx = contextlib.closing(fh)
             data = fh
@@ -226,7 +396,15 @@ def read(fname, *, delimiter=',', comment='#', quote='"', imaginary_unit='j',
         else:
             if encoding is None:
                 encoding = getattr(fname, 'encoding', 'latin1')
-            data = iter(fname)
+            native_encoding = None
+            if comments is None and _is_binary_file(fname):
+                native_encoding = _native_encoding(encoding)
+            if native_encoding is not None:
+                data = fname
+                encoding = native_encoding
+                filelike = binary_file = True
+            else:
+                data = iter(fname)
     except TypeError as e:
         raise ValueError(
             f"fname must be a string, filehandle, list of strings,\n"
@@ -239,53 +417,353 @@ def read(fname, *, delimiter=',', comment='#', quote='"', imaginary_unit='j',
                 filelike = False
             data = _preprocess_comments(data, comments, encoding)
 
-        if read_dtype_via_object_chunks is None:
+        yield dict(file=data, encoding=encoding, filelike=filelike,
+                   binary_file=binary_file, native_file=native_file,
+                   compression=compression)
+
+
+def read(fname, *, delimiter=',', comment='#', quote='"', imaginary_unit='j',
+         usecols=None, skiprows=0,
+         max_rows=None, converters=None, batch_converters=False, ndmin=None,
+         unpack=False, dtype=np.float64, encoding="bytes", num_threads=1,
+         categorical=None, order="C", stats=None, out=None, out_offset=0,
+         row_index=None, missing_values=None, filling_values=None,
+         usemask=False, out_file=None):
+    r"""
+    Read a NumPy array from a text file.
+
+    Parameters
+    ----------
+    fname : str or file object
+        The filename or the file to be read.  Local files using a utf-8,
+        ascii or latin1 encoding are read directly by the C reader,
+        bypassing Python's file objects.  This includes gzip, bz2 and xz
+        compressed files (if the libraries were available when building),
+        which are decompressed on a helper thread while parsing.  Binary
+        file objects (e.g. sockets or remote files) with such an encoding
+        are read with ``readinto`` in chunks which grow for fast sources.
+    delimiter : str, optional
+        Field delimiter of the fields in line of the file.
+        Default is a comma, ','.
+    comment : str or sequence of str, optional
+        Character that begins a comment.  All text from the comment
+        character to the end of the line is ignored.
+        Multiple comments or multiple-character comment strings are supported.
+        If they start with the same character (e.g. ``"//"`` or
+        ``["//", "/*"]``) they are handled natively and may be used with
+        quotes, otherwise they are slower and `quote` must be empty.
+    quote : str, optional
+        Character that is used to quote string fields. Default is '"'
+        (a double quote).
+    imaginary_unit : str, optional
+        Character that represent the imaginay unit `sqrt(-1)`.
+        Default is 'j'.
+    usecols : array_like, optional
+        A one-dimensional array of integer column numbers.  These are the
+        columns from the file to be included in the array.  If this value
+        is not given, all the columns are used.
+    skiprows : int, optional
+        Number of lines to skip before interpreting the data in the file.
+    max_rows : int, optional
+        Maximum number of rows of data to read.  Default is to read the
+        entire file.
+    converters : dict, optional
+        A dictionary mapping column number to a function that will parse the
+        column string into the desired value. E.g. if column 0 is a date
+        string: ``converters = {0: datestr2num}``. Converters can also be used
+        to provide a default value for missing data, e.g.
+        ``converters = {3: lambda s: float(s.strip() or 0)}``.
+        Default: None
+    batch_converters : bool, optional
+        If True, each converter is called once for a block of (up to 4096)
+        rows rather than for every field.  It is passed a one-dimensional
+        array of the strings of its column (``S`` holding the latin1 encoded
+        bytes if `encoding` is ``'bytes'``, else ``U``) and must return an
+        array of the same length, which is cast to the dtype of the column.
+        E.g. ``converters={0: np.char.strip}`` with a string dtype.
+        Default is False.
+    ndmin : int, optional
+        Minimum dimension of the array returned.
+        Allowed values are 0, 1 or 2.  Default is 0.
+    unpack : bool, optional
+        If True, the returned array is transposed, so that arguments may be
+        unpacked using ``x, y, z = read(...)``.  When used with a structured
+        data-type, arrays are returned for each field.  Default is False.
+    dtype : numpy data type
+        A NumPy dtype instance, can be a structured dtype to map to the
+        columns of the file.
+    encoding : str, optional
+        Encoding used to decode the inputfile. The special value 'bytes'
+        (the default) enables backwards-compatible behavior for `converters`,
+        ensuring that inputs to the converter functions are encoded
+        bytes objects. The special value 'bytes' has no additional effect if
+        ``converters=None``. If encoding is ``'bytes'`` or ``None``, the
+        default system encoding is used.
+    num_threads : int or None, optional
+        Number of threads used to parse the file.  ``None`` uses one thread
+        per CPU.  Multiple threads are only used for large files read
+        directly by the C reader (see `fname`) which are latin1 encoded or
+        contain only ASCII characters.  The result is always identical to
+        reading with a single thread, but `converters`, `max_rows` and
+        dtypes requiring Python objects disable the parallel reading.
+        Default is 1.
+    categorical : sequence of int, optional
+        Columns (given like the keys of `converters`) to dictionary encode.
+        Each distinct string of such a column is assigned the next integer
+        code when it is first seen and the result stores the code, so the
+        column must have an integer dtype.  The categories are returned
+        in addition to the array and e.g.
+        ``pandas.Categorical.from_codes(arr[:, 1], categories[1])`` restores
+        the column.  Default is None.
+    order : {'C', 'F'}, optional
+        With ``'F'``, each column is stored contiguously while reading:
+        The result is in Fortran order, or for a structured dtype a
+        dictionary mapping the field names to 1-D arrays.  Non-native byte
+        orders are swapped column by column at the end.  `unpack` reads
+        column-major (when possible) without an additional copy.
+        Default is ``'C'``.
+    stats : dict, optional
+        If given, the dictionary is filled with counters describing the
+        read: ``bytes_consumed`` and ``buffer_refills`` of the (decoded)
+        input buffers, ``rows_tokenized``, ``fields_tokenized``,
+        ``field_buffer_regrowths`` and ``fields_regrowths`` of the
+        tokenizer, ``python_converter_calls``, ``output_reallocs`` and
+        ``output_bytes_copied`` of the result, and the timers
+        ``nextbuf_ns``, ``count_rows_ns``, ``tokenize_ns``,
+        ``python_converter_ns``, ``convert_ns`` and ``grow_ns`` in
+        nanoseconds (summed over all threads).  Timing reads the clock a few
+        times per row, so collecting the statistics slows down reading.
+        Default is None.
+    out : ndarray, optional
+        A writeable, C-contiguous array (e.g. a ``np.memmap`` or a view of
+        shared memory) with the dtype of the result to store the rows in
+        place.  It must be 2-D with the number of columns read, or 1-D for a
+        structured dtype.  At most as many rows as fit are read and
+        the view of the rows which were filled in is returned.  Cannot be
+        used with `categorical`, ``order='F'`` or dtypes which are read via
+        Python objects (e.g. datetimes without a unit).  Default is None.
+    out_offset : int, optional
+        The row of `out` at which to store the first row read, e.g. to fill
+        one array from several files.  Default is 0.
+    row_index : RowIndex, optional
+        The index of `fname` created by `build_row_index` with the same
+        `delimiter`, `comment` and `quote`.  Reading starts directly at
+        row `skiprows` (scanning at most ``row_index.every`` rows), which
+        makes reading a window ``skiprows, max_rows`` of a large file fast.
+        Note that `skiprows` then counts rows: A quoted field containing
+        newlines does not start new rows.  The file may have been appended
+        to since the index was built.  Default is None.
+    missing_values : str, sequence of str or dict, optional
+        Strings which mark a missing field (compared ignoring surrounding
+        whitespace), or a dictionary mapping columns (given like the keys of
+        `converters`, None for all columns) to them.  The strings of all
+        columns also apply to the columns given.  If any of
+        `missing_values`, `filling_values` or `usemask` is given, empty
+        fields are missing as well and missing fields are stored as their
+        fill value instead of being converted (or passed to a converter).
+        Missing values are read by a single thread.  Default is None.
+    filling_values : scalar or dict, optional
+        The value stored for missing fields, or a dictionary mapping
+        columns (None for all columns) to it.  By default NaN for floating
+        point and complex, NaT for datetime, 0 for other numbers and an
+        empty string for strings.  Default is None.
+    usemask : bool, optional
+        If True, a ``np.ma.MaskedArray`` is returned in which the missing
+        fields are masked.  Cannot be used with `unpack`, ``order='F'``,
+        `out` or nested structured dtypes.  Default is False.
+    out_file : str or path-like, optional
+        A file (created or overwritten) to store the result in, which is
+        returned as a ``np.memmap``.  The file is grown as rows are read and
+        truncated to the rows read at the end, so the file read may be
+        larger than the memory.  An empty result is returned as a normal
+        array (and the file is not created).  Cannot be used with `out`,
+        `usemask`, `row_index`, ``order='F'``, string dtypes without a
+        length (``"U"`` or ``"S"``) or dtypes which are read via Python
+        objects.  Default is None.
+
+    Returns
+    -------
+    ndarray, MaskedArray or dict
+        NumPy array (or a dictionary of arrays, see `order`, or a masked
+        array, see `usemask`).
+    categories : dict
+        Only if `categorical` is given: The unicode array of the categories
+        of each categorical column, indexed by the codes.
+
+    Examples
+    --------
+    First we create a file for the example.
+
+    >>> s1 = '1.0,2.0,3.0\n4.0,5.0,6.0\n'
+    >>> with open('example1.csv', 'w') as f:
+    ...     f.write(s1)
+    >>> a1 = read_from_filename('example1.csv')
+    >>> a1
+    array([[1., 2., 3.],
+           [4., 5., 6.]])
+
+    The second example has columns with different data types, so a
+    one-dimensional array with a structured data type is returned.
+    The tab character is used as the field delimiter.
+
+    >>> s2 = '1.0\t10\talpha\n2.3\t25\tbeta\n4.5\t16\tgamma\n'
+    >>> with open('example2.tsv', 'w') as f:
+    ...     f.write(s2)
+    >>> a2 = read_from_filename('example2.tsv', delimiter='\t')
+    >>> a2
+    array([(1. , 10, b'alpha'), (2.3, 25, b'beta'), (4.5, 16, b'gamma')],
+          dtype=[('f0', '<f8'), ('f1', 'u1'), ('f2', 'S5')])
+    """
+    c_kwargs, comments, read_dtype_via_object_chunks = _normalize_args(
+            delimiter=delimiter, comment=comment, quote=quote,
+            imaginary_unit=imaginary_unit, usecols=usecols,
+            skiprows=skiprows, converters=converters,
+            batch_converters=batch_converters, dtype=dtype,
+            encoding=encoding)
+
+    if ndmin not in [None, 0, 1, 2]:
+        raise ValueError(f'ndmin must be None, 0, 1, or 2; got {ndmin}')
+
+    if num_threads is None:
+        num_threads = os.cpu_count() or 1
+    else:
+        _check_nonneg_int(num_threads, "num_threads")
+        num_threads = max(num_threads, 1)
+
+    if max_rows is not None:
+        _check_nonneg_int(max_rows)
+    else:
+        # Passing -1 to the C code means "read the entire file".
+        max_rows = -1
+
+    if categorical is not None:
+        categorical = tuple(categorical)
+    if order not in ("C", "F"):
+        raise ValueError(f"order must be 'C' or 'F'; got {order!r}")
+    missing = None
+    if (missing_values is not None or filling_values is not None
+            or usemask):
+        if batch_converters or read_dtype_via_object_chunks is not None:
+            raise ValueError(
+                "missing values cannot be used with batch_converters or a "
+                f"dtype which is read via Python objects (dtype={dtype!r}).")
+        if usemask and (unpack or order == "F" or out is not None):
+            raise ValueError(
+                "usemask cannot be used with unpack, order='F' or out.")
+        if usemask and c_kwargs["dtype"].names is not None and any(
+                c_kwargs["dtype"][name].names is not None
+                or c_kwargs["dtype"][name].shape != ()
+                for name in c_kwargs["dtype"].names):
+            raise ValueError(
+                "usemask cannot be used with nested structured dtypes.")
+        missing = _normalize_missing(missing_values, filling_values)
+    if out_file is not None and (
+            out is not None or usemask or row_index is not None
+            or order == "F" or read_dtype_via_object_chunks is not None
+            or c_kwargs["dtype"].itemsize == 0):
+        # A discovered string length may still grow after the file is mapped
+        raise ValueError(
+            "out_file cannot be used with out, usemask, row_index, "
+            "order='F', a string dtype without a length or a dtype which "
+            f"is read via Python objects (dtype={dtype!r}).")
+    if row_index is not None:
+        if (categorical is not None or missing is not None
+                or read_dtype_via_object_chunks is not None):
+            raise ValueError(
+                "row_index cannot be used with categorical, missing values "
+                "or a dtype which is read via Python objects "
+                f"(dtype={dtype!r}).")
+        row_index._check_settings(c_kwargs)
+        c_kwargs["row_index"] = row_index.offsets
+        c_kwargs["row_index_every"] = row_index.every
+    if out is not None:
+        _check_nonneg_int(out_offset, "out_offset")
+        if (categorical is not None or order == "F"
+                or read_dtype_via_object_chunks is not None):
+            raise ValueError(
+                "out cannot be used with categorical, order='F' or a dtype "
+                f"which is read via Python objects (dtype={dtype!r}).")
+    dtype = c_kwargs["dtype"]
+    column_major = ((order == "F" or unpack) and categorical is None
+                    and missing is None and out is None
+                    and out_file is None
+                    and read_dtype_via_object_chunks is None
+                    and _column_major_possible(dtype))
+    if column_major:
+        # Converted in native byte order, swapped in bulk at the end
+        c_kwargs["dtype"] = dtype.newbyteorder("=")
+
+    with _open_data(fname, c_kwargs["encoding"], comments) as file_kwargs:
+        c_kwargs.update(file_kwargs)
+        if (categorical is not None or missing is not None
+                or out_file is not None):
+            # The category tables and missing values live in the reader
+            # state, which also allows reading into the file in steps.
+            reader = TextReader(**c_kwargs, categorical=categorical,
+                                missing=missing, record_missing=usemask,
+                                stats=stats is not None)
+            try:
+                if out_file is not None:
+                    arr = _read_into_file(
+                            reader, out_file, c_kwargs["dtype"], max_rows)
+                elif out is None:
+                    arr = reader.read_batch(max_rows)
+                elif out_offset > len(out):
+                    raise ValueError(
+                        "out_offset must be between 0 and the length of "
+                        f"out ({len(out)}), but is {out_offset}.")
+                else:
+                    arr = reader.read_batch(max_rows, out=out[out_offset:])
+                if categorical is not None:
+                    categories = _fill_categories(
+                            reader.categories, categorical)
+                if usemask:
+                    mask = _missing_mask(arr, reader.missing_positions)
+            finally:
+                reader.close()
+            if stats is not None:
+                stats.update(reader.stats)
+
+        elif read_dtype_via_object_chunks is None:
             arr = _readtext_from_file_object(
-                    data, delimiter=delimiter, comment=comment, quote=quote,
-                    imaginary_unit=imaginary_unit,
-                    usecols=usecols, skiprows=skiprows, max_rows=max_rows,
-                    converters=converters, dtype=dtype,
-                    encoding=encoding, filelike=filelike,
-                    byte_converters=byte_converters)
+                    **c_kwargs, max_rows=max_rows, num_threads=num_threads,
+                    column_major=column_major, stats=stats,
+                    out=out, out_offset=out_offset)
 
         else:
             # This branch reads the file into chunks of object arrays and then
             # casts them to the desired actual dtype.  This ensures correct
-            # string-length and datetime-unit discovery (as for `arr.astype()`).
+            # datetime-unit (or string-length with converters) discovery (as
+            # for `arr.astype()`).
             # Due to chunking, certain error reports are less clear, currently.
-            if filelike:
-                data = iter(data)  # cannot chunk when reading from file
-
-            c_byte_converters = False
             if read_dtype_via_object_chunks == "S":
-                c_byte_converters = True  # Use latin1 rather than ascii
+                c_kwargs["c_byte_converters"] = True  # latin1 rather than ascii
 
-            chunks = []
-            while max_rows != 0:
-                if max_rows < 0:
-                    chunk_size = _CHUNK_SIZE
-                else:
-                    chunk_size = min(_CHUNK_SIZE, max_rows)
-
-                next_arr = _readtext_from_file_object(
-                        data, delimiter=delimiter, comment=comment, quote=quote,
-                        imaginary_unit=imaginary_unit,
-                        usecols=usecols, skiprows=skiprows, max_rows=max_rows,
-                        converters=converters, dtype=dtype,
-                        encoding=encoding, filelike=filelike,
-                        byte_converters=byte_converters,
-                        c_byte_converters=c_byte_converters)
-                # Cast here already.  We hope that this is better even for
-                # large files because the storage is more compact.  It could
-                # be adapted (in principle the concatenate could cast).
-                chunks.append(next_arr.astype(read_dtype_via_object_chunks))
-
-                skiprows = 0  # Only have to skip for first chunk
-                if max_rows >= 0:
-                    max_rows -= chunk_size
-                if len(next_arr) < chunk_size:
-                    # There was less data than requested, so we are done.
-                    break
+            reader = TextReader(**c_kwargs, stats=stats is not None)
+            try:
+                chunks = []
+                while max_rows != 0:
+                    if max_rows < 0:
+                        chunk_size = _CHUNK_SIZE
+                    else:
+                        chunk_size = min(_CHUNK_SIZE, max_rows)
+
+                    next_arr = reader.read_batch(chunk_size)
+                    # Cast here already.  We hope that this is better even for
+                    # large files because the storage is more compact.  It
+                    # could be adapted (in principle the concatenate could
+                    # cast).
+                    chunks.append(next_arr.astype(read_dtype_via_object_chunks))
+
+                    if max_rows >= 0:
+                        max_rows -= chunk_size
+                    if len(next_arr) < chunk_size:
+                        # There was less data than requested, so we are done.
+                        break
+            finally:
+                reader.close()
+            if stats is not None:
+                stats.update(reader.stats)
 
             # Need at least one chunk, but if empty, the last one may have
             # the wrong shape.
@@ -296,6 +774,25 @@ def read(fname, *, delimiter=',', comment='#', quote='"', imaginary_unit='j',
             else:
                 arr = np.concatenate(chunks, axis=0)
 
+    if column_major:
+        arr = _column_major_result(arr, dtype)
+    elif order == "F" and arr.dtype.names is None:
+        arr = np.asfortranarray(arr)
+    elif order == "F":
+        arr = {name: np.ascontiguousarray(arr[name])
+               for name in arr.dtype.names}
+
+    if usemask:
+        arr = np.ma.MaskedArray(arr, mask=mask)
+
+    if isinstance(arr, dict):
+        # The fields of a structured result, ndmin does not apply
+        if unpack:
+            arr = list(arr.values())
+        if categorical is not None:
+            return arr, categories
+        return arr
+
     if ndmin is not None:
         # Handle non-None ndmin like np.loadtxt.  Might change this eventually?
         # Tweak the size and shape of the arrays - remove extraneous dimensions
@@ -316,8 +813,528 @@ def read(fname, *, delimiter=',', comment='#', quote='"', imaginary_unit='j',
         dt = arr.dtype
         if dt.names is not None:
             # For structured arrays, return an array for each field.
-            return [arr[field] for field in dt.names]
+            arr = [arr[field] for field in dt.names]
+        else:
+            arr = arr.T
+    if categorical is not None:
+        return arr, categories
+    return arr
+
+
+def _row_index_settings(c_kwargs):
+    """The parser settings which the offsets of a `RowIndex` depend on."""
+    comment = c_kwargs["comment"]
+    if not isinstance(comment, str):
+        comment = list(comment)
+    return [c_kwargs["delimiter"], comment, c_kwargs["quote"]]
+
+
+class RowIndex:
+    """
+    Byte offsets of every `every`-th row of a file, see `build_row_index`.
+
+    Attributes
+    ----------
+    offsets : ndarray
+        The int64 offsets of rows ``0, every, 2*every, ...``.
+    every : int
+        The number of rows between two offsets.
+    """
+
+    def __init__(self, offsets, every, settings):
+        self.offsets = np.ascontiguousarray(offsets, dtype=np.int64)
+        self.every = operator.index(every)
+        self._settings = settings
+
+    def __len__(self):
+        return len(self.offsets)
+
+    def _check_settings(self, c_kwargs):
+        if _row_index_settings(c_kwargs) != self._settings:
+            delimiter, comment, quote = self._settings
+            raise ValueError(
+                "the row index was built with a different delimiter, comment "
+                f"or quote: delimiter={delimiter!r}, comment={comment!r}, "
+                f"quote={quote!r}.")
+
+    def save(self, fname):
+        """
+        Save the index (e.g. as ``data.csv.index.npz`` next to the file).
+        """
+        np.savez(fname, offsets=self.offsets, every=self.every,
+                 settings=json.dumps(self._settings))
+
+    @classmethod
+    def load(cls, fname):
+        """Load an index stored by `save`."""
+        with np.load(fname) as data:
+            return cls(data["offsets"], int(data["every"]),
+                       json.loads(str(data["settings"])))
+
+
+def build_row_index(fname, *, every=1024, delimiter=',', comment='#',
+                    quote='"', encoding="bytes"):
+    """
+    Build the index of the rows of `fname` for reading windows of it.
+
+    The file is scanned once (without converting it) and the byte offset
+    of every `every`-th row is stored.  Passing the index to `read` as
+    `row_index` skips `skiprows` rows by jumping to the closest offset.
+
+    Parameters
+    ----------
+    fname : str or path-like
+        An uncompressed local file, which the C reader can read natively
+        (see `read`).
+    every : int, optional
+        The number of rows between the offsets, a trade-off between the
+        size of the index and the rows which are scanned to find a row.
+        Default is 1024.
+    delimiter, comment, quote, encoding
+        See `read`, must be the same when reading.  Comments which are
+        stripped in Python are not supported.
+
+    Returns
+    -------
+    RowIndex
+        The index, which can be saved and loaded to reuse it.
+    """
+    c_kwargs, comments, _ = _normalize_args(
+            delimiter=delimiter, comment=comment, quote=quote,
+            imaginary_unit="j", usecols=None, skiprows=0, converters=None,
+            batch_converters=False, dtype=np.float64, encoding=encoding)
+    if comments is not None:
+        raise ValueError(
+            "a row index does not support comments which are stripped in "
+            "Python.")
+    every = operator.index(every)
+    with _open_data(fname, c_kwargs["encoding"], None) as file_kwargs:
+        del file_kwargs["filelike"], file_kwargs["binary_file"]
+        offsets = _build_row_index(
+                **file_kwargs, delimiter=c_kwargs["delimiter"],
+                comment=c_kwargs["comment"], quote=c_kwargs["quote"],
+                every=every)
+    return RowIndex(offsets, every, _row_index_settings(c_kwargs))
+
+
+def read_many(fnames, *, delimiter=',', comment='#', quote='"',
+              imaginary_unit='j', usecols=None, skiprows=0, converters=None,
+              dtype=np.float64, encoding="bytes", num_threads=None):
+    """
+    Read several text files with the same columns into one array.
+
+    The result is identical to concatenating ``read(fname, ...)`` of each
+    file.  The dtype is set up once and, if all files are local files read
+    natively by the C reader (see `read`, compressed files are not), they
+    are parsed in parallel: Each thread parses whole files (reusing its
+    parser state) without holding the GIL and the rows are copied into the
+    result at the end.  Otherwise, or if reading a file fails, the files
+    are read one by one.
+
+    Parameters
+    ----------
+    fnames : sequence of str or path-like
+        The files to read, in the order of their rows in the result.
+    delimiter, comment, quote, imaginary_unit, usecols, converters, dtype, encoding
+        See `read`.  `converters` and dtypes which are read via Python
+        objects disable the parallel reading.
+    skiprows : int, optional
+        Number of lines to skip at the start of each file (e.g. a header).
+    num_threads : int or None, optional
+        The maximum number of threads, ``None`` uses one per CPU.
+        Default is None.
+
+    Returns
+    -------
+    ndarray
+        The rows of all files.
+    """
+    fnames = [os.fspath(f) if isinstance(f, os.PathLike) else f
+              for f in fnames]
+    if not fnames:
+        raise ValueError("fnames must contain at least one file.")
+    c_kwargs, comments, read_dtype_via_object_chunks = _normalize_args(
+            delimiter=delimiter, comment=comment, quote=quote,
+            imaginary_unit=imaginary_unit, usecols=usecols,
+            skiprows=skiprows, converters=converters,
+            batch_converters=False, dtype=dtype, encoding=encoding)
+    if num_threads is None:
+        num_threads = os.cpu_count() or 1
+    else:
+        _check_nonneg_int(num_threads, "num_threads")
+        num_threads = max(num_threads, 1)
+
+    arr = None
+    if (comments is None and read_dtype_via_object_chunks is None
+            and not converters
+            and all(isinstance(fname, str) for fname in fnames)):
+        natives = {_native_file(fname, c_kwargs["encoding"])
+                   for fname in fnames}
+        native = natives.pop() if len(natives) == 1 else None
+        if native is not None and native[1] is None:
+            arr = _readtext_many(
+                    fnames, delimiter=c_kwargs["delimiter"],
+                    comment=c_kwargs["comment"], quote=c_kwargs["quote"],
+                    imaginary_unit=c_kwargs["imaginary_unit"],
+                    usecols=c_kwargs["usecols"],
+                    skiprows=c_kwargs["skiprows"], dtype=c_kwargs["dtype"],
+                    encoding=native[0], num_threads=num_threads)
+    if arr is not None:
+        return arr
+
+    # Read the files one by one, which also raises any errors
+    arrs = [read(fname, delimiter=delimiter, comment=comment, quote=quote,
+                 imaginary_unit=imaginary_unit, usecols=usecols,
+                 skiprows=skiprows, converters=converters, dtype=dtype,
+                 encoding=encoding, num_threads=num_threads)
+            for fname in fnames]
+    # Empty files may have the wrong number of columns
+    nonempty = [(fname, a) for fname, a in zip(fnames, arrs) if len(a)]
+    if len(nonempty) == 0:
+        return arrs[0]
+    first, first_arr = nonempty[0]
+    for fname, a in nonempty[1:]:
+        if a.shape[1:] != first_arr.shape[1:]:
+            raise ValueError(
+                f"{fname!r} has {a.shape[1]} columns, but {first!r} has "
+                f"{first_arr.shape[1]}.")
+    return np.concatenate([a for _, a in nonempty], axis=0)
+
+
+_ARROW_FORMATS = {
+    "i1": "c", "u1": "C", "i2": "s", "u2": "S", "i4": "i", "u4": "I",
+    "i8": "l", "u8": "L", "f2": "e", "f4": "f", "f8": "g"}
+_ARROW_TIME_UNITS = {"s": "s", "ms": "m", "us": "u", "ns": "n"}
+
+
+def _arrow_format(dtype):
+    """The Arrow format string of a (not string) column of `dtype`."""
+    if dtype.kind == "b":
+        return "b"
+    if dtype.kind in "iuf":
+        fmt = _ARROW_FORMATS.get(f"{dtype.kind}{dtype.itemsize}")
+        if fmt is not None:
+            return fmt
+    elif dtype.kind in "Mm":
+        unit, count = np.datetime_data(dtype)
+        if count == 1 and unit in _ARROW_TIME_UNITS:
+            unit = _ARROW_TIME_UNITS[unit]
+            return f"ts{unit}:" if dtype.kind == "M" else f"tD{unit}"
+    raise TypeError(f"dtype {dtype} cannot be exported to Arrow.")
+
+
+class ArrowBatch:
+    """
+    The columns read by `read_arrow`, implementing the Arrow PyCapsule
+    interface: ``pyarrow.record_batch(batch)`` (or any other consumer of
+    ``__arrow_c_array__``) uses the buffers without copying them.
+
+    Attributes
+    ----------
+    names : list of str
+        The names of the columns.
+    num_rows : int
+        The number of rows.
+    """
+    def __init__(self, names, columns, num_rows):
+        self.names = list(names)
+        self.num_rows = num_rows
+        # (name, format, null_count, buffers) of each column
+        self._columns = columns
+
+    def __len__(self):
+        return self.num_rows
+
+    def __arrow_c_schema__(self):
+        return _arrow_export(self._columns, self.num_rows)[0]
+
+    def __arrow_c_array__(self, requested_schema=None):
+        # The columns are always exported as read
+        return _arrow_export(self._columns, self.num_rows)
+
+
+def _arrow_column(name, field, null_rows, string_data):
+    valid = np.ones(len(field), dtype=bool)
+    valid[null_rows] = False
+    if string_data is None and field.dtype.kind in "Mm":
+        valid &= ~np.isnat(field)
+    null_count = len(field) - int(np.count_nonzero(valid))
+    validity = None
+    if null_count > 0:
+        validity = np.packbits(valid, bitorder="little")
+
+    if string_data is not None:
+        # The offsets of the rows are followed by the end of the last one
+        offsets = np.empty(len(field) + 1, dtype=np.int64)
+        offsets[:-1] = field
+        offsets[-1] = len(string_data)
+        return (name, "U", null_count, (validity, offsets, string_data))
+    if field.dtype.kind == "b":
+        # Arrow booleans are bit-packed
+        field = np.packbits(field, bitorder="little")
+        return (name, "b", null_count, (validity, field))
+    return (name, _arrow_format(field.dtype), null_count, (validity, field))
+
+
+def read_arrow(fname, *, delimiter=',', comment='#', quote='"',
+               imaginary_unit='j', usecols=None, skiprows=0, max_rows=None,
+               converters=None, dtype=np.float64, encoding="bytes",
+               missing_values=None, filling_values=None, stats=None):
+    """
+    Read a text file into Arrow columns.
+
+    The columns are read column-major and exported through the Arrow C
+    Data Interface (without depending on pyarrow).  String columns (``S``
+    or ``U`` fields, whose length does not matter) are stored as
+    variable-length UTF-8 data with offsets (Arrow ``large_string``)
+    rather than padded to the longest string.  Missing fields (see
+    `missing_values`) are null.
+
+    Parameters
+    ----------
+    fname, delimiter, comment, quote, imaginary_unit, usecols, skiprows, max_rows, converters, encoding, stats
+        See `read`.  String columns cannot have a converter.
+    dtype : numpy data type
+        The dtype of the columns, a structured dtype names them (otherwise
+        they are named ``f0``, ``f1``, ...).  Supported are booleans,
+        integers, floats, strings and datetimes or timedeltas with the unit
+        ``s``, ``ms``, ``us`` or ``ns`` (NaT is null).  Default is float64.
+    missing_values, filling_values
+        See `read`.  Missing fields are null (and store the fill value).
+
+    Returns
+    -------
+    ArrowBatch
+        The columns, e.g. ``pyarrow.record_batch(read_arrow(...))``.
+    """
+    c_kwargs, comments, read_dtype_via_object_chunks = _normalize_args(
+            delimiter=delimiter, comment=comment, quote=quote,
+            imaginary_unit=imaginary_unit, usecols=usecols,
+            skiprows=skiprows, converters=converters,
+            batch_converters=False, dtype=dtype, encoding=encoding)
+    if read_dtype_via_object_chunks is not None:
+        raise TypeError(
+            f"dtype {dtype!r} is read via Python objects and cannot be "
+            "exported to Arrow.")
+    if max_rows is not None:
+        _check_nonneg_int(max_rows)
+    else:
+        max_rows = -1
+
+    # String fields are read as the int64 offsets into their data
+    dtype = c_kwargs["dtype"]
+    names = dtype.names
+    if names is None:
+        strings = True if dtype.kind in "SU" else None
+        if strings is None:
+            _arrow_format(dtype)
+            c_kwargs["dtype"] = dtype.newbyteorder("=")
         else:
-            return arr.T
+            c_kwargs["dtype"] = np.dtype(np.int64)
+    else:
+        c_fields, strings = [], []
+        for i, name in enumerate(names):
+            field = dtype[name]
+            if field.names is not None or field.shape != ():
+                raise TypeError(
+                    f"nested field {name!r} cannot be exported to Arrow.")
+            if field.kind in "SU":
+                strings.append(i)
+                c_fields.append((name, np.int64))
+            else:
+                _arrow_format(field)
+                c_fields.append((name, field.newbyteorder("=")))
+        c_kwargs["dtype"] = np.dtype(c_fields)
+        strings = strings or None
+    missing = None
+    if missing_values is not None or filling_values is not None:
+        missing = _normalize_missing(missing_values, filling_values)
+
+    with _open_data(fname, c_kwargs["encoding"], comments) as file_kwargs:
+        c_kwargs.update(file_kwargs)
+        reader = TextReader(**c_kwargs, missing=missing,
+                            record_missing=missing is not None,
+                            strings=strings, column_major=True,
+                            stats=stats is not None)
+        try:
+            arr = reader.read_batch(max_rows)
+            string_data = reader.take_strings()
+            rows, fields = reader.missing_positions
+        finally:
+            reader.close()
+        if stats is not None:
+            stats.update(reader.stats)
+
+    if names is None:
+        # Fortran order, so the columns are contiguous
+        num_rows = len(arr)
+        columns = [arr[:, i] for i in range(arr.shape[1])]
+        names = [f"f{i}" for i in range(len(columns))]
+        strings = range(len(columns)) if strings else ()
     else:
+        # A tuple of the columns of the fields
+        num_rows = len(arr[0]) if len(arr) else 0
+        columns = arr
+        strings = strings or ()
+    empty = np.empty(0, dtype=np.uint8)
+    exported = [
+        _arrow_column(
+            name, column, rows[fields == i],
+            string_data.get(i, empty) if i in strings else None)
+        for i, (name, column) in enumerate(zip(names, columns))]
+    return ArrowBatch(names, exported, num_rows)
+
+
+def trim_buffers():
+    """
+    Free the scratch buffers kept for reading in the current thread.
+
+    The buffers of the tokenizer are kept at their largest size between
+    reads in the same thread, so that reading many small files does not
+    allocate and grow them each time.  After reading a file with very long
+    rows this releases that memory (the next read allocates them again).
+
+    Returns
+    -------
+    int
+        The number of bytes freed.
+    """
+    return _trim_buffers()
+
+
+class Reader:
+    r"""
+    Read a text file in batches of rows.
+
+    The file, the state of the parser and the dtype information are kept
+    between batches, so that reading a large file batch by batch has a small
+    constant overhead and needs memory only for one batch.
+
+    Parameters
+    ----------
+    fname : str or file object
+        The filename or the file to be read, see `read`.
+    batch_size : int, optional
+        The number of rows in each batch returned when iterating the reader.
+        Default is 50000.
+    delimiter, comment, quote, imaginary_unit, usecols, skiprows, converters, batch_converters, dtype, encoding, categorical
+        See `read`.  The categories of the `categorical` columns are
+        available as `categories`.  For the flexible dtypes ``S0``, ``U0`` and ``M8``, the
+        string length or unit is discovered for each batch separately.
+
+    Examples
+    --------
+    >>> with Reader('example1.csv', batch_size=1000) as reader:
+    ...     for batch in reader:
+    ...         process(batch)
+
+    A preallocated array can be filled with the next rows, the view of the
+    rows which were read is returned:
+
+    >>> out = np.empty((1000, 3))
+    >>> with Reader('example1.csv') as reader:
+    ...     a = reader.read_batch(out=out)
+    """
+    def __init__(self, fname, *, batch_size=_CHUNK_SIZE, delimiter=',',
+                 comment='#', quote='"', imaginary_unit='j', usecols=None,
+                 skiprows=0, converters=None, batch_converters=False,
+                 dtype=np.float64, encoding="bytes", categorical=None):
+        _check_nonneg_int(batch_size, "batch_size")
+        if batch_size == 0:
+            raise ValueError("batch_size must be positive")
+        self.batch_size = batch_size
+
+        c_kwargs, comments, self._cast_dtype = _normalize_args(
+                delimiter=delimiter, comment=comment, quote=quote,
+                imaginary_unit=imaginary_unit, usecols=usecols,
+                skiprows=skiprows, converters=converters,
+                batch_converters=batch_converters, dtype=dtype,
+                encoding=encoding)
+        if self._cast_dtype == "S":
+            c_kwargs["c_byte_converters"] = True  # latin1 rather than ascii
+        self._categorical = None
+        if categorical is not None:
+            self._categorical = tuple(categorical)
+            c_kwargs["categorical"] = self._categorical
+
+        self._exit_stack = contextlib.ExitStack()
+        try:
+            c_kwargs.update(self._exit_stack.enter_context(
+                    _open_data(fname, c_kwargs["encoding"], comments)))
+            self._reader = TextReader(**c_kwargs)
+        except BaseException:
+            self._exit_stack.close()
+            raise
+
+    @property
+    def row_count(self):
+        """The number of rows read so far."""
+        return self._reader.row_count
+
+    @property
+    def categories(self):
+        """
+        Dictionary of the categories of each `categorical` column.  The
+        codes are consistent between batches, so the arrays only grow.
+        """
+        if self._categorical is None:
+            return {}
+        return _fill_categories(self._reader.categories, self._categorical)
+
+    def read_batch(self, max_rows=None, *, out=None):
+        """
+        Read the next rows.
+
+        Parameters
+        ----------
+        max_rows : int, optional
+            The maximum number of rows to read, by default all remaining
+            rows (or as many as fit into `out`) are read.
+        out : ndarray, optional
+            A C-contiguous array with the dtype of the reader to fill.  For
+            a non-structured dtype, it must be two dimensional with one
+            column for each column read.
+
+        Returns
+        -------
+        ndarray
+            The rows read, a view of `out` if it was given.  Fewer than
+            `max_rows` rows are only returned at the end of the file.
+        """
+        if max_rows is None:
+            max_rows = -1
+        else:
+            _check_nonneg_int(max_rows, "max_rows")
+
+        if self._cast_dtype is None:
+            return self._reader.read_batch(max_rows, out=out)
+
+        if out is not None and (max_rows < 0 or max_rows > len(out)):
+            max_rows = len(out)
+        arr = self._reader.read_batch(max_rows).astype(self._cast_dtype)
+        if out is None:
+            return arr
+        out[:len(arr)] = arr
+        return out[:len(arr)]
+
+    def close(self):
+        """Close the reader and the file if it was opened by the reader."""
+        self._reader.close()
+        self._exit_stack.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc_info):
+        self.close()
+
+    def __iter__(self):
+        return self
+
+    def __next__(self):
+        if self._reader.finished:
+            raise StopIteration
+        arr = self.read_batch(self.batch_size)
+        if len(arr) == 0:
+            raise StopIteration
         return arr
@@ -1,10 +1,15 @@
 import sys
+import io
+import gzip
 from os import path
 from io import StringIO
 import pytest
 import numpy as np
 from numpy.testing import assert_array_equal, assert_equal, HAS_REFCOUNT
-from npreadtext import read
+from npreadtext import (
+    read, read_many, read_arrow, Reader, RowIndex, build_row_index,
+    trim_buffers)
+from npreadtext import _readers
 
 
 def _get_full_name(basename):
@@ -75,16 +80,50 @@ def test_comment_multiple_chars(comment):
 
 def test_comment_multichar_error_with_quote():
     txt = StringIO("1,2\n3,4")
-    with pytest.raises(ValueError):
-        read(txt, comment="123")
+    # comments starting with a different character are stripped in Python
     with pytest.raises(ValueError):
         read(txt, comment=["1", "3"])
+    with pytest.raises(ValueError):
+        read(txt, comment=["//", "#"])
 
     # a single character string in a tuple is unpacked though:
     a = read(txt, comment=("#",), quote='"')
     assert_equal(a, [[1, 2], [3, 4]])
 
 
+
+@pytest.mark.parametrize("native_file", [True, False])
+def test_comment_multichar_with_quote(tmp_path, native_file):
+    # Multi-character comments starting with the same character are handled
+    # by the tokenizer, also when split across buffers (rows have different
+    # lengths to move the comments relative to the chunks read)
+    rows = [f'{i},"{"/" * (i % 3)}a//b",{"c" * (i % 7)}/x// {i}/\n'
+            for i in range(20000)]
+    data = "".join(rows)
+    expected = np.array(
+        [(i, f'{"/" * (i % 3)}a//b', "c" * (i % 7) + "/x")
+         for i in range(20000)], dtype="i8,U8,U8")
+    if native_file:
+        fname = tmp_path / "comments.csv"
+        fname.write_text(data, encoding="utf-8")
+        txt = str(fname)
+    else:
+        txt = StringIO(data)
+    res = read(txt, dtype=expected.dtype, comment="//", encoding="utf-8")
+    assert_array_equal(res, expected)
+
+
+@pytest.mark.parametrize(["comment", "data", "expected"],
+    [("123", '123\n4,5\n1,2123,6\n', [[4, 5], [1, 2]]),
+     (["ab", "a"], 'xaab\nya\n"aab"\n', [["x"], ["y"], ["aab"]]),
+     (["abc", "a"], 'xaab\nyabc\n"aab"\n', [["x"], ["y"], ["aab"]]),
+     (["aab"], 'xaab\nya\n"aab"\naaab\n', [["x"], ["ya"], ["aab"], ["a"]])])
+def test_comment_multiple_with_quote(comment, data, expected):
+    res = read(StringIO(data), comment=comment,
+               dtype=np.array(expected).dtype)
+    assert_array_equal(res, expected)
+
+
 def test_quoted_field():
     filename = _get_full_name('quoted_field.csv')
     dtype = np.dtype([('f0', 'S8'), ('f1', np.float64)])
@@ -233,6 +272,15 @@ def test_quoted_field_is_not_empty():
     a = read(txt, delimiter=",", dtype="U1")
     assert_equal(a, np.array([["1"], ["4"], [""]]))
 
+
+def test_doubled_quotes():
+    # A doubled quote within a quoted field is one quote character
+    txt = StringIO('"a""b",1\n"""",2\n"""x""",3\n')
+    a = read(txt, dtype=np.dtype([("s", "U3"), ("x", np.int64)]))
+    assert_equal(a["s"], ['a"b', '"', '"x"'])
+    assert_equal(a["x"], [1, 2, 3])
+
+
 @pytest.mark.parametrize("dtype", [np.float64, object])
 def test_max_rows(dtype):
     txt = StringIO('1.5,2.5\n3.0,4.0\n5.5,6.0')
@@ -326,6 +374,52 @@ def test_converter_with_unicode_dtype():
     assert_equal(a, expected)
 
 
+@pytest.mark.parametrize("nrows", [3, 4096, 10000])
+def test_batch_converters(nrows):
+    # The converter is called once per block of rows with the string array
+    lines = [f"{i}.5,x{i},{i}" for i in range(nrows)]
+    dt = np.dtype([('a', np.float64), ('b', 'U8'), ('c', np.int64)])
+    calls = []
+
+    def conv(strings):
+        calls.append(strings.dtype)
+        return np.char.upper(strings)
+
+    a = read(StringIO("\n".join(lines)), dtype=dt, converters={1: conv},
+             usecols=[0, 1, 2], batch_converters=True, encoding=None)
+    expected = read(StringIO("\n".join(lines)), dtype=dt,
+                    converters={1: str.upper}, encoding=None)
+    assert_equal(a, expected)
+    assert len(calls) == -(-nrows // 4096)
+    assert all(dtype.kind == "U" for dtype in calls)
+
+
+def test_batch_converters_bytes():
+    # With the default 'bytes' encoding the converter gets latin1 bytes
+    txt = StringIO('1,ä\n2,b\n')
+    conv = {1: lambda s: np.char.decode(s, 'latin1') == 'ä'}
+    a = read(txt, dtype=np.int64, converters=conv, batch_converters=True)
+    assert_equal(a, [[1, 1], [2, 0]])
+
+
+def test_batch_converters_wrong_length():
+    txt = StringIO('1,2\n3,4\n')
+    conv = {0: lambda s: np.zeros(len(s) + 1)}
+    msg = "could not convert the strings of column 1 at rows 0 to 1"
+    with pytest.raises(ValueError, match=msg) as e:
+        read(txt, converters=conv, batch_converters=True)
+    assert isinstance(e.value.__cause__, ValueError)
+
+
+def test_batch_converters_reader():
+    txt = StringIO('1,2\n3,4\n5,6\n')
+    conv = {1: lambda s: s.astype(np.float64) * 10}
+    with Reader(txt, batch_size=2, converters=conv,
+                batch_converters=True) as reader:
+        batches = list(reader)
+    assert_equal(np.concatenate(batches), [[1, 20], [3, 40], [5, 60]])
+
+
 @pytest.mark.parametrize('dtype, actual_dtype', [('S', np.dtype('S5')),
                                                  ('U', np.dtype('U5'))])
 def test_string_no_length_given(dtype, actual_dtype):
@@ -356,6 +450,30 @@ def test_float_conversion():
     assert_equal(a, expected)
 
 
+@pytest.mark.parametrize("dtype", [np.float64, np.float32, np.complex128])
+def test_float_parsing_exact(dtype):
+    # Hard cases for a native float parser: halfway cases, subnormals,
+    # overflow and very long mantissas (which use a slow path).
+    strings = ["9007199254740993", "2.4703282292062328e-324",
+               "2.4703282292062327e-324", "4.9406564584124654e-324",
+               "2.2250738585072011e-308", "1.7976931348623158e308",
+               "1.7976931348623159e308", "1e-400", "-0.0", "1e23",
+               "8.98846567431158e307", "7.2057594037927933e16",
+               "0." + "0" * 400 + "1e401", "1" + "0" * 30 + "1e-30",
+               "123456789012345678901234567890", ".5", "5.", "1E5",
+               "inf", "-Infinity", "nan"]
+    res = read(strings, dtype=dtype)
+    expected = np.array([float(s) for s in strings]).astype(dtype)
+    assert_array_equal(res.ravel(), expected)
+    assert_array_equal(np.signbit(res.ravel()), np.signbit(expected))
+
+
+@pytest.mark.parametrize("s", ["1e", "1.2.3", ".", "e5", "1_0", "0x10", "infx"])
+def test_float_parsing_invalid(s):
+    with pytest.raises(ValueError, match="could not convert string"):
+        read([s], dtype=np.float64)
+
+
 def test_bool():
     # Simple test for bool via integer:
     res = read(["1, 0", "10, -1"], dtype=bool)
@@ -379,6 +497,30 @@ def test_cast_float_to_int(dt):
     assert_equal(a, expected)
 
 
+@pytest.mark.parametrize('dt', [np.int64, np.uint64])
+def test_cast_float_to_int_like_double(dt):
+    # Simple floats are parsed as integers directly, the result must be the
+    # same as parsing the double and casting it (i.e. also when rounding).
+    values = ["-0.5", "1.", ".5", " 2.9 ", "1.9999999999999999",
+              "99999999999999.99", "1e3", "3.5e-1", "0000.70"]
+    if dt == np.uint64:
+        values[0] = "0.5"
+    res = read([",".join(values)], dtype=dt)
+    expected = np.array(
+        [np.float64(v).astype(dt) for v in values], dtype=dt)
+    assert_array_equal(res, [expected])
+
+
+@pytest.mark.parametrize('dt', [np.int64, np.uint64])
+def test_large_integers(dt):
+    info = np.iinfo(dt)
+    values = [info.max, info.min, info.max - 1, 12345678901234567,
+              10**17, 0]
+    txt = "\n".join(f" {v:020d} " if v >= 0 else str(v) for v in values)
+    res = read(StringIO(txt), dtype=dt)
+    assert_array_equal(res, np.array(values, dtype=dt)[:, np.newaxis])
+
+
 @pytest.mark.parametrize('dt', [np.complex64, np.complex128])
 @pytest.mark.parametrize('imaginary_unit', ['i', 'j'])
 @pytest.mark.parametrize('with_parens', [False, True])
@@ -448,14 +590,14 @@ def test_bad_encoding():
         read(data, encoding="this encoding is invalid!")
 
 
-def test_character_not_bytes_compatible():
-    # Test a character which cannot be encoded as "S".  Note that loadtxt
-    # would try `string.encode("latin1")` throwing a slightly more informative
-    # `UnicodeDecodeError`.
-    data = ["–"]
-
-    with pytest.raises(ValueError):
-        read(data, dtype="S5")
+@pytest.mark.parametrize("dtype", ["S5", "S"])
+@pytest.mark.parametrize("data", [["–"], ["a,b–c"], ["\U0001F34A"]])
+def test_character_not_bytes_compatible(dtype, data):
+    # Test a character which cannot be encoded as "S", the error of
+    # `string.encode("latin1")` (which loadtxt used) is given as cause.
+    with pytest.raises(ValueError) as excinfo:
+        read(data, dtype=dtype)
+    assert isinstance(excinfo.value.__cause__, UnicodeEncodeError)
 
 
 def test_convert_raises_non_dict():
@@ -485,3 +627,960 @@ def test_converter_raises_value_not_callable():
         TypeError, match="values of the converters dictionary must be callable"
     ):
         read(data, converters={0: 1})
+
+
+@pytest.mark.parametrize("encoding", ["utf-8", "latin1", "ascii"])
+def test_native_file_matches_file_object(tmp_path, encoding):
+    # Paths are read natively, the result must match the Python file object
+    content = "abc,1.5\ndef,2.5\n" * 100
+    if encoding != "ascii":
+        content += "\u00e4\u00f6\u00fc,3.5\nxyz,4.5\n"
+    fname = tmp_path / "data.csv"
+    fname.write_text(content, encoding=encoding)
+    dt = np.dtype([("s", "U3"), ("x", np.float64)])
+
+    res = read(fname, dtype=dt, encoding=encoding)
+    with open(fname, encoding=encoding) as f:
+        expected = read(f, dtype=dt, encoding=encoding)
+    assert_array_equal(res, expected)
+    assert len(res) == len(content.splitlines())
+
+
+def test_native_file_embedded_crlf(tmp_path):
+    # Quoted (embedded) newlines are translated like for python text files
+    fname = tmp_path / "data.csv"
+    fname.write_bytes(b'"a\r\nb",1\r\n"c\rd",2\r\n')
+    dt = np.dtype([("s", "U3"), ("x", np.int64)])
+
+    res = read(fname, dtype=dt)
+    expected = np.array([("a\nb", 1), ("c\nd", 2)], dtype=dt)
+    assert_array_equal(res, expected)
+    with open(fname) as f:
+        assert_array_equal(read(f, dtype=dt), expected)
+
+
+def test_native_file_bad_utf8(tmp_path):
+    fname = tmp_path / "data.csv"
+    fname.write_bytes(b"1,2\n\xff,3\n")
+    with pytest.raises(UnicodeDecodeError):
+        read(fname, encoding="utf-8")
+
+
+def test_compressed_file_not_native(tmp_path):
+    import gzip
+    fname = tmp_path / "data.csv.gz"
+    with gzip.open(fname, "wt") as f:
+        f.write("1,2\n3,4\n")
+    assert_array_equal(read(fname), [[1, 2], [3, 4]])
+
+
+@pytest.mark.parametrize("ext", [".gz", ".bz2", ".xz", ".lzma"])
+@pytest.mark.parametrize("encoding", ["utf-8", "latin1"])
+def test_compressed_file(tmp_path, ext, encoding):
+    # Compressed files are decompressed natively (if supported), the
+    # decompressed data spans several buffers and contains multiple members
+    import bz2, lzma
+    open_compressed = {".gz": gzip.open, ".bz2": bz2.open, ".xz": lzma.open,
+                       ".lzma": lambda f, mode, **kwargs: lzma.open(
+                           f, mode, format=lzma.FORMAT_ALONE, **kwargs)}[ext]
+    rows = [f"{i},{chr(0xe4 + i % 3) * (i % 5)},{i / 4}\n"
+            for i in range(200000)]
+    # (legacy lzma files cannot be concatenated)
+    split = len(rows) if ext == ".lzma" else 1000
+    fname = tmp_path / f"data.csv{ext}"
+    with open_compressed(fname, "wt", encoding=encoding) as f:
+        f.writelines(rows[:split])
+    if split < len(rows):
+        with open_compressed(fname, "at", encoding=encoding) as f:
+            f.writelines(rows[split:])
+
+    dt = np.dtype("i8,U4,f8")
+    res = read(fname, dtype=dt, encoding=encoding)
+    with open_compressed(fname, "rt", encoding=encoding) as f:
+        expected = read(f, dtype=dt, encoding=encoding)
+    assert_array_equal(res, expected)
+    assert len(res) == len(rows)
+
+
+def test_compressed_file_truncated(tmp_path):
+    fname = tmp_path / "data.csv.gz"
+    data = gzip.compress(b"1,2\n3,4\n" * 10000)
+    fname.write_bytes(data[:len(data) // 2])
+    with pytest.raises(EOFError):
+        read(fname)
+
+
+@pytest.mark.parametrize("usecols", [None, [2, 0]])
+@pytest.mark.parametrize("dtype", [np.int64, np.float64, "i8,f8,i4"])
+def test_parallel_matches_serial(tmp_path, usecols, dtype):
+    # Large enough to be split into multiple chunks
+    rng = np.random.default_rng(0)
+    data = rng.integers(-1000, 1000, size=(300_000, 3))
+    fname = tmp_path / "data.csv"
+    np.savetxt(fname, data, fmt="%d", delimiter=",", header="a,b,c")
+    if usecols is not None and np.dtype(dtype).names:
+        dtype = "i8,f8"
+
+    expected = read(fname, dtype=dtype, usecols=usecols, skiprows=1)
+    res = read(fname, dtype=dtype, usecols=usecols, skiprows=1,
+               num_threads=4)
+    assert_array_equal(res, expected)
+    assert len(res) == len(data)
+
+
+def test_parallel_quoted_newlines(tmp_path):
+    # Chunks must not be split within a quoted field containing newlines
+    row = '"abc\ndef\nghi\njkl",1\n'
+    fname = tmp_path / "data.csv"
+    fname.write_text(row * 200_000)
+    dt = np.dtype([("s", "U15"), ("x", np.int64)])
+
+    res = read(fname, dtype=dt, encoding="latin1", num_threads=4)
+    assert len(res) == 200_000
+    assert (res["s"] == "abc\ndef\nghi\njkl").all()
+    assert (res["x"] == 1).all()
+
+
+def test_parallel_error_is_serial_error(tmp_path):
+    lines = ["1,2"] * 500_000
+    lines[400_000] = "1,x"
+    fname = tmp_path / "data.csv"
+    fname.write_text("\n".join(lines))
+
+    with pytest.raises(ValueError,
+            match="could not convert string 'x' to int64 at row 400000"):
+        read(fname, dtype=np.int64, num_threads=4)
+
+
+@pytest.mark.parametrize("num_threads", [-1, 1.5])
+def test_bad_num_threads(num_threads):
+    with pytest.raises((ValueError, TypeError)):
+        read(StringIO("1,2\n"), num_threads=num_threads)
+
+
+@pytest.mark.parametrize("native", [True, False])
+def test_long_rows_and_fields(tmp_path, native):
+    # Structural characters at all offsets (the tokenizer scans in blocks)
+    rng = np.random.default_rng(1)
+    rows = []
+    for i in range(200):
+        fields = [str(x) for x in rng.integers(0, 10**rng.integers(1, 8), 50)]
+        rows.append(fields)
+    content = "\n".join(",".join(row) + "# comment, 1, 2" * (i % 2)
+                        for i, row in enumerate(rows))
+    fname = tmp_path / "data.csv"
+    fname.write_text(content)
+    expected = np.array(rows, dtype=np.int64)
+
+    if native:
+        res = read(fname, dtype=np.int64)
+    else:
+        res = read(StringIO(content), dtype=np.int64)
+    assert_array_equal(res, expected)
+
+    # Long quoted fields with embedded quotes and newlines
+    long = "x" * 100 + '""' + "y" * 70
+    content = f'"{long}",1\n"a\n{long}",2\n'
+    dt = np.dtype([("s", "U200"), ("x", np.int64)])
+    res = read(StringIO(content), dtype=dt)
+    assert res["s"][0] == long.replace('""', '"')
+    assert res["s"][1] == "a\n" + long.replace('""', '"')
+    assert_array_equal(res["x"], [1, 2])
+
+
+@pytest.mark.parametrize("text", ["abc", "été", "一丁",
+                                  "\U0001F600"])
+def test_fields_of_all_unicode_kinds(tmp_path, text):
+    # Fields are converted directly from 1, 2 and 4 byte unicode data, rows
+    # are copied when they need unquoting or span multiple lines/chunks.
+    content = (f'{text}," 1",2.5, {text} \n'
+               f'"{text}""{text}",-3,1e3,"{text}\n{text}"\n')
+    dt = np.dtype([("a", "U10"), ("b", np.int8), ("c", np.float64),
+                   ("d", "U10")])
+    expected = np.array(
+        [(text, 1, 2.5, f" {text} "),
+         (f'{text}"{text}', -3, 1000., f"{text}\n{text}")], dtype=dt)
+    res = read(StringIO(content), dtype=dt)
+    assert_array_equal(res, expected)
+
+    fname = tmp_path / "data.csv"
+    fname.write_text(content, encoding="utf-8")
+    res = read(fname, dtype=dt, encoding="utf-8")
+    assert_array_equal(res, expected)
+
+    if text.isascii():
+        res = read(StringIO(content), dtype=[("a", "S10"), ("b", "i1"),
+                                             ("c", "f8"), ("d", "S10")])
+        assert_array_equal(res, expected.astype(res.dtype))
+
+
+@pytest.mark.parametrize("skiprows,num_rows", [(0, 40), (2, 39)])
+def test_native_file_counted_rows(tmp_path, skiprows, num_rows):
+    # For files, the rows are counted to allocate the result only once;
+    # blank, comment and quoted lines must not confuse the result size.
+    content = '1,2\n\n# comment\n"3\n",4\r\n\r5,6 # c\n"#7",8\n' * 10
+    fname = tmp_path / "data.csv"
+    fname.write_text(content)
+    dt = np.dtype([("a", "U3"), ("b", "U3")])
+    res = read(fname, dtype=dt, skiprows=skiprows)
+    expected = read(StringIO(content), dtype=dt, skiprows=skiprows)
+    assert_array_equal(res, expected)
+    assert len(res) == num_rows
+
+
+def test_native_file_from_threads(tmp_path):
+    # Without Python converters, native files are read without the GIL
+    from concurrent.futures import ThreadPoolExecutor
+
+    fnames = []
+    for i in range(8):
+        fname = tmp_path / f"data{i}.csv"
+        fname.write_text("\n".join(f"{i},{j},{j / 8}" for j in range(1000)))
+        fnames.append(fname)
+    bad = tmp_path / "bad.csv"
+    bad.write_text("1,2,3\n4,x,6\n")
+
+    with ThreadPoolExecutor(4) as pool:
+        results = list(pool.map(read, fnames))
+        bad_result = pool.submit(read, bad, dtype=np.int64)
+
+    for i, res in enumerate(results):
+        assert_array_equal(res, read(StringIO(fnames[i].read_text())))
+    with pytest.raises(ValueError, match="could not convert string 'x'"):
+        bad_result.result()
+
+
+@pytest.mark.parametrize("source", ["native", "gzip", "lines"])
+def test_reader_batches(tmp_path, source):
+    content = "a,b,c\n" + "".join(
+        f'{i},{i / 4},"x\n{i}"\n' for i in range(1000))
+    fname = tmp_path / "data.csv"
+    fname.write_text(content)
+    if source == "gzip":
+        fname = tmp_path / "data.csv.gz"
+        with gzip.open(fname, "wt") as f:
+            f.write(content)
+    elif source == "lines":
+        fname = StringIO(content)
+
+    dt = np.dtype([("i", np.int64), ("f", np.float64), ("s", "U6")])
+    expected = read(StringIO(content), dtype=dt, skiprows=1)
+
+    with Reader(fname, dtype=dt, skiprows=1, batch_size=64) as reader:
+        batches = list(reader)
+        assert reader.row_count == 1000
+    assert [len(b) for b in batches] == [64] * 15 + [40]
+    assert_array_equal(np.concatenate(batches), expected)
+
+
+def test_reader_batches_after_decoded_window(tmp_path):
+    # Only the first (decoded) window is non-ASCII: the next batch must not
+    # release the GIL while that window is still being read.
+    content = "\u00e4,0\n" + "".join(f"a,{i}\n" for i in range(1, 300_000))
+    fname = tmp_path / "data.csv"
+    fname.write_text(content, encoding="utf-8")
+    dt = np.dtype([("s", "U1"), ("x", np.int64)])
+    with Reader(fname, dtype=dt, encoding="utf-8") as reader:
+        first = reader.read_batch(2)
+        rest = reader.read_batch()
+    assert_array_equal(first["s"], ["\u00e4", "a"])
+    assert len(rest) == 300_000 - 2
+    assert_array_equal(rest["x"], np.arange(2, 300_000))
+
+
+def test_reader_in_use():
+    # The reader cannot be closed (or read) while a converter of it runs
+    errors = []
+
+    def conv(s):
+        for method in [reader.close, reader.read_batch]:
+            try:
+                method()
+            except RuntimeError as e:
+                errors.append(str(e))
+        return float(s)
+
+    with Reader(StringIO("1\n2\n"), converters={0: conv}) as reader:
+        assert_array_equal(reader.read_batch().ravel(), [1, 2])
+        assert reader.read_batch().shape == (0, 1)
+    assert errors == ["reader is in use"] * 4
+
+
+def test_reader_read_batch_out():
+    content = "".join(f"{i},{-i}\n" for i in range(10))
+    out = np.full((4, 2), -1, dtype=np.int64)
+    with Reader(StringIO(content), dtype=np.int64) as reader:
+        res = reader.read_batch(out=out)
+        assert np.shares_memory(res, out)
+        assert_array_equal(res, [[0, 0], [1, -1], [2, -2], [3, -3]])
+        res = reader.read_batch(3, out=out)
+        assert_array_equal(res, [[4, -4], [5, -5], [6, -6]])
+        assert_array_equal(out[3], [3, -3])  # not overwritten
+        res = reader.read_batch(out=out)
+        assert res.shape == (3, 2)
+        assert reader.read_batch().shape == (0, 2)
+
+        with pytest.raises(ValueError):
+            reader.read_batch(out=np.empty((4, 3), dtype=np.float32))
+
+
+def test_reader_out_wrong_number_of_columns():
+    with Reader(StringIO("1,2\n3,4\n"), dtype=np.int64) as reader:
+        with pytest.raises(ValueError, match="output array has 3 columns"):
+            reader.read_batch(out=np.empty((4, 3), dtype=np.int64))
+        # The reader is closed after an error
+        with pytest.raises(ValueError, match="closed"):
+            reader.read_batch()
+
+
+def test_reader_flexible_dtype():
+    content = "a\nbb\nccc\ndddd\n"
+    with Reader(StringIO(content), dtype="U", batch_size=2) as reader:
+        batches = list(reader)
+    assert [b.dtype for b in batches] == [np.dtype("U2"), np.dtype("U4")]
+    assert_array_equal(np.concatenate(batches).ravel(),
+                       ["a", "bb", "ccc", "dddd"])
+
+
+@pytest.mark.parametrize("native", [True, False])
+def test_usecols_skips_unused_fields(tmp_path, native):
+    # Fields after the last column used are skipped, taking care of quoted
+    # fields with newlines and rows with an empty first field.
+    rows = [[str(i + j) for j in range(300)] for i in range(50)]
+    rows[3][200] = '"a,\nb"'
+    rows[4][0] = ""
+    rows[5][1] = '"x""y"'
+    content = "\n".join(",".join(row) for row in rows) + "\n"
+    if native:
+        fname = tmp_path / "data.csv"
+        fname.write_text(content)
+    else:
+        fname = StringIO(content)
+
+    res = read(fname, dtype="U10", usecols=[1, 0])
+    expected = [[row[1], row[0]] for row in rows]
+    expected[5][0] = 'x"y'
+    assert_array_equal(res, expected)
+
+
+@pytest.mark.parametrize("dtype", ["f8", "f4", "i8", "i4", ">f8", "<i4"])
+@pytest.mark.parametrize("comment", ["", " # ä", " # α", " # \U0001F34A"])
+def test_homogeneous_numeric_rows(dtype, comment):
+    # Plain numeric dtypes use specialized row loops, the comment makes the
+    # lines of each unicode kind (they are not copied).
+    data = [f' 1, -2,"3",{i} {comment}\n' for i in range(5)]
+    res = read(data, dtype=dtype)
+    expected = np.array([[1, -2, 3, i] for i in range(5)], dtype=dtype)
+    assert res.dtype == np.dtype(dtype)
+    assert_array_equal(res, expected)
+
+    data[3] = "1,2,x,4\n"
+    with pytest.raises(ValueError,
+            match=f"could not convert string 'x' to .* at row 3, column 3"):
+        read(data, dtype=dtype)
+
+
+@pytest.mark.parametrize("dtype", ["f8", "f4"])
+def test_homogeneous_float_rows_exact(dtype):
+    # Plain decimals are parsed inline by the row loops, all others by the
+    # full parser; both must give the correctly rounded result.
+    fields = ["0.1", "-0.0", "1e22", "1e23", "9007199254740993", "0.3e-22",
+              "123456789012345678901", "1.5E+3", " 2.5 ", "inf", "-nan",
+              "0.000000000000000000001", "4.9e-324", "1e-5"]
+    res = read([",".join(fields)], dtype=dtype)
+    expected = np.array([[float(f) for f in fields]], dtype=dtype)
+    assert_array_equal(res, expected)
+    assert_array_equal(np.signbit(res), np.signbit(expected))
+
+
+@pytest.mark.parametrize("dtype", ["S", "U"])
+@pytest.mark.parametrize("usecols", [None, [-1, 0]])
+def test_string_length_discovered_while_reading(dtype, usecols):
+    # The result is widened whenever a longer field is found (also by much
+    # more than the current length) and shrunk to the longest one at the end.
+    rows = [["a", "b"], ["ccc", "d"], ["e", "f" * 50], ["gg", "hhhhhhhhh"],
+            ["\xe4", "i"]]
+    data = [",".join(row) + "\n" for row in rows * 100]
+    res = read(data, dtype=dtype, usecols=usecols)
+    expected = np.array(rows * 100)
+    if usecols is not None:
+        expected = expected[:, usecols]
+    if dtype == "S":
+        # "S" uses latin1 for backward compatibility
+        expected = np.char.encode(expected, "latin1")
+    assert res.dtype == np.dtype(f"{dtype}50")
+    assert_array_equal(res, expected)
+
+    # Without any fields longer than one character the length is one
+    res = read(["\n", ",\n"], dtype=dtype)
+    assert res.dtype == np.dtype(f"{dtype}1")
+    assert_array_equal(res, np.zeros((1, 2), dtype=dtype))
+
+
+def test_reader_flexible_dtype_out():
+    # With an unsized string dtype, `out` can have any length (strings are
+    # truncated to it)
+    with Reader(StringIO("a,bbb\ncc,dddd\n"), dtype="U") as reader:
+        out = np.empty((4, 2), dtype="U3")
+        res = reader.read_batch(out=out)
+    assert_array_equal(res, [["a", "bbb"], ["cc", "ddd"]])
+
+
+DATE_STRINGS = ["2020-01-01", "1969-12-31", "2000-02-29", "0001-01-01",
+                "9999-12-31", "2021-06", "1999", " 2020-01-02 ", "NaT", "nat"]
+TIME_STRINGS = ["2020-01-01T00:00:00", "1969-12-31T23:59:59.999999999",
+                "2000-02-29 12:30", "2020-01-01T12", " 2020-01-01T01:02:03 ",
+                "2020-03-04T05:06:07.123456789123", "2020-03-04T05:06:07.1",
+                "NaT"]
+
+
+@pytest.mark.parametrize("unit", ["Y", "M", "W", "D", "h", "m", "s", "ms",
+                                  "us", "ns"])
+@pytest.mark.parametrize("byteorder", ["<", ">"])
+def test_datetime(unit, byteorder):
+    # Strings of a finer unit are truncated, of a coarser unit extended
+    dtype = np.dtype(f"{byteorder}M8[{unit}]")
+    strings = DATE_STRINGS + TIME_STRINGS
+    # The empty string (in the second column) is NaT
+    res = read([f"{s},\n" for s in strings], dtype=dtype)
+    expected = np.array([[s, "NaT"] for s in strings], dtype=dtype)
+    assert_array_equal(res, expected)
+    assert_array_equal(res.view(np.int64), expected.view(np.int64))
+
+
+def test_datetime_parsed_by_numpy():
+    # Strings which are not parsed natively are passed on to NumPy (in this
+    # case the years are not four digits) and fail like for NumPy
+    strings = ["10000-01-01", "-0001-01-01", "1-01-01"]
+    res = read(strings, dtype="M8[D]")
+    assert_array_equal(res, np.array(strings, dtype="M8[D]")[:, np.newaxis])
+
+    with pytest.raises(ValueError,
+            match="could not convert string '2021-02-29' to .* at row 1"):
+        read(["2020-02-29", "2021-02-29"], dtype="M8[D]")
+
+
+def test_timedelta():
+    strings = ["10", "-3", "+4", "NaT", " 7"]
+    res = read(strings, dtype="m8[s]")
+    expected = np.array(strings, dtype="m8[s]")[:, np.newaxis]
+    assert_array_equal(res, expected)
+
+
+def test_categorical():
+    txt = StringIO("1.5,abc,x\n2.5,def,y\n3.5,abc,x\n4.5,,x\n")
+    dt = np.dtype([("a", np.float64), ("b", np.int8), ("c", np.uint32)])
+    arr, categories = read(txt, dtype=dt, categorical=[1, -1],
+                           encoding=None)
+    assert_equal(arr["a"], [1.5, 2.5, 3.5, 4.5])
+    assert_equal(arr["b"], [0, 1, 0, 2])
+    assert_equal(arr["c"], [0, 1, 0, 0])
+    assert_equal(categories[1], ["abc", "def", ""])
+    assert_equal(categories[-1], ["x", "y"])
+
+
+def test_categorical_usecols():
+    txt = StringIO("α,1,β\nγ,2,β\nα,3,δ\n")
+    arr, categories = read(txt, dtype=np.int64, usecols=[2, 1, 0],
+                           categorical=[0, 2], encoding=None)
+    assert_equal(arr, [[0, 1, 0], [0, 2, 1], [1, 3, 0]])
+    assert_equal(categories[0], ["α", "γ"])
+    assert_equal(categories[2], ["β", "δ"])
+
+
+def test_categorical_reader_batches():
+    # The codes are kept consistent between batches
+    lines = [f"{i % 7},v{i % 5}\n" for i in range(100)]
+    with Reader(lines, dtype=np.int32, categorical=[1],
+                batch_size=16) as reader:
+        arr = np.concatenate(list(reader))
+        categories = reader.categories
+    assert_equal(categories[1][arr[:, 1]], [f"v{i % 5}" for i in range(100)])
+    assert_equal(arr[:, 0], [i % 7 for i in range(100)])
+
+
+def test_categorical_errors():
+    with pytest.raises(TypeError,
+            match="categorical column 0 must have a native integer dtype"):
+        read(["a,b"], dtype=np.float64, categorical=[0])
+    with pytest.raises(ValueError, match="must not have a converter"):
+        read(["a,b"], dtype=np.int64, categorical=[0],
+             converters={0: lambda s: 0})
+    # Too many categories for the dtype
+    with pytest.raises(ValueError,
+            match="could not convert string '128' to int8 at row 128"):
+        read([f"{i}" for i in range(200)], dtype=np.int8, categorical=[0])
+
+
+@pytest.mark.parametrize("nrows", [0, 3, 20000])
+@pytest.mark.parametrize("dtype", ["i8", ">f8", "<u2", "c16"])
+def test_order_fortran(nrows, dtype):
+    # Reading from a Python file grows (and finally shrinks) the result
+    content = "".join(f"{i},{i % 13},{i % 7}\n" for i in range(nrows))
+    expected = read(StringIO(content), dtype=dtype)
+    arr = read(StringIO(content), dtype=dtype, order="F")
+    assert arr.flags.f_contiguous
+    assert arr.dtype == np.dtype(dtype)
+    assert_array_equal(arr, expected)
+
+    if nrows > 0:
+        arr = read(StringIO(content), dtype=dtype, max_rows=nrows // 2,
+                   order="F", usecols=[2, 0])
+        assert arr.flags.f_contiguous
+        assert_array_equal(arr, expected[:nrows // 2, [2, 0]])
+
+
+def test_order_fortran_structured():
+    content = "".join(f"{i},{i / 4},x{i % 3}\n" for i in range(10000))
+    dt = np.dtype([("a", ">i4"), ("b", "f8"), ("c", "U3")])
+    expected = read(StringIO(content), dtype=dt, encoding=None)
+    res = read(StringIO(content), dtype=dt, order="F", encoding=None)
+    assert list(res) == ["a", "b", "c"]
+    for name in dt.names:
+        assert res[name].flags.c_contiguous
+        assert res[name].dtype == dt[name]
+        assert_array_equal(res[name], expected[name])
+
+    a, b, c = read(StringIO(content), dtype=dt, unpack=True, encoding=None)
+    assert a.flags.c_contiguous and c.flags.c_contiguous
+    assert_array_equal(c, expected["c"])
+
+
+def test_order_fortran_converters():
+    content = "1,2\n3,4\n5,6\n"
+    arr = read(StringIO(content), converters={1: lambda s: float(s) * 10},
+               order="F")
+    assert arr.flags.f_contiguous
+    assert_array_equal(arr, [[1, 20], [3, 40], [5, 60]])
+    arr = read(StringIO(content), order="F", batch_converters=True,
+               converters={1: lambda s: s.astype(np.float64) * 10})
+    assert arr.flags.f_contiguous
+    assert_array_equal(arr, [[1, 20], [3, 40], [5, 60]])
+    # Object dtypes are read in C order and copied
+    expected = read(StringIO(content), dtype=object)
+    arr = read(StringIO(content), dtype=object, order="F")
+    assert arr.flags.f_contiguous
+    assert_array_equal(arr, expected)
+
+
+def test_stats():
+    content = "1,2,3\n4,5,6\n\n7,8,9\n"
+    stats = {}
+    arr = read(StringIO(content), stats=stats)
+    assert_array_equal(arr, [[1, 2, 3], [4, 5, 6], [7, 8, 9]])
+    assert stats["rows_tokenized"] == 3
+    assert stats["fields_tokenized"] == 9
+    assert stats["bytes_consumed"] > 0
+    assert stats["buffer_refills"] > 0
+    assert stats["python_converter_calls"] == 0
+    assert all(value >= 0 for value in stats.values())
+    assert stats["tokenize_ns"] >= stats["nextbuf_ns"]
+
+
+def test_stats_converters():
+    content = "1,2\n3,4\n5,6\n"
+    stats = {}
+    read(StringIO(content), converters={1: float}, stats=stats)
+    assert stats["python_converter_calls"] == 3
+    stats = {}
+    read(StringIO(content), converters={0: np.char.strip, 1: np.char.strip},
+         batch_converters=True, stats=stats)
+    assert stats["python_converter_calls"] == 2
+
+
+@pytest.mark.parametrize("num_threads", [1, 4])
+def test_stats_file(tmp_path, num_threads):
+    nrows = 300_000
+    fname = tmp_path / "stats.csv"
+    fname.write_text("1.5,2,3.25\n" * nrows)
+    stats = {}
+    arr = read(fname, num_threads=num_threads, stats=stats)
+    assert arr.shape == (nrows, 3)
+    assert stats["rows_tokenized"] == nrows
+    assert stats["fields_tokenized"] == 3 * nrows
+    assert stats["bytes_consumed"] == len("1.5,2,3.25\n") * nrows
+
+
+def test_stats_growth():
+    # Without knowing the number of rows the result is reallocated
+    content = "1\n" * 100_000
+    stats = {}
+    read(StringIO(content), stats=stats)
+    assert stats["output_reallocs"] > 1
+    assert stats["output_bytes_copied"] > 0
+
+
+def test_out_offset():
+    out = np.full((5, 2), -1.0)
+    res = read(StringIO("1,2\n3,4\n"), out=out)
+    assert_array_equal(res, [[1, 2], [3, 4]])
+    assert np.shares_memory(res, out)
+    res = read(StringIO("5,6\n7,8\n9,10\n11,12\n"), out=out, out_offset=2)
+    assert_array_equal(res, [[5, 6], [7, 8], [9, 10]])
+    # Only the rows which fit are read
+    assert_array_equal(out, [[1, 2], [3, 4], [5, 6], [7, 8], [9, 10]])
+    res = read(StringIO("1,2\n"), out=out, out_offset=5)
+    assert res.shape == (0, 2)
+
+
+def test_out_structured_memmap(tmp_path):
+    dtype = np.dtype([("a", "i4"), ("b", "f8")])
+    out = np.memmap(tmp_path / "out.dat", dtype=dtype, mode="w+", shape=(4,))
+    fname = tmp_path / "data.csv"
+    fname.write_text("1,1.5\n2,2.5\n")
+    read(fname, dtype=dtype, out=out)
+    read(fname, dtype=dtype, out=out, out_offset=2, max_rows=1)
+    out.flush()
+    expected = np.array([(1, 1.5), (2, 2.5), (1, 1.5), (0, 0)], dtype=dtype)
+    assert_array_equal(np.fromfile(tmp_path / "out.dat", dtype=dtype),
+                       expected)
+
+
+def test_out_errors():
+    data = "1,2\n3,4\n"
+    with pytest.raises(ValueError, match="dtype"):
+        read(StringIO(data), out=np.zeros((2, 2), dtype=np.int32))
+    with pytest.raises(ValueError, match="dimensional"):
+        read(StringIO(data), out=np.zeros(4))
+    with pytest.raises(ValueError, match="C-contiguous"):
+        read(StringIO(data), out=np.zeros((2, 4))[:, ::2])
+    with pytest.raises(ValueError, match="columns"):
+        read(StringIO(data), out=np.zeros((2, 3)))
+    with pytest.raises(ValueError, match="out_offset"):
+        read(StringIO(data), out=np.zeros((2, 2)), out_offset=3)
+    with pytest.raises(ValueError, match="out_offset"):
+        read(StringIO(data), out=np.zeros((2, 2)), out_offset=-1)
+    with pytest.raises(ValueError, match="order"):
+        read(StringIO(data), out=np.zeros((2, 2)), order="F")
+
+
+@pytest.mark.parametrize("every", [1, 3, 1024])
+def test_row_index(tmp_path, every):
+    fname = tmp_path / "rows.csv"
+    fname.write_text("".join(f"{i},{2 * i}\n" for i in range(100)))
+    index = build_row_index(fname, every=every)
+    assert len(index) == 100 // every + 1
+    expected = read(fname, dtype=np.int64)
+    for skiprows, max_rows in [(0, 5), (7, 10), (50, None), (99, 5)]:
+        res = read(fname, dtype=np.int64, skiprows=skiprows,
+                   max_rows=max_rows, row_index=index, ndmin=2)
+        stop = None if max_rows is None else skiprows + max_rows
+        assert_array_equal(res, expected[skiprows:stop])
+    for skiprows in [100, 150]:
+        res = read(fname, dtype=np.int64, skiprows=skiprows, row_index=index)
+        assert res.size == 0
+
+
+def test_row_index_quotes_save_and_append(tmp_path):
+    fname = tmp_path / "rows.csv"
+    fname.write_text('a,"x\ny"\nb,c\n\n# comment\nd,"e,""f"""\n')
+    index = build_row_index(fname, every=2)
+    index.save(tmp_path / "rows.csv.index.npz")
+    index = RowIndex.load(tmp_path / "rows.csv.index.npz")
+    # Quoted newlines, empty and comment lines count as one row each
+    res = read(fname, dtype=str, skiprows=1, row_index=index)
+    assert_array_equal(res, [["b", "c"], ["d", 'e,"f"']])
+    res = read(fname, dtype=str, skiprows=4, row_index=index)
+    assert_array_equal(res, [["d", 'e,"f"']])
+    # The index stays valid when rows are appended to the file
+    with open(fname, "a") as f:
+        f.write("g,h\ni,j\n")
+    res = read(fname, dtype=str, skiprows=5, row_index=index)
+    assert_array_equal(res, [["g", "h"], ["i", "j"]])
+
+
+def test_row_index_errors(tmp_path):
+    fname = tmp_path / "rows.csv"
+    fname.write_text("1,2\n3,4\n5,6\n")
+    index = build_row_index(fname, every=1)
+    with pytest.raises(ValueError, match="different delimiter"):
+        read(fname, delimiter=";", row_index=index)
+    with pytest.raises(ValueError, match="natively"):
+        read(StringIO("1,2\n"), row_index=index)
+    with pytest.raises(ValueError, match="natively"):
+        build_row_index(StringIO("1,2\n"))
+    fname.write_text("10,20\n30,40\n")
+    with pytest.raises(ValueError, match="does not match"):
+        read(fname, skiprows=2, row_index=index)
+
+
+@pytest.mark.parametrize("skiprows", [0, 1, 2, 3, 10])
+def test_skiprows_iterable(skiprows):
+    # Each line of an iterable is its own buffer
+    lines = ["a,b\n", "\n", "c,d\n", "1,2\n", "3,4\n"]
+    expected = read(StringIO("".join(lines)), skiprows=skiprows,
+                    dtype=str, ndmin=2)
+    res = read(lines, skiprows=skiprows, dtype=str, ndmin=2)
+    assert_array_equal(res, expected)
+    if skiprows == 3:
+        assert_array_equal(res, [["1", "2"], ["3", "4"]])
+
+
+@pytest.mark.parametrize("comment", ["#", "//", ("//", "/*")])
+def test_comment_lines(comment):
+    start = comment if isinstance(comment, str) else comment[-1]
+    header = "".join(f'{start} line {i}, "unbalanced\r\n' for i in range(1000))
+    content = f"{header}1,2\n{start}\n3,4{start} trailing\r\n"
+    res = read(StringIO(content), comment=comment)
+    assert_array_equal(res, [[1, 2], [3, 4]])
+    res = read(StringIO(content), comment=comment, skiprows=999)
+    assert_array_equal(res, [[1, 2], [3, 4]])
+
+
+@pytest.mark.parametrize("num_threads", [1, 3, None])
+def test_read_many(tmp_path, num_threads):
+    fnames = []
+    for i in range(7):
+        fname = tmp_path / f"shard{i}.csv"
+        # Shards of different lengths, one empty and one without a newline
+        rows = "".join(f"{i},{j},{i * j}.5\n" for j in range(i * 100))
+        fname.write_text("a,b,c\n" + rows.rstrip("\n" if i == 3 else ""))
+        fnames.append(fname)
+    for dtype, usecols in [(np.float64, None), ("i8,i8,f8", None),
+                           (np.int64, [1, 0])]:
+        expected = np.concatenate(
+            [read(f, skiprows=1, dtype=dtype, usecols=usecols, ndmin=2)
+             for f in fnames if f.stat().st_size > 6])
+        res = read_many(fnames, skiprows=1, dtype=dtype, usecols=usecols,
+                        num_threads=num_threads)
+        assert res.dtype == expected.dtype
+        assert_array_equal(res, expected)
+
+
+def test_read_many_fallback(tmp_path):
+    fnames = [tmp_path / "a.csv", tmp_path / "b.csv.gz"]
+    fnames[0].write_text("1,2\n3,4\n")
+    with gzip.open(fnames[1], "wt") as f:
+        f.write("5,6\n")
+    res = read_many(fnames, converters={0: lambda s: float(s) * 2})
+    assert_array_equal(res, [[2, 2], [6, 4], [10, 6]])
+    res = read_many(fnames + [StringIO("7,8\n")], dtype=int)
+    assert_array_equal(res, [[1, 2], [3, 4], [5, 6], [7, 8]])
+
+    fnames[1] = tmp_path / "bad.csv"
+    fnames[1].write_text("5,x\n")
+    with pytest.raises(ValueError, match="could not convert string 'x'"):
+        read_many(fnames, num_threads=2)
+    fnames[1].write_text("5,6,7\n")
+    with pytest.raises(ValueError, match="has 3 columns"):
+        read_many(fnames, num_threads=2)
+    with pytest.raises(ValueError, match="at least one file"):
+        read_many([])
+
+
+class _ChunkedRawFile(io.RawIOBase):
+    # A binary file returning at most `n` bytes per `readinto` call
+    def __init__(self, data, n):
+        self.data = data
+        self.n = n
+        self.sizes = []
+
+    def readable(self):
+        return True
+
+    def readinto(self, buf):
+        self.sizes.append(len(buf))
+        n = min(len(buf), self.n, len(self.data))
+        buf[:n] = self.data[:n]
+        self.data = self.data[n:]
+        return n
+
+
+@pytest.mark.parametrize("n", [1, 7, 1 << 30])
+def test_binary_file_readinto(n):
+    content = "a,é一\n\U0001F600,b\r\n# c\n" * 100
+    expected = read(StringIO(content), dtype=str, encoding="utf-8")
+    f = _ChunkedRawFile(content.encode("utf-8"), n)
+    res = read(f, dtype=str, encoding="utf-8")
+    assert_array_equal(res, expected)
+    # Without an encoding, binary files are latin1 as before
+    f = _ChunkedRawFile(content.encode("utf-8"), n)
+    res = read(f, dtype=str)
+    assert_array_equal(res, read(StringIO(content.encode("utf-8").decode(
+        "latin1")), dtype=str))
+
+
+def test_binary_file_readinto_grows():
+    f = _ChunkedRawFile(b"1,2\n" * (1 << 20), 1 << 30)
+    res = read(f, dtype=np.int8)
+    assert res.shape == (1 << 20, 2)
+    assert f.sizes[0] == 1 << 16
+    assert max(f.sizes) > 1 << 16
+
+
+def test_binary_file_errors():
+    f = _ChunkedRawFile(b"1,2\n3,\xc3", 3)
+    with pytest.raises(UnicodeDecodeError):
+        read(f, encoding="utf-8")
+    # Encodings which are not decoded natively still work
+    f = io.BytesIO("a,\u20ac\n".encode("cp1252"))
+    res = read(f, dtype=str, encoding="cp1252")
+    assert_array_equal(res, [["a", "\u20ac"]])
+
+
+def test_missing_values():
+    txt = StringIO("1,NA,3\n,5, 6\n7, -999 ,\n")
+    arr = read(txt, missing_values={None: "NA", 1: ["-999"]},
+               filling_values={2: -1})
+    assert_array_equal(arr, [[1, np.nan, 3], [np.nan, 5, 6],
+                             [7, np.nan, -1]])
+    # Empty fields are missing as soon as missing values are handled
+    arr = read(["1,", " ,3"], dtype=np.int64, filling_values=-2)
+    assert_array_equal(arr, [[1, -2], [-2, 3]])
+    # Missing fields are not passed to the converters
+    arr = read(["1,x", "NA,y"], dtype=np.int8, usecols=[0],
+               missing_values="NA", converters={0: lambda s: int(s) + 1})
+    assert_array_equal(arr, [[2], [0]])
+
+
+def test_missing_values_strings():
+    # The discovered string length includes the fill value
+    arr = read(["a,NA", "b,c"], dtype="U", missing_values="NA",
+               filling_values="missing", encoding=None)
+    assert arr.dtype == "U7"
+    assert_array_equal(arr, [["a", "missing"], ["b", "c"]])
+    dt = np.dtype([("a", "S3"), ("b", np.float32)])
+    arr = read(["x,1", ",NA"], dtype=dt, missing_values=["NA"])
+    assert_array_equal(arr["a"], [b"x", b""])
+    assert_array_equal(arr["b"], [1, np.nan])
+
+
+def test_missing_values_usemask():
+    arr = read(StringIO("1,2,NA\nNA,5,6\n7,,9\n"), usecols=[2, 0, 1],
+               missing_values="NA", usemask=True)
+    assert isinstance(arr, np.ma.MaskedArray)
+    assert_array_equal(arr.mask, [[True, False, False],
+                                  [False, True, False],
+                                  [False, False, True]])
+    assert_array_equal(arr.filled(0), [[0, 1, 2], [6, 0, 5], [9, 7, 0]])
+
+    dt = np.dtype([("a", np.int32), ("b", np.float64)])
+    arr = read(["1,", "-,2.5"], dtype=dt, missing_values="-", usemask=True)
+    assert_array_equal(arr.mask["a"], [False, True])
+    assert_array_equal(arr.mask["b"], [True, False])
+    assert_array_equal(arr.data["b"], [np.nan, 2.5])
+
+
+def test_missing_values_errors():
+    with pytest.raises(ValueError, match="usemask cannot be used"):
+        read(["1,2"], usemask=True, unpack=True)
+    with pytest.raises(ValueError, match="batch_converters"):
+        read(["1,2"], missing_values="NA", batch_converters=True,
+             converters={0: np.asarray})
+    with pytest.raises(ValueError):
+        read(["1,2"], dtype=np.int64, filling_values="abc")
+    with pytest.raises(ValueError, match="missing values specified for"):
+        read(["1,2"], missing_values={5: "NA"})
+    with pytest.raises(ValueError,
+            match="could not convert string 'NB' to float64"):
+        read(["1,NA", "NB,2"], missing_values="NA")
+
+
+def test_read_arrow():
+    pa = pytest.importorskip("pyarrow")
+    dt = np.dtype([("a", ">i4"), ("s", "U1"), ("t", "M8[s]"),
+                   ("f", np.float64), ("b", bool)])
+    txt = StringIO('1,h\u00e9llo,2020-01-01T00:00:00,1.5,1\n'
+                   '2,,NaT,NA,0\n'
+                   '3,"a,b",2021-01-01T00:00:00,,1\n')
+    rb = pa.record_batch(read_arrow(txt, dtype=dt, missing_values="NA",
+                                    encoding=None))
+    assert rb.schema.names == ["a", "s", "t", "f", "b"]
+    assert rb.schema.field("s").type == pa.large_string()
+    assert rb.schema.field("t").type == pa.timestamp("s")
+    assert rb.column(0).to_pylist() == [1, 2, 3]
+    assert rb.column(1).to_pylist() == ["h\u00e9llo", None, "a,b"]
+    assert rb.column(2).null_count == 1
+    assert rb.column(3).to_pylist() == [1.5, None, None]
+    assert rb.column(4).to_pylist() == [True, False, True]
+
+
+def test_read_arrow_homogeneous():
+    pa = pytest.importorskip("pyarrow")
+    batch = read_arrow(["a,bb", "\u4e00,"], dtype=str, missing_values=[],
+                       encoding=None)
+    assert batch.names == ["f0", "f1"]
+    assert len(batch) == 2
+    rb = pa.record_batch(batch)
+    assert rb.column(0).to_pylist() == ["a", "\u4e00"]
+    assert rb.column(1).to_pylist() == ["bb", None]
+    # Each export is independent
+    rb = pa.record_batch(read_arrow([f"{i},{i / 2}" for i in range(1000)],
+                                    usecols=[1]))
+    assert_array_equal(rb.column(0).to_numpy(), np.arange(1000) / 2)
+
+
+def test_read_arrow_num_rows():
+    # Does not need pyarrow: structured reads return a tuple of columns
+    dt = np.dtype([("a", np.int32), ("s", "U3"), ("f", np.float64),
+                   ("b", bool), ("c", np.int8)])
+    batch = read_arrow(["1,x,1.5,1,3", "2,y,2.5,0,4", "3,z,3.5,1,5"],
+                       dtype=dt)
+    assert batch.names == ["a", "s", "f", "b", "c"]
+    assert len(batch) == batch.num_rows == 3
+
+
+def test_read_arrow_errors():
+    batch = read_arrow(["1,2"], dtype=np.int8)
+    schema, array = batch.__arrow_c_array__()
+    assert type(schema).__name__ == type(array).__name__ == "PyCapsule"
+    with pytest.raises(TypeError, match="cannot be exported to Arrow"):
+        read_arrow(["1+2j"], dtype=np.complex128)
+    with pytest.raises(TypeError, match="cannot be exported to Arrow"):
+        read_arrow(["2020-01-01"], dtype="M8[D]")
+    with pytest.raises(ValueError, match="must not have a converter"):
+        read_arrow(["a"], dtype="U5", converters={0: str})
+
+
+@pytest.mark.parametrize("max_rows", [None, 1, 500])
+def test_out_file(tmp_path, monkeypatch, max_rows):
+    # A small initial size, so that the file is grown several times
+    monkeypatch.setattr(_readers, "_MEMMAP_MIN_BYTES", 64)
+    content = "".join(f"{i},{i * 2}\n" for i in range(1000))
+    expected = read(StringIO(content), dtype=np.int32, max_rows=max_rows)
+    fname = tmp_path / "result.bin"
+    arr = read(StringIO(content), dtype=np.int32, max_rows=max_rows,
+               out_file=fname)
+    assert isinstance(arr, np.memmap)
+    assert_array_equal(arr, expected)
+    assert fname.stat().st_size == expected.nbytes
+
+
+def test_out_file_structured(tmp_path):
+    dt = np.dtype([("a", np.float64), ("b", np.uint8)])
+    arr, categories = read(["1.5,x", "2.5,y", "3.5,x"], dtype=dt,
+                           categorical=[1], out_file=tmp_path / "res.bin")
+    assert isinstance(arr, np.memmap)
+    assert_array_equal(arr["a"], [1.5, 2.5, 3.5])
+    assert_array_equal(arr["b"], [0, 1, 0])
+    assert_equal(categories[1], ["x", "y"])
+    # An empty result cannot be mapped
+    arr = read([], dtype=dt, out_file=tmp_path / "empty.bin")
+    assert arr.shape == (0,)
+    with pytest.raises(ValueError, match="out_file cannot be used"):
+        read(["1,2"], out_file=tmp_path / "res.bin", order="F")
+    # The length of the strings is only known after reading all rows
+    for dtype in ["U", "S"]:
+        with pytest.raises(ValueError, match="out_file cannot be used"):
+            read(["a,bb", "ccc,d"], dtype=dtype,
+                 out_file=tmp_path / "res.bin")
+
+
+def test_trim_buffers():
+    # Many fields and a long quoted one, which grow the tokenizer buffers
+    content = ",".join(str(i) for i in range(20)) + ',"' + "1" * 100 + '"\n'
+    trim_buffers()
+    stats = {}
+    arr = read(StringIO(content), stats=stats)
+    assert stats["fields_regrowths"] > 0
+    assert stats["field_buffer_regrowths"] > 0
+    # The buffers are kept at their size for the next read
+    stats = {}
+    assert_array_equal(read(StringIO(content), stats=stats), arr)
+    assert stats["fields_regrowths"] == 0
+    assert stats["field_buffer_regrowths"] == 0
+    assert trim_buffers() > 0
+    assert trim_buffers() == 0
+    stats = {}
+    assert_array_equal(read(StringIO(content), stats=stats), arr)
+    assert stats["fields_regrowths"] > 0
@@ -1,4 +1,6 @@
 
+import os
+import tempfile
 from os import path
 
 
@@ -26,6 +28,43 @@ with open('README.rst', 'r') as f:
     _long_descr = f.read()
 
 
+# Libraries used to read compressed files natively: (header, library, macro)
+_COMPRESSION_LIBRARIES = [
+    ('zlib.h', 'z', 'HAVE_ZLIB'),
+    ('bzlib.h', 'bz2', 'HAVE_BZLIB'),
+    ('lzma.h', 'lzma', 'HAVE_LZMA'),
+]
+
+
+def find_compression_libraries():
+    """
+    Return the libraries and macros of the decompression libraries found
+    (the header must compile and link).  Files using any other compression
+    are decompressed by Python.
+    """
+    from distutils.ccompiler import new_compiler
+    from distutils.errors import CompileError, LinkError
+    from distutils.sysconfig import customize_compiler
+
+    compiler = new_compiler()
+    customize_compiler(compiler)
+    libraries, macros = [], []
+    with tempfile.TemporaryDirectory() as tmpdir:
+        for header, library, macro in _COMPRESSION_LIBRARIES:
+            src = os.path.join(tmpdir, library + '.c')
+            with open(src, 'w') as f:
+                f.write(f'#include <{header}>\nint main(void) {{ return 0; }}\n')
+            try:
+                objects = compiler.compile([src], output_dir=tmpdir)
+                compiler.link_executable(objects, library, output_dir=tmpdir,
+                                         libraries=[library])
+            except (CompileError, LinkError):
+                continue
+            libraries.append(library)
+            macros.append((macro, None))
+    return libraries, macros
+
+
 def configuration(parent_package='', top_path=None):
     import numpy
     from numpy.distutils.misc_util import Configuration
@@ -34,13 +73,19 @@ def configuration(parent_package='', top_path=None):
     # config.add_data_dir('tests')
     config.add_subpackage('npreadtext')
     cfiles = ['_readtextmodule.c',
-              'growth.c', 'rows.c', 'tokenize.c.src',
-              'conversions.c', 'str_to_int.c',
-              'stream_pyobject.c', 'field_types.c']
+              'growth.c', 'rows.c', 'tokenize.c.src', 'row_loops.c.src',
+              'conversions.c.src', 'str_to_int.c', 'str_to_double.c.src',
+              'stream_pyobject.c', 'stream_file.c', 'stream_compressed.c',
+              'raw_scan.c', 'parallel.c', 'simd_scan.c', 'field_types.c',
+              'categories.c', 'read_stats.c', 'row_index.c',
+              'missing.c', 'arrow.c', 'arena.c']
+    libraries, macros = find_compression_libraries()
     config.add_extension(
             'npreadtext._readtextmodule',
             sources=[path.join('src', t) for t in cfiles],
-            include_dirs=[numpy.get_include(), "src"],)
+            include_dirs=[numpy.get_include(), "src"],
+            libraries=libraries,
+            define_macros=macros,)
     return config
 
 
@@ -3,6 +3,7 @@
 //
 
 #include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 
 #define PY_SSIZE_T_CLEAN
@@ -12,9 +13,72 @@
 
 #include "parser_config.h"
 #include "stream_pyobject.h"
+#include "stream_file.h"
+#include "stream_compressed.h"
 #include "field_types.h"
 #include "rows.h"
+#include "read_stats.h"
+#include "row_index.h"
+#include "arrow.h"
+#include "arena.h"
 #include "str_to_int.h"
+#include "str_to_double.h"
+#include "simd_scan.h"
+
+
+//
+// Check that `out` can be filled for the `dtype` (a string dtype whose
+// length is discovered accepts any length).  Returns -1 with an error set
+// if not.
+//
+static int
+check_out_array(PyObject *out, PyArray_Descr *dtype, bool homogeneous)
+{
+    if (!PyArray_Check(out)) {
+        PyErr_SetString(PyExc_TypeError, "out must be an array");
+        return -1;
+    }
+    PyArrayObject *out_arr = (PyArrayObject *)out;
+    bool equivalent = PyArray_EquivTypes(PyArray_DESCR(out_arr), dtype);
+    if (!equivalent && homogeneous && dtype->elsize == 0
+            && PyDataType_ISSTRING(dtype)) {
+        /* The string length is discovered ("S0" or "U0"), any will do */
+        equivalent = PyArray_DESCR(out_arr)->type_num == dtype->type_num;
+    }
+    if (PyArray_NDIM(out_arr) != (homogeneous ? 2 : 1) || !equivalent) {
+        PyErr_Format(PyExc_ValueError,
+                "out must be a %d-dimensional array with dtype %S.",
+                homogeneous ? 2 : 1, dtype);
+        return -1;
+    }
+    if (!PyArray_ISCARRAY(out_arr)) {
+        PyErr_SetString(PyExc_ValueError,
+                "out must be a writeable, aligned, C-contiguous array.");
+        return -1;
+    }
+    return 0;
+}
+
+
+/*
+ * Check that a column-major result can be read for `dtype`, whose fields
+ * must map to the (flat) fields of the dtype.
+ */
+static int
+check_column_major_dtype(PyArray_Descr *dtype, npy_intp num_fields,
+        bool homogeneous)
+{
+    bool flat_fields = homogeneous || (dtype->names != NULL
+            && num_fields == PyTuple_GET_SIZE(dtype->names));
+    if (PyDataType_FLAGCHK(dtype, NPY_NEEDS_INIT)
+            || dtype->elsize == 0 || !flat_fields) {
+        PyErr_Format(PyExc_TypeError,
+                "a column-major result is not supported for dtype %S, it "
+                "must not contain objects or nested fields.", dtype);
+        return -1;
+    }
+    return 0;
+}
 
 
 //
@@ -33,12 +97,19 @@
 // If `dtype` is given and it is compound, and `usecols` is None, then the
 // number of columns in the file must match the number of fields in `dtype`.
 //
+// If `out` is not Py_None, the rows are stored in place starting at row
+// `out_offset` of it (reading at most as many rows as fit) and the view
+// of the rows which were filled in is returned.
+//
 static PyObject *
 _readtext_from_stream(stream *s, parser_config *pc,
                       PyObject *usecols, Py_ssize_t skiprows, Py_ssize_t max_rows,
-                      PyObject *converters, PyObject *dtype)
+                      PyObject *converters, PyObject *dtype, int num_threads,
+                      read_stats *stats, PyObject *out, Py_ssize_t out_offset)
 {
+    PyObject *res = NULL;
     PyArrayObject *arr = NULL;
+    PyArrayObject *data_array = NULL;
     PyArray_Descr *out_dtype = NULL;
     int32_t *cols;
     int ncols;
@@ -58,6 +129,37 @@ _readtext_from_stream(stream *s, parser_config *pc,
     }
     bool homogeneous = num_fields == 1 && ft[0].descr == out_dtype;
 
+    if (pc->column_major && check_column_major_dtype(
+            out_dtype, num_fields, homogeneous) < 0) {
+        goto finish;
+    }
+
+    if (out != Py_None) {
+        if (pc->column_major) {
+            PyErr_SetString(PyExc_ValueError,
+                    "a column-major result cannot be read into out.");
+            goto finish;
+        }
+        if (check_out_array(out, out_dtype, homogeneous) < 0) {
+            goto finish;
+        }
+        npy_intp length = PyArray_DIM((PyArrayObject *)out, 0);
+        if (out_offset < 0 || out_offset > length) {
+            PyErr_Format(PyExc_ValueError,
+                    "out_offset must be between 0 and the length of out "
+                    "(%zd), but is %zd.", length, out_offset);
+            goto finish;
+        }
+        data_array = (PyArrayObject *)PySequence_GetSlice(
+                out, out_offset, length);
+        if (data_array == NULL) {
+            goto finish;
+        }
+        if (max_rows < 0 || max_rows > length - out_offset) {
+            max_rows = length - out_offset;
+        }
+    }
+
     if (usecols == Py_None) {
         ncols = num_fields;
         cols = NULL;
@@ -67,18 +169,37 @@ _readtext_from_stream(stream *s, parser_config *pc,
         cols = PyArray_DATA(usecols);
     }
 
+    npy_intp row_count;
     arr = read_rows(
             s, max_rows, num_fields, ft, pc,
             ncols, cols, skiprows, converters,
-            NULL, out_dtype, homogeneous);
+            data_array, out_dtype, homogeneous, num_threads, stats,
+            &row_count);
     if (arr == NULL) {
         goto finish;
     }
+    if (data_array != NULL) {
+        /* Return the view of the rows which were filled in */
+        res = PySequence_GetSlice((PyObject *)arr, 0, row_count);
+        Py_DECREF(arr);
+        arr = NULL;
+    }
+    else if (pc->column_major && !homogeneous) {
+        /* Return the fields, which are stored one after the other */
+        PyObject *fields = column_major_fields(arr, num_fields, ft);
+        Py_DECREF(arr);
+        arr = NULL;
+        res = fields;
+    }
+    else {
+        res = (PyObject *)arr;
+    }
 
   finish:
+    Py_XDECREF(data_array);
     Py_XDECREF(out_dtype);
     field_types_xclear(num_fields, ft);
-    return (PyObject *)arr;
+    return res;
 }
 
 
@@ -100,6 +221,163 @@ parse_control_character(PyObject *obj, Py_UCS4 *character)
 }
 
 
+/*
+ * Parse the comment, which is a single (or no) character, or a tuple of
+ * multi-character comments which all start with the same character.
+ */
+static int
+parse_comments(PyObject *obj, parser_config *pc)
+{
+    if (PyUnicode_Check(obj)) {
+        pc->num_comments = 0;
+        return parse_control_character(obj, &pc->comment);
+    }
+    if (!PyTuple_Check(obj) || PyTuple_GET_SIZE(obj) < 1
+            || PyTuple_GET_SIZE(obj) > MAX_COMMENTS) {
+        PyErr_Format(PyExc_TypeError,
+                "comment must be a unicode string or a tuple of at most %d "
+                "unicode strings; but got: %.100R", MAX_COMMENTS, obj);
+        return 0;
+    }
+    int num_comments = (int)PyTuple_GET_SIZE(obj);
+    for (int i = 0; i < num_comments; i++) {
+        PyObject *comment = PyTuple_GET_ITEM(obj, i);
+        if (!PyUnicode_Check(comment) || PyUnicode_GET_LENGTH(comment) < 1
+                || PyUnicode_GET_LENGTH(comment) > MAX_COMMENT_LENGTH) {
+            PyErr_Format(PyExc_ValueError,
+                    "comments must be unicode strings with 1 to %d "
+                    "characters; but got: %.100R", MAX_COMMENT_LENGTH, obj);
+            return 0;
+        }
+        int length = (int)PyUnicode_GET_LENGTH(comment);
+        for (int k = 0; k < length; k++) {
+            Py_UCS4 c = PyUnicode_READ_CHAR(comment, k);
+            if (c == '\r' || c == '\n') {
+                PyErr_Format(PyExc_ValueError,
+                        "comments must not contain line ends; but got: "
+                        "%.100R", obj);
+                return 0;
+            }
+            pc->comments[i][k] = c;
+        }
+        pc->comment_lengths[i] = length;
+        if (pc->comments[i][0] != pc->comments[0][0]) {
+            PyErr_Format(PyExc_ValueError,
+                    "multiple comments must start with the same character; "
+                    "but got: %.100R", obj);
+            return 0;
+        }
+    }
+    pc->num_comments = num_comments;
+    pc->comment = pc->comments[0][0];
+    return 1;
+}
+
+
+static const parser_config default_parser_config = {
+    .delimiter = ',',
+    .comment = '#',
+    .num_comments = 0,
+    .quote = '"',
+    .imaginary_unit = 'j',
+    .allow_float_for_int = true,
+    .allow_embedded_newline = true,
+    .delimiter_is_whitespace = false,
+    .ignore_leading_whitespace = false,
+    .python_byte_converters = false,
+    .c_byte_converters = false,
+    .batch_converters = false,
+    .column_major = false,
+};
+
+
+/*
+ * Finish setting up the parser config after parsing the arguments and
+ * check the dtype.  Returns -1 with an error set on failure.
+ */
+static int
+finalize_parser_config(parser_config *pc, PyObject *dtype,
+        int python_byte_converters, int c_byte_converters)
+{
+    pc->python_byte_converters = python_byte_converters;
+    pc->c_byte_converters = c_byte_converters;
+
+    if (pc->delimiter == (Py_UCS4)-1) {
+        pc->delimiter_is_whitespace = true;
+        /* Ignore leading whitespace to match `string.split(None)` */
+        pc->ignore_leading_whitespace = true;
+    }
+
+    if (dtype != NULL && !PyArray_DescrCheck(dtype) ) {
+        PyErr_SetString(PyExc_TypeError,
+                "internal error: dtype must be provided and be a NumPy dtype");
+        return -1;
+    }
+    return 0;
+}
+
+
+/*
+ * A row index scans the undecoded bytes, so the file must be read natively
+ * and non-latin1 encodings need ASCII control characters.  Returns -1 with
+ * an error set if the index cannot be used.
+ */
+static int
+check_row_index_config(parser_config *pc, const char *encoding,
+        int native_file, const char *compression)
+{
+    if (!native_file || compression != NULL) {
+        PyErr_SetString(PyExc_ValueError,
+                "a row index requires an uncompressed file which is read "
+                "natively.");
+        return -1;
+    }
+    bool raw_bytes;
+    if (native_encoding_check(encoding, &raw_bytes) < 0) {
+        return -1;
+    }
+    Py_UCS4 max_char = raw_bytes ? 255 : 127;
+    if ((!pc->delimiter_is_whitespace && pc->delimiter > max_char)
+            || (pc->quote != (Py_UCS4)-1 && pc->quote > max_char)
+            || (pc->comment != (Py_UCS4)-1 && pc->comment > max_char)) {
+        PyErr_Format(PyExc_ValueError,
+                "a row index requires ASCII delimiter, quote and comment "
+                "characters for the encoding %s.", encoding);
+        return -1;
+    }
+    return 0;
+}
+
+
+static stream *
+open_stream(PyObject *file, char *encoding, int filelike, int binary_file,
+        int native_file, char *compression)
+{
+    stream *s;
+    if (native_file && compression != NULL) {
+        return stream_compressed_file(file, encoding, compression);
+    }
+    else if (native_file) {
+        /* `file` is a path or file descriptor, errors are informative */
+        return stream_native_file(file, encoding);
+    }
+    else if (binary_file) {
+        /* The file is decoded like a native one, read with `readinto` */
+        return stream_python_binary_file(file, encoding);
+    }
+    if (filelike) {
+        s = stream_python_file(file, encoding);
+    }
+    else {
+        s = stream_python_iterable(file, encoding);
+    }
+    if (s == NULL) {
+        PyErr_Format(PyExc_RuntimeError, "Unable to access the file.");
+    }
+    return s;
+}
+
+
 static PyObject *
 _readtext_from_file_object(PyObject *self, PyObject *args, PyObject *kwargs)
 {
@@ -108,7 +386,10 @@ _readtext_from_file_object(PyObject *self, PyObject *args, PyObject *kwargs)
                              "max_rows", "converters", "dtype",
                              "encoding", "filelike",
                              "byte_converters", "c_byte_converters",
-                             NULL};
+                             "batch_converters", "native_file",
+                             "compression", "num_threads", "column_major",
+                             "stats", "out", "out_offset", "row_index",
+                             "row_index_every", "binary_file", NULL};
     PyObject *file;
     Py_ssize_t skiprows = 0;
     Py_ssize_t max_rows = -1;
@@ -118,70 +399,671 @@ _readtext_from_file_object(PyObject *self, PyObject *args, PyObject *kwargs)
     PyObject *dtype = Py_None;
     char *encoding = NULL;
     int filelike = 1;
+    int native_file = 0;
+    char *compression = NULL;
+    int num_threads = 1;
 
-    parser_config pc = {
-        .delimiter = ',',
-        .comment = '#',
-        .quote = '"',
-        .imaginary_unit = 'j',
-        .allow_float_for_int = true,
-        .allow_embedded_newline = true,
-        .delimiter_is_whitespace = false,
-        .ignore_leading_whitespace = false,
-        .python_byte_converters = false,
-        .c_byte_converters = false,
-    };
+    parser_config pc = default_parser_config;
     int python_byte_converters = 0;
     int c_byte_converters = 0;
+    int batch_converters = 0;
+    int column_major = 0;
+    PyObject *stats_dict = Py_None;
+    PyObject *out = Py_None;
+    Py_ssize_t out_offset = 0;
+    PyObject *row_index = Py_None;
+    Py_ssize_t row_index_every = 0;
+    int binary_file = 0;
 
     PyObject *arr = NULL;
 
     if (!PyArg_ParseTupleAndKeywords(
-            args, kwargs, "O|$O&O&O&O&OnnOOzppp", kwlist,
+            args, kwargs, "O|$O&O&O&O&OnnOOzpppppzipOOnOnp", kwlist,
             &file,
             &parse_control_character, &pc.delimiter,
-            &parse_control_character, &pc.comment,
+            &parse_comments, &pc,
             &parse_control_character, &pc.quote,
             &parse_control_character, &pc.imaginary_unit,
             &usecols, &skiprows, &max_rows, &converters,
             &dtype, &encoding, &filelike,
-            &python_byte_converters, &c_byte_converters)) {
+            &python_byte_converters, &c_byte_converters, &batch_converters,
+            &native_file, &compression, &num_threads, &column_major,
+            &stats_dict, &out, &out_offset, &row_index, &row_index_every,
+            &binary_file)) {
         return NULL;
     }
-    pc.python_byte_converters = python_byte_converters;
-    pc.c_byte_converters = c_byte_converters;
+    if (stats_dict != Py_None && !PyDict_Check(stats_dict)) {
+        PyErr_SetString(PyExc_TypeError, "stats must be a dict or None.");
+        return NULL;
+    }
+    pc.batch_converters = batch_converters;
+    pc.column_major = column_major;
+    if (finalize_parser_config(&pc, dtype,
+            python_byte_converters, c_byte_converters) < 0) {
+        return NULL;
+    }
+    if (row_index != Py_None) {
+        if (!PyArray_Check(row_index)
+                || PyArray_NDIM((PyArrayObject *)row_index) != 1
+                || PyArray_TYPE((PyArrayObject *)row_index) != NPY_INT64
+                || !PyArray_ISCARRAY_RO((PyArrayObject *)row_index)) {
+            PyErr_SetString(PyExc_TypeError,
+                    "row_index must be a 1-d contiguous int64 array.");
+            return NULL;
+        }
+        if (check_row_index_config(
+                &pc, encoding, native_file, compression) < 0) {
+            return NULL;
+        }
+    }
 
-    if (pc.delimiter == (Py_UCS4)-1) {
-        pc.delimiter_is_whitespace = true;
-        /* Ignore leading whitespace to match `string.split(None)` */
-        pc.ignore_leading_whitespace = true;
+    stream *s = open_stream(
+            file, encoding, filelike, binary_file, native_file, compression);
+    if (s == NULL) {
+        return NULL;
     }
 
-    if (!PyArray_DescrCheck(dtype) ) {
-        PyErr_SetString(PyExc_TypeError,
-                "internal error: dtype must be provided and be a NumPy dtype");
+    if (row_index != Py_None) {
+        /* Jump to the first row to read, nothing is left to skip */
+        char *start, *end;
+        stream_native_file_bytes(s, &start, &end);
+        const char *pos = row_index_find(start, end, &pc,
+                PyArray_DATA((PyArrayObject *)row_index),
+                PyArray_SIZE((PyArrayObject *)row_index),
+                row_index_every, skiprows);
+        if (pos == NULL) {
+            stream_close(s);
+            return NULL;
+        }
+        stream_native_file_skip_to(s, (char *)pos);
+        skiprows = 0;
+    }
+
+    read_stats stats = {0};
+    arr = _readtext_from_stream(s, &pc, usecols, skiprows, max_rows,
+                                converters, dtype, num_threads,
+                                stats_dict != Py_None ? &stats : NULL,
+                                out, out_offset);
+    stream_close(s);
+    if (arr != NULL && stats_dict != Py_None
+            && read_stats_to_dict(&stats, stats_dict) < 0) {
+        Py_CLEAR(arr);
+    }
+    return arr;
+}
+
+
+//
+// Build the row index (see `row_index.h`) of a file which is read natively,
+// returns the offsets of every `every`-th row.
+//
+static PyObject *
+_build_row_index(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *kwlist[] = {"file", "delimiter", "comment", "quote",
+                             "encoding", "native_file", "compression",
+                             "every", NULL};
+    PyObject *file;
+    char *encoding = NULL;
+    int native_file = 0;
+    char *compression = NULL;
+    Py_ssize_t every = 1024;
+    parser_config pc = default_parser_config;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|$O&O&O&zpzn", kwlist,
+            &file,
+            &parse_control_character, &pc.delimiter,
+            &parse_comments, &pc,
+            &parse_control_character, &pc.quote,
+            &encoding, &native_file, &compression, &every)) {
+        return NULL;
+    }
+    if (every <= 0) {
+        PyErr_SetString(PyExc_ValueError, "every must be positive.");
+        return NULL;
+    }
+    if (finalize_parser_config(&pc, NULL, 0, 0) < 0
+            || check_row_index_config(
+                    &pc, encoding, native_file, compression) < 0) {
+        return NULL;
+    }
+
+    stream *s = stream_native_file(file, encoding);
+    if (s == NULL) {
         return NULL;
     }
+    char *start, *end;
+    stream_native_file_bytes(s, &start, &end);
+    PyArrayObject *offsets = row_index_build(start, end, &pc, every);
+    stream_close(s);
+    return (PyObject *)offsets;
+}
+
+
+//
+// Read the native files `files` (a sequence of paths) with the same dtype
+// into one array, see `read_rows_many`.  Returns None if the files have to
+// be read one by one.
+//
+static PyObject *
+_readtext_many(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *kwlist[] = {"files", "delimiter", "comment", "quote",
+                             "imaginary_unit", "usecols", "skiprows",
+                             "dtype", "encoding", "num_threads", NULL};
+    PyObject *files;
+    PyObject *usecols = Py_None;
+    Py_ssize_t skiprows = 0;
+    PyObject *dtype = Py_None;
+    char *encoding = NULL;
+    int num_threads = 1;
+    parser_config pc = default_parser_config;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|$O&O&O&O&OnOzi", kwlist,
+            &files,
+            &parse_control_character, &pc.delimiter,
+            &parse_comments, &pc,
+            &parse_control_character, &pc.quote,
+            &parse_control_character, &pc.imaginary_unit,
+            &usecols, &skiprows, &dtype, &encoding, &num_threads)) {
+        return NULL;
+    }
+    if (finalize_parser_config(&pc, dtype, 0, 0) < 0) {
+        return NULL;
+    }
+    if (dtype == Py_None) {
+        PyErr_SetString(PyExc_TypeError, "a dtype must be provided.");
+        return NULL;
+    }
+
+    PyObject *files_seq = PySequence_Fast(files, "files must be a sequence");
+    if (files_seq == NULL) {
+        return NULL;
+    }
+    Py_ssize_t num_files = PySequence_Fast_GET_SIZE(files_seq);
+    if (num_files > INT_MAX) {
+        Py_DECREF(files_seq);
+        PyErr_SetString(PyExc_ValueError, "too many files.");
+        return NULL;
+    }
+
+    PyArray_Descr *out_dtype = (PyArray_Descr *)dtype;
+    field_type *ft = NULL;
+    npy_intp num_fields = field_types_create(out_dtype, &ft);
+    if (num_fields < 0) {
+        Py_DECREF(files_seq);
+        return NULL;
+    }
+    bool homogeneous = num_fields == 1 && ft[0].descr == out_dtype;
+
+    int ncols = num_fields;
+    int32_t *cols = NULL;
+    if (usecols != Py_None) {
+        ncols = PyArray_SIZE(usecols);
+        cols = PyArray_DATA(usecols);
+    }
+
+    PyArrayObject *arr = read_rows_many(
+            (int)num_files, PySequence_Fast_ITEMS(files_seq), encoding,
+            num_fields, ft, &pc, ncols, cols, skiprows,
+            out_dtype, homogeneous, num_threads);
+    field_types_xclear(num_fields, ft);
+    Py_DECREF(files_seq);
+    if (arr == NULL && !PyErr_Occurred()) {
+        Py_RETURN_NONE;
+    }
+    return (PyObject *)arr;
+}
+
+
+//
+// Export the columns of a record batch of `length` rows through the Arrow
+// C Data Interface, see `arrow_export_record_batch`.
+//
+static PyObject *
+_arrow_export(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *kwlist[] = {"columns", "length", NULL};
+    PyObject *columns;
+    Py_ssize_t length;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "On", kwlist, &columns, &length)) {
+        return NULL;
+    }
+    return arrow_export_record_batch(columns, length);
+}
+
+
+//
+// Free the scratch buffers of the arena of the current thread, returns the
+// number of bytes freed.
+//
+static PyObject *
+_trim_buffers(PyObject *self, PyObject *NPY_UNUSED(args))
+{
+    return PyLong_FromSize_t(arena_trim());
+}
 
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Reader object to read a file in batches.
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+//
+// `TextReader` owns the stream, the tokenizer state and the field types, so
+// that a file can be read in batches without setting them up each time.
+// It accepts the same arguments as `_readtext_from_file_object` (except for
+// `max_rows` and `num_threads`).  With `stats=True` the counters of all
+// batches are summed up in `stats`.  After an error the reader is closed.
+// While a batch is read (possibly without the GIL, or calling converters)
+// the reader is busy and cannot be used from another thread or a converter.
+//
+typedef struct {
+    PyObject_HEAD
     stream *s;
-    if (filelike) {
-        s = stream_python_file(file, encoding);
+    parser_config pc;
+    /* A copy of the encoding, which the stream may reference */
+    char *encoding;
+    PyObject *usecols;
+    PyObject *converters;
+    PyArray_Descr *dtype;
+    npy_intp num_fields;
+    field_type *ft;
+    bool homogeneous;
+    /* Only initialized while `s` is not NULL */
+    rows_state rs;
+    bool collect_stats;
+    read_stats stats;
+    /* Set while `read_rows_batch` uses the stream and the rows state */
+    bool busy;
+} TextReader;
+
+
+/*
+ * Fails if the reader is reading a batch (in another thread, or this is
+ * called from a converter of it).
+ */
+static int
+textreader_check_busy(TextReader *self)
+{
+    if (self->busy) {
+        PyErr_SetString(PyExc_RuntimeError, "reader is in use");
+        return -1;
     }
-    else {
-        s = stream_python_iterable(file, encoding);
+    return 0;
+}
+
+
+static void
+textreader_close_stream(TextReader *self)
+{
+    if (self->s == NULL) {
+        return;
+    }
+    rows_state_clear(&self->rs);
+    stream_close(self->s);
+    self->s = NULL;
+}
+
+
+static int
+textreader_init(TextReader *self, PyObject *args, PyObject *kwargs)
+{
+    static char *kwlist[] = {"file", "delimiter", "comment", "quote",
+                             "imaginary_unit", "usecols", "skiprows",
+                             "converters", "dtype",
+                             "encoding", "filelike",
+                             "byte_converters", "c_byte_converters",
+                             "batch_converters", "native_file",
+                             "compression", "categorical", "stats",
+                             "binary_file", "missing", "record_missing",
+                             "strings", "column_major", NULL};
+    PyObject *file;
+    Py_ssize_t skiprows = 0;
+    PyObject *usecols = Py_None;
+    PyObject *converters = Py_None;
+    PyObject *dtype = Py_None;
+    char *encoding = NULL;
+    int filelike = 1;
+    int native_file = 0;
+    char *compression = NULL;
+    int python_byte_converters = 0;
+    int c_byte_converters = 0;
+    int batch_converters = 0;
+    PyObject *categorical = Py_None;
+    int collect_stats = 0;
+    int binary_file = 0;
+    PyObject *missing = Py_None;
+    int record_missing = 0;
+    PyObject *strings = Py_None;
+    int column_major = 0;
+
+    if (self->dtype != NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "reader is already initialized");
+        return -1;
+    }
+    self->pc = default_parser_config;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|$O&O&O&O&OnOOzpppppzOppOpOp", kwlist,
+            &file,
+            &parse_control_character, &self->pc.delimiter,
+            &parse_comments, &self->pc,
+            &parse_control_character, &self->pc.quote,
+            &parse_control_character, &self->pc.imaginary_unit,
+            &usecols, &skiprows, &converters,
+            &dtype, &encoding, &filelike,
+            &python_byte_converters, &c_byte_converters, &batch_converters,
+            &native_file, &compression, &categorical, &collect_stats,
+            &binary_file, &missing, &record_missing, &strings,
+            &column_major)) {
+        return -1;
+    }
+    self->pc.batch_converters = batch_converters;
+    self->pc.column_major = column_major;
+    if (finalize_parser_config(&self->pc, dtype,
+            python_byte_converters, c_byte_converters) < 0) {
+        return -1;
+    }
+
+    if (encoding != NULL) {
+        self->encoding = PyMem_Malloc(strlen(encoding) + 1);
+        if (self->encoding == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        strcpy(self->encoding, encoding);
     }
+
+    Py_INCREF(usecols);
+    self->usecols = usecols;
+    Py_INCREF(converters);
+    self->converters = converters;
+    Py_INCREF(dtype);
+    self->dtype = (PyArray_Descr *)dtype;
+
+    field_type *ft = NULL;
+    npy_intp num_fields = field_types_create(self->dtype, &ft);
+    if (num_fields < 0) {
+        return -1;
+    }
+    self->num_fields = num_fields;
+    self->ft = ft;
+    self->homogeneous = (
+            self->num_fields == 1 && self->ft[0].descr == self->dtype);
+    if (column_major && check_column_major_dtype(
+            self->dtype, self->num_fields, self->homogeneous) < 0) {
+        return -1;
+    }
+
+    stream *s = open_stream(file, self->encoding, filelike, binary_file,
+            native_file, compression);
     if (s == NULL) {
-        PyErr_Format(PyExc_RuntimeError, "Unable to access the file.");
+        return -1;
+    }
+    if (rows_state_init(&self->rs, &self->pc, skiprows) < 0) {
+        stream_close(s);
+        return -1;
+    }
+    if (categorical != Py_None) {
+        Py_INCREF(categorical);
+        self->rs.categorical = categorical;
+    }
+    if (missing != Py_None) {
+        Py_INCREF(missing);
+        self->rs.missing = missing;
+        self->rs.record_missing = record_missing;
+    }
+    if (strings != Py_None) {
+        Py_INCREF(strings);
+        self->rs.strings = strings;
+    }
+    self->collect_stats = collect_stats;
+    if (collect_stats) {
+        self->rs.ts.stats = &self->stats;
+    }
+    self->s = s;
+    return 0;
+}
+
+
+static void
+textreader_dealloc(TextReader *self)
+{
+    textreader_close_stream(self);
+    PyMem_Free(self->encoding);
+    Py_XDECREF(self->usecols);
+    Py_XDECREF(self->converters);
+    field_types_xclear(self->num_fields, self->ft);
+    Py_XDECREF(self->dtype);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+/*
+ * Read up to `max_rows` rows (all if negative), filling `out` if given.
+ */
+static PyObject *
+textreader_read(TextReader *self, npy_intp max_rows, PyArrayObject *out)
+{
+    if (textreader_check_busy(self) < 0) {
+        return NULL;
+    }
+    if (self->s == NULL) {
+        PyErr_SetString(PyExc_ValueError, "read from closed reader");
         return NULL;
     }
 
-    arr = _readtext_from_stream(s, &pc, usecols, skiprows, max_rows,
-                                converters, dtype);
-    stream_close(s);
-    return arr;
+    int ncols;
+    int32_t *cols;
+    if (self->usecols == Py_None) {
+        ncols = self->num_fields;
+        cols = NULL;
+    }
+    else {
+        ncols = PyArray_SIZE((PyArrayObject *)self->usecols);
+        cols = PyArray_DATA((PyArrayObject *)self->usecols);
+    }
+
+    Py_ssize_t prev_row_count = self->rs.row_count;
+    self->busy = true;
+    PyArrayObject *arr = read_rows_batch(
+            self->s, &self->rs, max_rows, self->num_fields, self->ft,
+            &self->pc, ncols, cols, self->converters,
+            out, self->dtype, self->homogeneous);
+    self->busy = false;
+    if (arr == NULL) {
+        textreader_close_stream(self);
+        return NULL;
+    }
+    if (out == NULL && self->pc.column_major && !self->homogeneous) {
+        /* Return the fields, which are stored one after the other */
+        PyObject *fields = column_major_fields(
+                arr, self->num_fields, self->ft);
+        Py_DECREF(arr);
+        return fields;
+    }
+    if (out == NULL) {
+        return (PyObject *)arr;
+    }
+    /* Return the view of the rows which were filled in */
+    Py_DECREF(arr);
+    return PySequence_GetSlice(
+            (PyObject *)out, 0, self->rs.row_count - prev_row_count);
 }
 
 
+static PyObject *
+textreader_read_batch(TextReader *self, PyObject *args, PyObject *kwargs)
+{
+    static char *kwlist[] = {"max_rows", "out", NULL};
+    Py_ssize_t max_rows = -1;
+    PyObject *out = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|n$O", kwlist, &max_rows, &out)) {
+        return NULL;
+    }
+    if (out == Py_None) {
+        return textreader_read(self, max_rows, NULL);
+    }
+    if (self->pc.column_major) {
+        PyErr_SetString(PyExc_ValueError,
+                "a column-major result cannot be read into out.");
+        return NULL;
+    }
+
+    if (check_out_array(out, self->dtype, self->homogeneous) < 0) {
+        return NULL;
+    }
+    PyArrayObject *out_arr = (PyArrayObject *)out;
+    npy_intp length = PyArray_DIM(out_arr, 0);
+    if (max_rows < 0 || max_rows > length) {
+        max_rows = length;
+    }
+    return textreader_read(self, max_rows, out_arr);
+}
+
+
+static PyObject *
+textreader_take_strings(TextReader *self, PyObject *NPY_UNUSED(args))
+{
+    if (textreader_check_busy(self) < 0) {
+        return NULL;
+    }
+    if (self->s == NULL) {
+        PyErr_SetString(PyExc_ValueError, "reader is closed");
+        return NULL;
+    }
+    return rows_state_take_strings(&self->rs);
+}
+
+
+static PyObject *
+textreader_close(TextReader *self, PyObject *NPY_UNUSED(args))
+{
+    if (textreader_check_busy(self) < 0) {
+        return NULL;
+    }
+    textreader_close_stream(self);
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+textreader_get_row_count(TextReader *self, void *NPY_UNUSED(closure))
+{
+    if (self->s == NULL) {
+        PyErr_SetString(PyExc_ValueError, "reader is closed");
+        return NULL;
+    }
+    return PyLong_FromSsize_t(self->rs.row_count);
+}
+
+
+static PyObject *
+textreader_get_categories(TextReader *self, void *NPY_UNUSED(closure))
+{
+    if (textreader_check_busy(self) < 0) {
+        return NULL;
+    }
+    if (self->s == NULL) {
+        PyErr_SetString(PyExc_ValueError, "reader is closed");
+        return NULL;
+    }
+    return rows_state_categories(&self->rs);
+}
+
+
+static PyObject *
+textreader_get_missing_positions(TextReader *self, void *NPY_UNUSED(closure))
+{
+    if (textreader_check_busy(self) < 0) {
+        return NULL;
+    }
+    if (self->s == NULL) {
+        PyErr_SetString(PyExc_ValueError, "reader is closed");
+        return NULL;
+    }
+    return missing_state_positions(self->rs.missing_state);
+}
+
+
+static PyObject *
+textreader_get_stats(TextReader *self, void *NPY_UNUSED(closure))
+{
+    if (!self->collect_stats) {
+        PyErr_SetString(PyExc_ValueError,
+                "the reader was not created with stats=True");
+        return NULL;
+    }
+    PyObject *dict = PyDict_New();
+    if (dict == NULL) {
+        return NULL;
+    }
+    if (read_stats_to_dict(&self->stats, dict) < 0) {
+        Py_DECREF(dict);
+        return NULL;
+    }
+    return dict;
+}
+
+
+static PyObject *
+textreader_get_finished(TextReader *self, void *NPY_UNUSED(closure))
+{
+    return PyBool_FromLong(self->s == NULL || self->rs.finished);
+}
+
+
+static PyMethodDef textreader_methods[] = {
+    {"read_batch", (PyCFunction) textreader_read_batch,
+         METH_VARARGS | METH_KEYWORDS,
+         "read_batch(max_rows=-1, *, out=None)\n"
+         "Read the next (up to) `max_rows` rows.  If `out` is given it is "
+         "filled and the view of the rows read is returned."},
+    {"take_strings", (PyCFunction) textreader_take_strings, METH_NOARGS,
+         "Dictionary of the UTF-8 data of each string field read since the "
+         "last call, which the stored offsets index into."},
+    {"close", (PyCFunction) textreader_close, METH_NOARGS,
+         "Close the stream (and file if it was opened by the reader)."},
+    {0} // sentinel
+};
+
+static PyGetSetDef textreader_getset[] = {
+    {"row_count", (getter) textreader_get_row_count, NULL,
+         "The number of rows read so far.", NULL},
+    {"finished", (getter) textreader_get_finished, NULL,
+         "Whether the reader is closed or reached the end of the file.", NULL},
+    {"categories", (getter) textreader_get_categories, NULL,
+         "Dictionary of the categories of each categorical column, the "
+         "codes read so far index into them.", NULL},
+    {"missing_positions", (getter) textreader_get_missing_positions, NULL,
+         "Tuple of the rows and the fields of the missing fields of the last "
+         "batch (only recorded with record_missing=True).", NULL},
+    {"stats", (getter) textreader_get_stats, NULL,
+         "Dictionary of the counters and timers (in ns) of all batches read "
+         "so far (only with stats=True).", NULL},
+    {0} // sentinel
+};
+
+static PyTypeObject TextReader_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "npreadtext._readtextmodule.TextReader",
+    .tp_basicsize = sizeof(TextReader),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Reader which keeps its state to read a file in batches.",
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc) textreader_init,
+    .tp_dealloc = (destructor) textreader_dealloc,
+    .tp_methods = textreader_methods,
+    .tp_getset = textreader_getset,
+};
+
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Python extension module definition.
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -189,6 +1071,17 @@ _readtext_from_file_object(PyObject *self, PyObject *args, PyObject *kwargs)
 PyMethodDef module_methods[] = {
     {"_readtext_from_file_object", (PyCFunction) _readtext_from_file_object,
          METH_VARARGS | METH_KEYWORDS, "testing"},
+    {"_build_row_index", (PyCFunction) _build_row_index,
+         METH_VARARGS | METH_KEYWORDS,
+         "Return the byte offsets of every `every`-th row of a file."},
+    {"_readtext_many", (PyCFunction) _readtext_many,
+         METH_VARARGS | METH_KEYWORDS,
+         "Read many native files into one array, or return None."},
+    {"_arrow_export", (PyCFunction) _arrow_export,
+         METH_VARARGS | METH_KEYWORDS,
+         "Return the Arrow C Data Interface capsules of a record batch."},
+    {"_trim_buffers", (PyCFunction) _trim_buffers, METH_NOARGS,
+         "Free the scratch buffers kept for reading in the current thread."},
     {0} // sentinel
 };
 
@@ -210,8 +1103,32 @@ PyInit__readtextmodule(void)
         return NULL;
     }
     double_descr = PyArray_DescrFromType(NPY_DOUBLE);
+    if (str_to_double_init() < 0) {
+        return NULL;
+    }
+    simd_scan_init();
 
-    m = PyModule_Create(&moduledef);
+    if (PyType_Ready(&TextReader_Type) < 0) {
+        return NULL;
+    }
 
+    m = PyModule_Create(&moduledef);
+    if (m == NULL) {
+        return NULL;
+    }
+    Py_INCREF(&TextReader_Type);
+    if (PyModule_AddObject(m, "TextReader", (PyObject *)&TextReader_Type) < 0) {
+        Py_DECREF(&TextReader_Type);
+        Py_DECREF(m);
+        return NULL;
+    }
+    /* The compressions which can be read natively (`compression=`) */
+    PyObject *compressions = compressed_stream_formats();
+    if (compressions == NULL
+            || PyModule_AddObject(m, "_native_compressions", compressions) < 0) {
+        Py_XDECREF(compressions);
+        Py_DECREF(m);
+        return NULL;
+    }
     return m;
 }
@@ -0,0 +1,141 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdbool.h>
+
+#include "arena.h"
+
+#define ARENA_KEY "npreadtext.arena"
+
+typedef struct {
+    void *buffer;
+    size_t size;
+} arena_buffer;
+
+typedef struct {
+    arena_buffer slots[ARENA_NUM_SLOTS];
+} arena;
+
+
+static size_t
+arena_free_buffers(arena *a)
+{
+    size_t freed = 0;
+    for (int i = 0; i < ARENA_NUM_SLOTS; i++) {
+        PyMem_RawFree(a->slots[i].buffer);
+        freed += a->slots[i].size;
+        a->slots[i].buffer = NULL;
+        a->slots[i].size = 0;
+    }
+    return freed;
+}
+
+
+static void
+arena_capsule_free(PyObject *capsule)
+{
+    arena *a = PyCapsule_GetPointer(capsule, ARENA_KEY);
+    if (a == NULL) {
+        PyErr_Clear();
+        return;
+    }
+    arena_free_buffers(a);
+    PyMem_RawFree(a);
+}
+
+
+/*
+ * Returns the arena of the current thread, created if `create` is set.
+ * Never sets an error (and keeps a pending one): without an arena the
+ * buffers are simply not reused.
+ */
+static arena *
+get_arena(bool create)
+{
+    arena *a = NULL;
+    PyObject *type, *value, *traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+
+    PyObject *dict = PyThreadState_GetDict();
+    if (dict == NULL) {
+        goto finish;
+    }
+    PyObject *capsule = PyDict_GetItemString(dict, ARENA_KEY);
+    if (capsule != NULL) {
+        a = PyCapsule_GetPointer(capsule, ARENA_KEY);
+        goto finish;
+    }
+    if (!create) {
+        goto finish;
+    }
+    a = PyMem_RawCalloc(1, sizeof(arena));
+    if (a == NULL) {
+        goto finish;
+    }
+    capsule = PyCapsule_New(a, ARENA_KEY, &arena_capsule_free);
+    if (capsule == NULL) {
+        PyMem_RawFree(a);
+        a = NULL;
+        goto finish;
+    }
+    if (PyDict_SetItemString(dict, ARENA_KEY, capsule) < 0) {
+        a = NULL;  /* freed with the capsule */
+    }
+    Py_DECREF(capsule);
+
+  finish:
+    PyErr_Clear();
+    PyErr_Restore(type, value, traceback);
+    return a;
+}
+
+
+void *
+arena_take(arena_slot slot, size_t min_size, size_t *size)
+{
+    arena *a = get_arena(false);
+    if (a != NULL && a->slots[slot].buffer != NULL
+            && a->slots[slot].size >= min_size) {
+        void *buffer = a->slots[slot].buffer;
+        *size = a->slots[slot].size;
+        a->slots[slot].buffer = NULL;
+        a->slots[slot].size = 0;
+        return buffer;
+    }
+    void *buffer = PyMem_RawMalloc(min_size);
+    if (buffer == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    *size = min_size;
+    return buffer;
+}
+
+
+void
+arena_give(arena_slot slot, void *buffer, size_t size)
+{
+    if (buffer == NULL) {
+        return;
+    }
+    arena *a = get_arena(true);
+    if (a == NULL || (a->slots[slot].buffer != NULL
+            && a->slots[slot].size >= size)) {
+        PyMem_RawFree(buffer);
+        return;
+    }
+    PyMem_RawFree(a->slots[slot].buffer);
+    a->slots[slot].buffer = buffer;
+    a->slots[slot].size = size;
+}
+
+
+size_t
+arena_trim(void)
+{
+    arena *a = get_arena(false);
+    if (a == NULL) {
+        return 0;
+    }
+    return arena_free_buffers(a);
+}
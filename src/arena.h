@@ -0,0 +1,43 @@
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+/*
+ * A per-thread arena of scratch buffers, which keeps the buffers of the
+ * tokenizer at their high-water mark between reads, so that reading many
+ * small files does not allocate and regrow them each time.  The arena is
+ * stored in the thread state dictionary and freed with the thread.  All
+ * functions need the GIL.
+ */
+typedef enum {
+    ARENA_FIELD_BUFFER,
+    ARENA_FIELDS,
+    ARENA_NUM_SLOTS,
+} arena_slot;
+
+
+/*
+ * Take the buffer of `slot` if it has at least `min_size` bytes, otherwise
+ * allocate a new one (with the raw allocator).  Stores its size in `size`.
+ * Returns NULL with an error set if out of memory.
+ */
+void *
+arena_take(arena_slot slot, size_t min_size, size_t *size);
+
+/*
+ * Give a buffer (taken or allocated with the raw allocator) of `size` bytes
+ * back to `slot`, the arena keeps the larger of it and the one it has.
+ */
+void
+arena_give(arena_slot slot, void *buffer, size_t size);
+
+/*
+ * Free the buffers of the arena of the current thread, returns the number
+ * of bytes freed.
+ */
+size_t
+arena_trim(void);
+
+#endif
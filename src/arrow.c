@@ -0,0 +1,476 @@
+/*
+ * Arrow output: Variable-length string columns and the export of the
+ * result columns through the Arrow C Data Interface, which lets e.g.
+ * pyarrow use the buffers without copying them (and without us depending
+ * on Arrow).
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <string.h>
+#include <stdint.h>
+
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL npreadtext_ARRAY_API
+#include "numpy/arrayobject.h"
+
+#include "arrow.h"
+
+
+#define STRING_COLUMN_MIN_CAPACITY 4096
+
+
+static int
+arrow_string_column_add(arrow_string_column **columns, int field,
+        field_type *field_types, bool homogeneous, PyObject **conv_funcs)
+{
+    if (columns[field] != NULL) {
+        return 0;  /* duplicated */
+    }
+    PyArray_Descr *descr = field_types[homogeneous ? 0 : field].descr;
+    if (descr->kind != 'i' || descr->elsize != 8
+            || !PyArray_ISNBO(descr->byteorder)) {
+        PyErr_Format(PyExc_TypeError,
+                "string field %d must have a native int64 dtype to store "
+                "the offsets, but has dtype %S.", field, descr);
+        return -1;
+    }
+    if (conv_funcs[field] != NULL) {
+        PyErr_Format(PyExc_ValueError,
+                "string field %d must not have a converter.", field);
+        return -1;
+    }
+    columns[field] = PyMem_RawCalloc(1, sizeof(arrow_string_column));
+    if (columns[field] == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return 0;
+}
+
+
+arrow_string_column **
+arrow_string_columns_create(PyObject *strings, int num_fields,
+        field_type *field_types, bool homogeneous, PyObject **conv_funcs)
+{
+    arrow_string_column **columns = PyMem_RawCalloc(
+            num_fields > 0 ? num_fields : 1, sizeof(arrow_string_column *));
+    if (columns == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    if (strings == Py_True) {
+        for (int i = 0; i < num_fields; i++) {
+            if (arrow_string_column_add(columns, i,
+                    field_types, homogeneous, conv_funcs) < 0) {
+                goto error;
+            }
+        }
+        return columns;
+    }
+
+    PyObject *seq = PySequence_Fast(
+            strings, "strings must be True or a sequence of fields.");
+    if (seq == NULL) {
+        goto error;
+    }
+    for (Py_ssize_t k = 0; k < PySequence_Fast_GET_SIZE(seq); k++) {
+        PyObject *key = PySequence_Fast_GET_ITEM(seq, k);
+        Py_ssize_t field = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if (field == -1 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            goto error;
+        }
+        if (field < 0 || field >= num_fields) {
+            PyErr_Format(PyExc_ValueError,
+                    "string field %zd is invalid for the number of fields "
+                    "%d.", field, num_fields);
+            Py_DECREF(seq);
+            goto error;
+        }
+        if (arrow_string_column_add(columns, (int)field,
+                field_types, homogeneous, conv_funcs) < 0) {
+            Py_DECREF(seq);
+            goto error;
+        }
+    }
+    Py_DECREF(seq);
+    return columns;
+
+  error:
+    arrow_string_columns_free(columns, num_fields);
+    return NULL;
+}
+
+
+void
+arrow_string_columns_free(arrow_string_column **columns, int num_fields)
+{
+    if (columns == NULL) {
+        return;
+    }
+    for (int i = 0; i < num_fields; i++) {
+        if (columns[i] != NULL) {
+            PyMem_RawFree(columns[i]->data);
+            PyMem_RawFree(columns[i]);
+        }
+    }
+    PyMem_RawFree(columns);
+}
+
+
+int
+arrow_string_append(arrow_string_column *column, int kind, const char *data,
+        size_t start, size_t end, char *item_ptr)
+{
+    int64_t offset = (int64_t)column->length;
+    memcpy(item_ptr, &offset, sizeof(offset));
+    if (start == end) {
+        return 0;
+    }
+
+    /* The UTF-8 encoding needs at most 2, 3 or 4 bytes per character */
+    size_t max_length = (end - start) * (kind == PyUnicode_1BYTE_KIND ? 2
+            : kind == PyUnicode_2BYTE_KIND ? 3 : 4);
+    if (column->capacity - column->length < max_length) {
+        size_t capacity = column->capacity;
+        if (capacity < STRING_COLUMN_MIN_CAPACITY) {
+            capacity = STRING_COLUMN_MIN_CAPACITY;
+        }
+        while (capacity - column->length < max_length) {
+            if (capacity > SIZE_MAX / 2) {
+                return -1;
+            }
+            capacity *= 2;
+        }
+        char *new_data = PyMem_RawRealloc(column->data, capacity);
+        if (new_data == NULL) {
+            return -1;
+        }
+        column->data = new_data;
+        column->capacity = capacity;
+    }
+
+    unsigned char *out = (unsigned char *)column->data + column->length;
+    if (kind == PyUnicode_1BYTE_KIND) {
+        const Py_UCS1 *str = (const Py_UCS1 *)data;
+        for (size_t i = start; i < end; i++) {
+            Py_UCS1 c = str[i];
+            if (c < 0x80) {
+                *out++ = c;
+            }
+            else {
+                *out++ = 0xC0 | (c >> 6);
+                *out++ = 0x80 | (c & 0x3F);
+            }
+        }
+    }
+    else {
+        for (size_t i = start; i < end; i++) {
+            Py_UCS4 c = PyUnicode_READ(kind, data, i);
+            if (c < 0x80) {
+                *out++ = (unsigned char)c;
+            }
+            else if (c < 0x800) {
+                *out++ = 0xC0 | (c >> 6);
+                *out++ = 0x80 | (c & 0x3F);
+            }
+            else if (c < 0x10000) {
+                *out++ = 0xE0 | (c >> 12);
+                *out++ = 0x80 | ((c >> 6) & 0x3F);
+                *out++ = 0x80 | (c & 0x3F);
+            }
+            else {
+                *out++ = 0xF0 | (c >> 18);
+                *out++ = 0x80 | ((c >> 12) & 0x3F);
+                *out++ = 0x80 | ((c >> 6) & 0x3F);
+                *out++ = 0x80 | (c & 0x3F);
+            }
+        }
+    }
+    column->length = (char *)out - column->data;
+    return 0;
+}
+
+
+static void
+free_string_data(PyObject *capsule)
+{
+    PyMem_RawFree(PyCapsule_GetPointer(capsule, NULL));
+}
+
+
+PyObject *
+arrow_string_column_take(arrow_string_column *column)
+{
+    npy_intp length = column->length;
+    if (column->data == NULL) {
+        return PyArray_SimpleNew(1, &length, NPY_UINT8);
+    }
+    PyObject *arr = PyArray_SimpleNewFromData(
+            1, &length, NPY_UINT8, column->data);
+    if (arr == NULL) {
+        return NULL;
+    }
+    PyObject *capsule = PyCapsule_New(column->data, NULL, &free_string_data);
+    if (capsule == NULL) {
+        Py_DECREF(arr);
+        return NULL;
+    }
+    /* The capsule owns the data now */
+    column->data = NULL;
+    column->length = 0;
+    column->capacity = 0;
+    if (PyArray_SetBaseObject((PyArrayObject *)arr, capsule) < 0) {
+        Py_DECREF(arr);
+        return NULL;
+    }
+    return arr;
+}
+
+
+/*
+ * Export
+ * ------
+ * The structs are allocated with the raw allocator and the release
+ * callbacks only need the GIL to release the buffers of the Python
+ * objects, since consumers may release them from any thread.
+ */
+typedef struct {
+    Py_buffer *views;
+    Py_ssize_t num_views;
+} array_private_data;
+
+
+static char *
+copy_string(const char *str)
+{
+    size_t length = strlen(str) + 1;
+    char *res = PyMem_RawMalloc(length);
+    if (res != NULL) {
+        memcpy(res, str, length);
+    }
+    return res;
+}
+
+
+static void
+release_schema(struct ArrowSchema *schema)
+{
+    for (int64_t i = 0; schema->children != NULL && i < schema->n_children;
+            i++) {
+        struct ArrowSchema *child = schema->children[i];
+        if (child != NULL && child->release != NULL) {
+            child->release(child);
+        }
+        PyMem_RawFree(child);
+    }
+    PyMem_RawFree(schema->children);
+    PyMem_RawFree((char *)schema->format);
+    PyMem_RawFree((char *)schema->name);
+    schema->release = NULL;
+}
+
+
+static void
+release_array(struct ArrowArray *array)
+{
+    for (int64_t i = 0; array->children != NULL && i < array->n_children;
+            i++) {
+        struct ArrowArray *child = array->children[i];
+        if (child != NULL && child->release != NULL) {
+            child->release(child);
+        }
+        PyMem_RawFree(child);
+    }
+    PyMem_RawFree(array->children);
+    array_private_data *private_data = array->private_data;
+    if (private_data != NULL) {
+        PyGILState_STATE gil_state = PyGILState_Ensure();
+        for (Py_ssize_t i = 0; i < private_data->num_views; i++) {
+            if (private_data->views[i].obj != NULL) {
+                PyBuffer_Release(&private_data->views[i]);
+            }
+        }
+        PyGILState_Release(gil_state);
+        PyMem_RawFree(private_data->views);
+        PyMem_RawFree(private_data);
+    }
+    PyMem_RawFree((void *)array->buffers);
+    array->release = NULL;
+}
+
+
+/*
+ * Initialize `schema` and `array` (zero filled) for `n_children` children
+ * and `n_buffers` buffers.  The release callbacks are set first, so that
+ * they can always be called to clean up.
+ */
+static int
+init_structs(struct ArrowSchema *schema, struct ArrowArray *array,
+        const char *format, const char *name,
+        int64_t n_children, int64_t n_buffers)
+{
+    schema->release = &release_schema;
+    array->release = &release_array;
+    schema->format = copy_string(format);
+    schema->name = copy_string(name);
+    schema->n_children = n_children;
+    schema->children = PyMem_RawCalloc(
+            n_children > 0 ? n_children : 1, sizeof(struct ArrowSchema *));
+    array->n_children = n_children;
+    array->children = PyMem_RawCalloc(
+            n_children > 0 ? n_children : 1, sizeof(struct ArrowArray *));
+    array->n_buffers = n_buffers;
+    array->buffers = PyMem_RawCalloc(
+            n_buffers > 0 ? n_buffers : 1, sizeof(void *));
+    if (schema->format == NULL || schema->name == NULL
+            || schema->children == NULL || array->children == NULL
+            || array->buffers == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (int64_t i = 0; i < n_children; i++) {
+        schema->children[i] = PyMem_RawCalloc(1, sizeof(struct ArrowSchema));
+        array->children[i] = PyMem_RawCalloc(1, sizeof(struct ArrowArray));
+        if (schema->children[i] == NULL || array->children[i] == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+static int
+export_column(PyObject *column, Py_ssize_t length,
+        struct ArrowSchema *schema, struct ArrowArray *array)
+{
+    const char *name, *format;
+    Py_ssize_t null_count;
+    PyObject *buffers;
+    if (!PyArg_ParseTuple(column, "ssnO;a column must be a tuple "
+            "(name, format, null_count, buffers)",
+            &name, &format, &null_count, &buffers)) {
+        return -1;
+    }
+    PyObject *seq = PySequence_Fast(buffers, "buffers must be a sequence.");
+    if (seq == NULL) {
+        return -1;
+    }
+    Py_ssize_t num_buffers = PySequence_Fast_GET_SIZE(seq);
+    if (init_structs(schema, array, format, name, 0, num_buffers) < 0) {
+        goto error;
+    }
+    schema->flags = ARROW_FLAG_NULLABLE;
+    array->length = length;
+    array->null_count = null_count;
+
+    array_private_data *private_data = PyMem_RawCalloc(
+            1, sizeof(array_private_data));
+    if (private_data == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    array->private_data = private_data;
+    private_data->views = PyMem_RawCalloc(
+            num_buffers > 0 ? num_buffers : 1, sizeof(Py_buffer));
+    if (private_data->views == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    for (Py_ssize_t i = 0; i < num_buffers; i++) {
+        PyObject *buffer = PySequence_Fast_GET_ITEM(seq, i);
+        if (buffer == Py_None) {
+            continue;
+        }
+        if (PyObject_GetBuffer(buffer,
+                &private_data->views[i], PyBUF_C_CONTIGUOUS) < 0) {
+            private_data->views[i].obj = NULL;
+            goto error;
+        }
+        private_data->num_views = i + 1;
+        array->buffers[i] = private_data->views[i].buf;
+    }
+    Py_DECREF(seq);
+    return 0;
+
+  error:
+    Py_DECREF(seq);
+    return -1;
+}
+
+
+static void
+free_schema_capsule(PyObject *capsule)
+{
+    struct ArrowSchema *schema = PyCapsule_GetPointer(capsule, "arrow_schema");
+    if (schema->release != NULL) {
+        schema->release(schema);
+    }
+    PyMem_RawFree(schema);
+}
+
+
+static void
+free_array_capsule(PyObject *capsule)
+{
+    struct ArrowArray *array = PyCapsule_GetPointer(capsule, "arrow_array");
+    if (array->release != NULL) {
+        array->release(array);
+    }
+    PyMem_RawFree(array);
+}
+
+
+PyObject *
+arrow_export_record_batch(PyObject *columns, Py_ssize_t length)
+{
+    PyObject *schema_capsule = NULL, *array_capsule = NULL;
+    PyObject *seq = PySequence_Fast(columns, "columns must be a sequence.");
+    if (seq == NULL) {
+        return NULL;
+    }
+    struct ArrowSchema *schema = PyMem_RawCalloc(1, sizeof(struct ArrowSchema));
+    struct ArrowArray *array = PyMem_RawCalloc(1, sizeof(struct ArrowArray));
+    if (schema == NULL || array == NULL) {
+        PyMem_RawFree(schema);
+        PyMem_RawFree(array);
+        Py_DECREF(seq);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    /* The capsules clean up from here on */
+    schema_capsule = PyCapsule_New(schema, "arrow_schema", &free_schema_capsule);
+    if (schema_capsule == NULL) {
+        PyMem_RawFree(schema);
+        PyMem_RawFree(array);
+        goto error;
+    }
+    array_capsule = PyCapsule_New(array, "arrow_array", &free_array_capsule);
+    if (array_capsule == NULL) {
+        PyMem_RawFree(array);
+        goto error;
+    }
+
+    Py_ssize_t num_columns = PySequence_Fast_GET_SIZE(seq);
+    if (init_structs(schema, array, "+s", "", num_columns, 1) < 0) {
+        goto error;
+    }
+    array->length = length;
+    for (Py_ssize_t i = 0; i < num_columns; i++) {
+        if (export_column(PySequence_Fast_GET_ITEM(seq, i), length,
+                schema->children[i], array->children[i]) < 0) {
+            goto error;
+        }
+    }
+    Py_DECREF(seq);
+    return Py_BuildValue("(NN)", schema_capsule, array_capsule);
+
+  error:
+    Py_DECREF(seq);
+    Py_XDECREF(schema_capsule);
+    Py_XDECREF(array_capsule);
+    return NULL;
+}
@@ -0,0 +1,113 @@
+#ifndef _ARROW_H_
+#define _ARROW_H_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "numpy/ndarraytypes.h"
+
+#include "field_types.h"
+
+/*
+ * The Arrow C Data Interface, copied from the specification (it is meant to
+ * be copied, so that no Arrow headers or libraries are needed):
+ * https://arrow.apache.org/docs/format/CDataInterface.html
+ */
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    // Array type description
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+struct ArrowArray {
+    // Array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+
+/*
+ * A variable-length string column: The UTF-8 encoded characters of the
+ * fields are appended to `data` and the item of the field in the result
+ * (an int64) stores the offset at which they start.  Only uses the raw
+ * allocator, so that it can be used without holding the GIL.
+ */
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} arrow_string_column;
+
+
+/*
+ * Create the string columns of the `num_fields` fields: `strings` is True
+ * for all fields or a sequence of fields (positions in the result), each
+ * of which must have a native int64 dtype and no converter.  Returns NULL
+ * with an error set on failure.
+ */
+arrow_string_column **
+arrow_string_columns_create(PyObject *strings, int num_fields,
+        field_type *field_types, bool homogeneous, PyObject **conv_funcs);
+
+void
+arrow_string_columns_free(arrow_string_column **columns, int num_fields);
+
+/*
+ * Append the field `[start, end)` of the row `data` (of unicode `kind`) and
+ * store its offset in `item_ptr`.  A missing field (`start == end`) only
+ * stores the offset.  Returns -1 (without setting an error) if out of memory.
+ */
+int
+arrow_string_append(arrow_string_column *column, int kind, const char *data,
+        size_t start, size_t end, char *item_ptr);
+
+/*
+ * Returns a new uint8 array owning the data of the column, which starts
+ * over empty (so the offsets stored afterwards are relative to it).
+ */
+PyObject *
+arrow_string_column_take(arrow_string_column *column);
+
+/*
+ * Export a record batch of `length` rows through the Arrow C Data Interface.
+ * `columns` is a sequence of tuples `(name, format, null_count, buffers)`,
+ * where `buffers` are objects supporting the buffer protocol (or None for
+ * an absent validity bitmap) which are kept alive until the consumer
+ * releases the array.  Returns a new tuple of the "arrow_schema" and the
+ * "arrow_array" capsules (the Arrow PyCapsule interface).
+ */
+PyObject *
+arrow_export_record_batch(PyObject *columns, Py_ssize_t length);
+
+#endif
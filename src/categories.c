@@ -0,0 +1,257 @@
+/*
+ * Dictionary encoding ("categorical" columns).  The categories are kept in
+ * an open addressing hash table keyed on the characters of the field, so
+ * that no Python string is created for a field which was seen before.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <string.h>
+#include <stdint.h>
+
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL npreadtext_ARRAY_API
+#include "numpy/arrayobject.h"
+
+#include "categories.h"
+
+
+#define CATEGORY_MIN_SLOTS 64
+
+
+category_table *
+category_table_new(PyObject *key, PyArray_Descr *descr)
+{
+    if ((descr->kind != 'i' && descr->kind != 'u')
+            || !PyArray_ISNBO(descr->byteorder)) {
+        PyErr_Format(PyExc_TypeError,
+                "categorical column %R must have a native integer dtype to "
+                "store the codes, but has dtype %S.", key, descr);
+        return NULL;
+    }
+    category_table *table = PyMem_RawCalloc(1, sizeof(category_table));
+    if (table == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    table->slots = PyMem_RawCalloc(CATEGORY_MIN_SLOTS, sizeof(npy_intp));
+    if (table->slots == NULL) {
+        PyMem_RawFree(table);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    table->num_slots = CATEGORY_MIN_SLOTS;
+
+    int bits = descr->elsize * 8 - (descr->kind == 'i' ? 1 : 0);
+    if (bits >= (int)sizeof(npy_intp) * 8 - 1) {
+        table->max_code = NPY_MAX_INTP;
+    }
+    else {
+        table->max_code = ((npy_intp)1 << bits) - 1;
+    }
+    Py_INCREF(key);
+    table->key = key;
+    return table;
+}
+
+
+void
+category_table_free(category_table *table)
+{
+    if (table == NULL) {
+        return;
+    }
+    Py_XDECREF(table->key);
+    PyMem_RawFree(table->chars);
+    PyMem_RawFree(table->ends);
+    PyMem_RawFree(table->hashes);
+    PyMem_RawFree(table->slots);
+    PyMem_RawFree(table);
+}
+
+
+/* FNV-1a over the characters */
+static NPY_INLINE npy_uint64
+hash_field(const Py_UCS4 *str, const Py_UCS4 *end)
+{
+    npy_uint64 hash = 14695981039346656037ULL;
+    for (; str < end; str++) {
+        hash = (hash ^ (npy_uint64)*str) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+/*
+ * Double the number of slots and reinsert all categories.
+ */
+static int
+grow_slots(category_table *table)
+{
+    size_t num_slots = table->num_slots * 2;
+    npy_intp *slots = PyMem_RawCalloc(num_slots, sizeof(npy_intp));
+    if (slots == NULL) {
+        return -1;
+    }
+    size_t mask = num_slots - 1;
+    for (npy_intp code = 0; code < table->num_codes; code++) {
+        size_t i = (size_t)table->hashes[code] & mask;
+        while (slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = code + 1;
+    }
+    PyMem_RawFree(table->slots);
+    table->slots = slots;
+    table->num_slots = num_slots;
+    return 0;
+}
+
+
+/*
+ * Returns the code of the new category, or -1 on failure.
+ */
+static npy_intp
+add_category(category_table *table, npy_uint64 hash,
+        const Py_UCS4 *str, size_t length)
+{
+    if (table->num_codes > table->max_code) {
+        return -1;
+    }
+    /* Keep the table at most half full */
+    if ((size_t)(table->num_codes + 1) * 2 > table->num_slots
+            && grow_slots(table) < 0) {
+        return -1;
+    }
+    if (table->num_codes == table->codes_capacity) {
+        npy_intp capacity = table->codes_capacity * 2 + 16;
+        size_t *ends = PyMem_RawRealloc(
+                table->ends, capacity * sizeof(size_t));
+        if (ends == NULL) {
+            return -1;
+        }
+        table->ends = ends;
+        npy_uint64 *hashes = PyMem_RawRealloc(
+                table->hashes, capacity * sizeof(npy_uint64));
+        if (hashes == NULL) {
+            return -1;
+        }
+        table->hashes = hashes;
+        table->codes_capacity = capacity;
+    }
+    if (table->chars == NULL || table->capacity - table->length < length) {
+        size_t capacity = table->capacity * 2 + length + 256;
+        Py_UCS4 *chars = PyMem_RawRealloc(
+                table->chars, capacity * sizeof(Py_UCS4));
+        if (chars == NULL) {
+            return -1;
+        }
+        table->chars = chars;
+        table->capacity = capacity;
+    }
+    memcpy(table->chars + table->length, str, length * sizeof(Py_UCS4));
+    table->length += length;
+    if (length > table->max_length) {
+        table->max_length = length;
+    }
+
+    npy_intp code = table->num_codes++;
+    table->ends[code] = table->length;
+    table->hashes[code] = hash;
+    size_t mask = table->num_slots - 1;
+    size_t i = (size_t)hash & mask;
+    while (table->slots[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    table->slots[i] = code + 1;
+    return code;
+}
+
+
+static npy_intp
+category_code(category_table *table, const Py_UCS4 *str, const Py_UCS4 *end)
+{
+    size_t length = end - str;
+    npy_uint64 hash = hash_field(str, end);
+    size_t mask = table->num_slots - 1;
+    size_t i = (size_t)hash & mask;
+    while (table->slots[i] != 0) {
+        npy_intp code = table->slots[i] - 1;
+        if (table->hashes[code] == hash) {
+            size_t start = code == 0 ? 0 : table->ends[code - 1];
+            if (table->ends[code] - start == length && memcmp(
+                    table->chars + start, str, length * sizeof(Py_UCS4)) == 0) {
+                return code;
+            }
+        }
+        i = (i + 1) & mask;
+    }
+    return add_category(table, hash, str, length);
+}
+
+
+int
+category_table_store_code(category_table *table, PyArray_Descr *descr,
+        const Py_UCS4 *str, const Py_UCS4 *end, char *item_ptr)
+{
+    npy_intp code = category_code(table, str, end);
+    if (code < 0) {
+        return -1;
+    }
+    /* The code fits by construction, the sign does not matter */
+    switch (descr->elsize) {
+        case 1: {
+            uint8_t x = (uint8_t)code;
+            memcpy(item_ptr, &x, 1);
+            break;
+        }
+        case 2: {
+            uint16_t x = (uint16_t)code;
+            memcpy(item_ptr, &x, 2);
+            break;
+        }
+        case 4: {
+            uint32_t x = (uint32_t)code;
+            memcpy(item_ptr, &x, 4);
+            break;
+        }
+        default: {
+            uint64_t x = (uint64_t)code;
+            memcpy(item_ptr, &x, 8);
+            break;
+        }
+    }
+    return 0;
+}
+
+
+PyArrayObject *
+category_table_uniques(category_table *table)
+{
+    size_t length = table->max_length > 0 ? table->max_length : 1;
+    if (length > (size_t)(INT_MAX / 4)) {
+        PyErr_SetString(PyExc_ValueError, "category too long.");
+        return NULL;
+    }
+    PyArray_Descr *descr = PyArray_DescrNewFromType(NPY_UNICODE);
+    if (descr == NULL) {
+        return NULL;
+    }
+    descr->elsize = (int)(4 * length);
+    npy_intp shape = table->num_codes;
+    PyArrayObject *arr = (PyArrayObject *)PyArray_NewFromDescr(
+            &PyArray_Type, descr, 1, &shape, NULL, NULL, 0, NULL);
+    if (arr == NULL) {
+        return NULL;
+    }
+    memset(PyArray_BYTES(arr), 0, PyArray_NBYTES(arr));
+    size_t start = 0;
+    for (npy_intp code = 0; code < table->num_codes; code++) {
+        size_t end = table->ends[code];
+        memcpy(PyArray_BYTES(arr) + code * 4 * length,
+                table->chars + start, (end - start) * sizeof(Py_UCS4));
+        start = end;
+    }
+    return arr;
+}
@@ -0,0 +1,60 @@
+#ifndef _CATEGORIES_H_
+#define _CATEGORIES_H_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "numpy/ndarraytypes.h"
+
+/*
+ * Dictionary encoding of a column: Each distinct field is assigned the next
+ * integer code when it is first seen and the result stores only the code.
+ * The table only uses the raw allocator, so that it can be used without
+ * holding the GIL.
+ */
+typedef struct {
+    /* The column as given by the user (for the result dictionary) */
+    PyObject *key;
+    /* The characters of all categories and the end of each one */
+    Py_UCS4 *chars;
+    size_t length;
+    size_t capacity;
+    size_t *ends;
+    npy_uint64 *hashes;
+    npy_intp num_codes;
+    npy_intp codes_capacity;
+    size_t max_length;
+    /* code + 1 of the category in each slot, 0 if the slot is empty */
+    npy_intp *slots;
+    size_t num_slots;
+    /* The largest code the integer dtype of the column can hold */
+    npy_intp max_code;
+} category_table;
+
+
+/*
+ * Create the table for column `key` of the result, whose codes are stored
+ * with the (native, integer) dtype `descr`.  Returns NULL with an error set
+ * on failure.
+ */
+category_table *
+category_table_new(PyObject *key, PyArray_Descr *descr);
+
+void
+category_table_free(category_table *table);
+
+/*
+ * Store the code of the field in `item_ptr`, adding a new category if
+ * necessary.  Returns -1 (without setting an error) if out of memory or
+ * if the dtype cannot hold the new code.
+ */
+int
+category_table_store_code(category_table *table, PyArray_Descr *descr,
+        const Py_UCS4 *str, const Py_UCS4 *end, char *item_ptr);
+
+/*
+ * Returns a new unicode array of the categories, ordered by their code.
+ */
+PyArrayObject *
+category_table_uniques(category_table *table);
+
+#endif
@@ -10,20 +10,31 @@
 #define PY_ARRAY_UNIQUE_SYMBOL npreadtext_ARRAY_API
 #include "numpy/arrayobject.h"
 
+
+/*
+ * Converters defined for all three unicode kinds as `<name>_Py_UCS1`,
+ * `<name>_Py_UCS2` and `<name>_Py_UCS4`.
+ */
+#define DECLARE_KIND_CONVERSION_PROTOTYPE(name, type)                   \
+    int                                                                 \
+    name##_##type(PyArray_Descr *descr,                                 \
+            const type *str, const type *end, char *dataptr,            \
+            parser_config *pconfig);
+
+#define DECLARE_KIND_CONVERSION_PROTOTYPES(name)                        \
+    DECLARE_KIND_CONVERSION_PROTOTYPE(name, Py_UCS1)                    \
+    DECLARE_KIND_CONVERSION_PROTOTYPE(name, Py_UCS2)                    \
+    DECLARE_KIND_CONVERSION_PROTOTYPE(name, Py_UCS4)
+
+
 int
 to_bool(PyArray_Descr *descr,
         const Py_UCS4 *str, const Py_UCS4 *end, char *dataptr,
         parser_config *pconfig);
 
-int
-to_float(PyArray_Descr *descr,
-        const Py_UCS4 *str, const Py_UCS4 *end, char *dataptr,
-        parser_config *pconfig);
+DECLARE_KIND_CONVERSION_PROTOTYPES(to_float)
 
-int
-to_double(PyArray_Descr *descr,
-        const Py_UCS4 *str, const Py_UCS4 *end, char *dataptr,
-        parser_config *pconfig);
+DECLARE_KIND_CONVERSION_PROTOTYPES(to_double)
 
 int
 to_cfloat(PyArray_Descr *descr,
@@ -35,15 +46,20 @@ to_cdouble(PyArray_Descr *descr,
         const Py_UCS4 *str, const Py_UCS4 *end, char *dataptr,
         parser_config *pconfig);
 
-int
-to_string(PyArray_Descr *descr,
-        const Py_UCS4 *str, const Py_UCS4 *end, char *dataptr,
-        parser_config *unused);
+DECLARE_KIND_CONVERSION_PROTOTYPES(to_string)
 
+DECLARE_KIND_CONVERSION_PROTOTYPES(to_unicode)
+
+/*
+ * The datetime unit if it is supported by `to_datetime` (no multiplier and
+ * not finer than nanoseconds), otherwise -1.
+ */
 int
-to_unicode(PyArray_Descr *descr,
-        const Py_UCS4 *str, const Py_UCS4 *end, char *dataptr,
-        parser_config *unused);
+native_datetime_unit(PyArray_Descr *descr);
+
+DECLARE_KIND_CONVERSION_PROTOTYPES(to_datetime)
+
+DECLARE_KIND_CONVERSION_PROTOTYPES(to_timedelta)
 
 int
 to_generic_with_converter(PyArray_Descr *descr,
@@ -23,29 +23,40 @@ field_types_xclear(int num_field_types, field_type *ft) {
 }
 
 
+#define SET_KIND_FUNCTIONS(ft, name)                \
+    (ft)->set_from_ucs4 = &name##_Py_UCS4;          \
+    (ft)->set_from_ucs2 = &name##_Py_UCS2;          \
+    (ft)->set_from_ucs1 = &name##_Py_UCS1;          \
+    return
+
 /*
  * Fetch custom converters for the builtin NumPy DTypes (or the generic one).
  * Structured DTypes get unpacked and `object` uses the generic method.
+ * Only some converters are defined for the 1 and 2 byte unicode kinds.
  *
  * TODO: This should probably be moved on the DType object in some form,
  *       to allow user DTypes to define their own converters.
  */
-static set_from_ucs4_function *
-get_from_ucs4_function(PyArray_Descr *descr)
+static void
+set_from_functions(PyArray_Descr *descr, field_type *ft)
 {
+    ft->set_from_ucs2 = NULL;
+    ft->set_from_ucs1 = NULL;
+
     if (descr->type_num == NPY_BOOL) {
-        return &to_bool;
+        ft->set_from_ucs4 = &to_bool;
+        return;
     }
     else if (PyDataType_ISSIGNED(descr)) {
         switch (descr->elsize) {
             case 1:
-                return &to_int8;
+                SET_KIND_FUNCTIONS(ft, to_int8);
             case 2:
-                return &to_int16;
+                SET_KIND_FUNCTIONS(ft, to_int16);
             case 4:
-                return &to_int32;
+                SET_KIND_FUNCTIONS(ft, to_int32);
             case 8:
-                return &to_int64;
+                SET_KIND_FUNCTIONS(ft, to_int64);
             default:
                 assert(0);
         }
@@ -53,38 +64,49 @@ get_from_ucs4_function(PyArray_Descr *descr)
     else if (PyDataType_ISUNSIGNED(descr)) {
         switch (descr->elsize) {
             case 1:
-                return &to_uint8;
+                SET_KIND_FUNCTIONS(ft, to_uint8);
             case 2:
-                return &to_uint16;
+                SET_KIND_FUNCTIONS(ft, to_uint16);
             case 4:
-                return &to_uint32;
+                SET_KIND_FUNCTIONS(ft, to_uint32);
             case 8:
-                return &to_uint64;
+                SET_KIND_FUNCTIONS(ft, to_uint64);
             default:
                 assert(0);
         }
     }
     else if (descr->type_num == NPY_FLOAT) {
-        return &to_float;
+        SET_KIND_FUNCTIONS(ft, to_float);
     }
     else if (descr->type_num == NPY_DOUBLE) {
-        return &to_double;
+        SET_KIND_FUNCTIONS(ft, to_double);
     }
     else if (descr->type_num == NPY_CFLOAT) {
-        return &to_cfloat;
+        ft->set_from_ucs4 = &to_cfloat;
+        return;
     }
     else if (descr->type_num == NPY_CDOUBLE) {
-        return &to_cdouble;
+        ft->set_from_ucs4 = &to_cdouble;
+        return;
     }
     else if (descr->type_num == NPY_STRING) {
-        return &to_string;
+        SET_KIND_FUNCTIONS(ft, to_string);
     }
     else if (descr->type_num == NPY_UNICODE) {
-        return &to_unicode;
+        SET_KIND_FUNCTIONS(ft, to_unicode);
+    }
+    else if (descr->type_num == NPY_DATETIME
+             && native_datetime_unit(descr) >= 0) {
+        SET_KIND_FUNCTIONS(ft, to_datetime);
     }
-    return &to_generic;
+    else if (descr->type_num == NPY_TIMEDELTA) {
+        SET_KIND_FUNCTIONS(ft, to_timedelta);
+    }
+    ft->set_from_ucs4 = &to_generic;
 }
 
+#undef SET_KIND_FUNCTIONS
+
 
 /*
  * Note that the function cleans up `ft` on error.  If `num_field_types < 0`
@@ -163,7 +185,10 @@ field_type_grow_recursive(PyArray_Descr *descr,
 
     Py_INCREF(descr);
     (*ft)[num_field_types].descr = descr;
-    (*ft)[num_field_types].set_from_ucs4 = get_from_ucs4_function(descr);
+    set_from_functions(descr, &(*ft)[num_field_types]);
+    /* The generic converter works with Python objects */
+    (*ft)[num_field_types].needs_pyapi = (
+            (*ft)[num_field_types].set_from_ucs4 == &to_generic);
     (*ft)[num_field_types].structured_offset = field_offset;
 
     return num_field_types + 1;
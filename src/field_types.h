@@ -26,13 +26,34 @@
  * NOTE: We are currently passing the parser config, this could be made public
  *       or could be set up to be dtype specific/private.  Always passing
  *       pconfig fully seems easier right now even if it may change.
+ *
+ * The string is given as `[str, end)` and usually points directly into the
+ * data read from the file, so it is not NUL terminated: Functions must not
+ * read `*end`.  Functions for 1 and 2 byte unicode kinds are optional, if
+ * they are not provided the string is converted to UCS4 first.
  */
 typedef int (set_from_ucs4_function)(
         PyArray_Descr *descr, const Py_UCS4 *str, const Py_UCS4 *end,
         char *dataptr, parser_config *pconfig);
 
+typedef int (set_from_ucs2_function)(
+        PyArray_Descr *descr, const Py_UCS2 *str, const Py_UCS2 *end,
+        char *dataptr, parser_config *pconfig);
+
+typedef int (set_from_ucs1_function)(
+        PyArray_Descr *descr, const Py_UCS1 *str, const Py_UCS1 *end,
+        char *dataptr, parser_config *pconfig);
+
 typedef struct _field_type {
     set_from_ucs4_function *set_from_ucs4;
+    /* Optional, may be NULL */
+    set_from_ucs2_function *set_from_ucs2;
+    set_from_ucs1_function *set_from_ucs1;
+    /*
+     * Whether `set_from_ucs4` must be called with the GIL held.  Otherwise
+     * it grabs the GIL itself where necessary (e.g. to set an error).
+     */
+    bool needs_pyapi;
     /* The original NumPy descriptor */
     PyArray_Descr *descr;
     /* Offset to this entry within row. */
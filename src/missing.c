@@ -0,0 +1,371 @@
+/*
+ * Missing value handling (`missing_values` and `filling_values`).  Missing
+ * fields are detected on the characters of the field as tokenized, so that
+ * files with missing values are converted natively like any other file.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <string.h>
+#include <math.h>
+
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL npreadtext_ARRAY_API
+#include "numpy/arrayobject.h"
+
+#include "missing.h"
+
+
+static void
+missing_field_free(missing_field *mf)
+{
+    if (mf == NULL) {
+        return;
+    }
+    PyMem_Free(mf->chars);
+    PyMem_Free(mf->ends);
+    PyMem_Free(mf->fill);
+    PyMem_Free(mf);
+}
+
+
+/*
+ * Store the fill value for `descr`, strings are stored as their characters.
+ */
+static int
+missing_field_set_fill(missing_field *mf, PyObject *fill, PyObject *key,
+        PyArray_Descr *descr)
+{
+    if (descr->type_num == NPY_STRING || descr->type_num == NPY_UNICODE) {
+        PyObject *str;
+        if (fill == Py_None) {
+            str = PyUnicode_FromStringAndSize(NULL, 0);
+        }
+        else if (PyBytes_Check(fill)) {
+            str = PyUnicode_DecodeLatin1(
+                    PyBytes_AS_STRING(fill), PyBytes_GET_SIZE(fill), NULL);
+        }
+        else {
+            str = PyObject_Str(fill);
+        }
+        if (str == NULL) {
+            return -1;
+        }
+        mf->fill_length = PyUnicode_GET_LENGTH(str);
+        mf->fill = (char *)PyUnicode_AsUCS4Copy(str);
+        Py_DECREF(str);
+        if (mf->fill == NULL) {
+            return -1;
+        }
+        mf->fill_is_string = true;
+        return 0;
+    }
+
+    mf->fill = PyMem_Calloc(descr->elsize > 0 ? descr->elsize : 1, 1);
+    if (mf->fill == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    PyObject *value = fill;
+    if (value == Py_None && (descr->kind == 'f' || descr->kind == 'c')) {
+        value = PyFloat_FromDouble(NAN);
+    }
+    else if (value == Py_None && (descr->kind == 'M' || descr->kind == 'm')) {
+        value = PyUnicode_FromString("NaT");
+    }
+    else if (value == Py_None) {
+        return 0;  /* all other dtypes are filled with zeros */
+    }
+    else {
+        Py_INCREF(value);
+    }
+    if (value == NULL) {
+        return -1;
+    }
+    Py_INCREF(descr);
+    PyArrayObject *arr = (PyArrayObject *)PyArray_FromAny(
+            value, descr, 0, 0, 0, NULL);
+    Py_DECREF(value);
+    if (arr == NULL) {
+        return -1;
+    }
+    if (PyArray_NDIM(arr) != 0) {
+        Py_DECREF(arr);
+        PyErr_Format(PyExc_ValueError,
+                "the filling value of column %R must be a scalar.", key);
+        return -1;
+    }
+    memcpy(mf->fill, PyArray_DATA(arr), descr->elsize);
+    Py_DECREF(arr);
+    return 0;
+}
+
+
+/*
+ * Create the handling of column `key`, `spec` is a tuple (sentinels, fill).
+ */
+static missing_field *
+missing_field_new(PyObject *spec, PyObject *key, PyArray_Descr *descr)
+{
+    PyObject *sentinels, *fill;
+    if (!PyTuple_Check(spec) || PyTuple_GET_SIZE(spec) != 2) {
+        PyErr_Format(PyExc_TypeError,
+                "internal error: the missing values of column %R must be "
+                "a tuple (sentinels, fill).", key);
+        return NULL;
+    }
+    sentinels = PyTuple_GET_ITEM(spec, 0);
+    fill = PyTuple_GET_ITEM(spec, 1);
+    if (PyDataType_REFCHK(descr)) {
+        PyErr_Format(PyExc_TypeError,
+                "missing values are not supported for column %R with "
+                "dtype %S.", key, descr);
+        return NULL;
+    }
+
+    missing_field *mf = PyMem_Calloc(1, sizeof(missing_field));
+    if (mf == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    PyObject *seq = PySequence_Fast(
+            sentinels, "missing values must be a sequence of strings.");
+    if (seq == NULL) {
+        goto error;
+    }
+    Py_ssize_t num_sentinels = PySequence_Fast_GET_SIZE(seq);
+    size_t total_length = 0;
+    for (Py_ssize_t i = 0; i < num_sentinels; i++) {
+        PyObject *sentinel = PySequence_Fast_GET_ITEM(seq, i);
+        if (!PyUnicode_Check(sentinel)) {
+            PyErr_Format(PyExc_TypeError,
+                    "missing values must be strings; got %.100R", sentinel);
+            goto error;
+        }
+        total_length += PyUnicode_GET_LENGTH(sentinel);
+    }
+    mf->chars = PyMem_Malloc((total_length + 1) * sizeof(Py_UCS4));
+    mf->ends = PyMem_Malloc((num_sentinels + 1) * sizeof(size_t));
+    if (mf->chars == NULL || mf->ends == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    size_t end = 0;
+    for (Py_ssize_t i = 0; i < num_sentinels; i++) {
+        PyObject *sentinel = PySequence_Fast_GET_ITEM(seq, i);
+        size_t length = PyUnicode_GET_LENGTH(sentinel);
+        if (PyUnicode_AsUCS4(sentinel, mf->chars + end,
+                total_length + 1 - end, 0) == NULL) {
+            goto error;
+        }
+        end += length;
+        mf->ends[i] = end;
+        if (length > mf->max_length) {
+            mf->max_length = length;
+        }
+    }
+    mf->num_sentinels = (int)num_sentinels;
+    Py_CLEAR(seq);
+
+    if (missing_field_set_fill(mf, fill, key, descr) < 0) {
+        goto error;
+    }
+    return mf;
+
+  error:
+    Py_XDECREF(seq);
+    missing_field_free(mf);
+    return NULL;
+}
+
+
+missing_state *
+missing_state_create(PyObject *missing, int num_fields, int32_t *usecols,
+        field_type *field_types, bool homogeneous, bool record)
+{
+    if (!PyDict_Check(missing)) {
+        PyErr_SetString(PyExc_TypeError,
+                "internal error: missing must be a dictionary.");
+        return NULL;
+    }
+    missing_state *ms = PyMem_Calloc(1, sizeof(missing_state));
+    if (ms == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    ms->num_fields = num_fields;
+    ms->record = record;
+    ms->fields = PyMem_Calloc(
+            num_fields > 0 ? num_fields : 1, sizeof(missing_field *));
+    if (ms->fields == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    PyObject *default_spec = PyDict_GetItemWithError(missing, Py_None);
+    if (default_spec == NULL && PyErr_Occurred()) {
+        goto error;
+    }
+    if (default_spec != NULL) {
+        for (int i = 0; i < num_fields; i++) {
+            ms->fields[i] = missing_field_new(default_spec, Py_None,
+                    field_types[homogeneous ? 0 : i].descr);
+            if (ms->fields[i] == NULL) {
+                goto error;
+            }
+        }
+    }
+
+    PyObject *key, *spec;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(missing, &pos, &key, &spec)) {
+        if (key == Py_None) {
+            continue;
+        }
+        Py_ssize_t column = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if (column == -1 && PyErr_Occurred()) {
+            PyErr_Format(PyExc_TypeError,
+                    "columns of the missing values must be integers; "
+                    "got %.100R", key);
+            goto error;
+        }
+        if (usecols != NULL) {
+            int i = 0;
+            for (; i < num_fields; i++) {
+                if (column == usecols[i]) {
+                    column = i;
+                    break;
+                }
+            }
+            if (i == num_fields) {
+                continue;  /* ignore unused column */
+            }
+        }
+        else {
+            if (column < -num_fields || column >= num_fields) {
+                PyErr_Format(PyExc_ValueError,
+                        "missing values specified for column %zd, which is "
+                        "invalid for the number of fields %d.",
+                        column, num_fields);
+                goto error;
+            }
+            if (column < 0) {
+                column += num_fields;
+            }
+        }
+        missing_field *mf = missing_field_new(
+                spec, key, field_types[homogeneous ? 0 : column].descr);
+        if (mf == NULL) {
+            goto error;
+        }
+        missing_field_free(ms->fields[column]);
+        ms->fields[column] = mf;
+    }
+    return ms;
+
+  error:
+    missing_state_free(ms);
+    return NULL;
+}
+
+
+void
+missing_state_free(missing_state *ms)
+{
+    if (ms == NULL) {
+        return;
+    }
+    if (ms->fields != NULL) {
+        for (int i = 0; i < ms->num_fields; i++) {
+            missing_field_free(ms->fields[i]);
+        }
+        PyMem_Free(ms->fields);
+    }
+    PyMem_RawFree(ms->positions);
+    PyMem_Free(ms);
+}
+
+
+int
+missing_field_fill(missing_state *ms, int field, npy_intp row,
+        field_type *ft, char *item_ptr, parser_config *pconfig)
+{
+    missing_field *mf = ms->fields[field];
+    if (mf->fill_is_string) {
+        const Py_UCS4 *str = (const Py_UCS4 *)mf->fill;
+        if (ft->set_from_ucs4(ft->descr,
+                str, str + mf->fill_length, item_ptr, pconfig) < 0) {
+            return -1;
+        }
+    }
+    else {
+        memcpy(item_ptr, mf->fill, ft->descr->elsize);
+    }
+    return missing_state_record(ms, field, row);
+}
+
+
+int
+missing_state_record(missing_state *ms, int field, npy_intp row)
+{
+    if (!ms->record) {
+        return 0;
+    }
+    if (ms->num_positions == ms->capacity) {
+        size_t capacity = ms->capacity ? ms->capacity * 2 : 1024;
+        npy_intp *positions = PyMem_RawRealloc(
+                ms->positions, capacity * 2 * sizeof(npy_intp));
+        if (positions == NULL) {
+            return -1;
+        }
+        ms->positions = positions;
+        ms->capacity = capacity;
+    }
+    ms->positions[2 * ms->num_positions] = row;
+    ms->positions[2 * ms->num_positions + 1] = field;
+    ms->num_positions++;
+    return 0;
+}
+
+
+size_t
+missing_state_fill_length(missing_state *ms)
+{
+    size_t length = 0;
+    if (ms == NULL) {
+        return length;
+    }
+    for (int i = 0; i < ms->num_fields; i++) {
+        missing_field *mf = ms->fields[i];
+        if (mf != NULL && mf->fill_is_string && mf->fill_length > length) {
+            length = mf->fill_length;
+        }
+    }
+    return length;
+}
+
+
+PyObject *
+missing_state_positions(missing_state *ms)
+{
+    npy_intp num_positions = ms == NULL ? 0 : ms->num_positions;
+    PyArrayObject *rows = (PyArrayObject *)PyArray_SimpleNew(
+            1, &num_positions, NPY_INTP);
+    if (rows == NULL) {
+        return NULL;
+    }
+    PyArrayObject *fields = (PyArrayObject *)PyArray_SimpleNew(
+            1, &num_positions, NPY_INTP);
+    if (fields == NULL) {
+        Py_DECREF(rows);
+        return NULL;
+    }
+    npy_intp *rows_data = PyArray_DATA(rows);
+    npy_intp *fields_data = PyArray_DATA(fields);
+    for (npy_intp i = 0; i < num_positions; i++) {
+        rows_data[i] = ms->positions[2 * i];
+        fields_data[i] = ms->positions[2 * i + 1];
+    }
+    return Py_BuildValue("(NN)", rows, fields);
+}
@@ -0,0 +1,136 @@
+#ifndef _MISSING_H_
+#define _MISSING_H_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdbool.h>
+#include "numpy/ndarraytypes.h"
+
+#include "field_types.h"
+#include "parser_config.h"
+
+/*
+ * Missing value handling of a field: A field which is empty (or only
+ * whitespace) or equal to one of the sentinels (ignoring surrounding
+ * whitespace) is not converted, the fill value is stored instead.  Only
+ * `missing_state_create` and `missing_state_free` need the GIL.
+ */
+typedef struct {
+    /* The characters of all sentinels and the end of each one */
+    Py_UCS4 *chars;
+    size_t *ends;
+    int num_sentinels;
+    size_t max_length;
+    /*
+     * The fill value as stored in the result, or for strings its
+     * `fill_length` characters which are converted like a field (so that
+     * the string length may still be discovered).
+     */
+    char *fill;
+    size_t fill_length;
+    bool fill_is_string;
+} missing_field;
+
+
+typedef struct {
+    int num_fields;
+    /* The missing value handling of each field (entries may be NULL) */
+    missing_field **fields;
+    /* Whether to record the (row, field) pairs of the missing fields */
+    bool record;
+    npy_intp *positions;
+    size_t num_positions;
+    size_t capacity;
+} missing_state;
+
+
+/*
+ * Create the missing value handling of the `num_fields` fields from the
+ * dictionary `missing` mapping columns (given and mapped like the keys of
+ * the converters) to a tuple `(sentinels, fill)` where `sentinels` is a
+ * tuple of strings and `fill` the fill value (None for the default of the
+ * dtype: NaN, NaT or 0).  The entry for the key None applies to all other
+ * columns.  Returns NULL with an error set on failure.
+ */
+missing_state *
+missing_state_create(PyObject *missing, int num_fields, int32_t *usecols,
+        field_type *field_types, bool homogeneous, bool record);
+
+void
+missing_state_free(missing_state *ms);
+
+
+/*
+ * Whether the field `[start, end)` of the row `data` (of unicode `kind`)
+ * is missing.
+ */
+static NPY_INLINE bool
+missing_field_matches(missing_field *mf, int kind, const char *data,
+        size_t start, size_t end)
+{
+    while (start < end
+            && Py_UNICODE_ISSPACE(PyUnicode_READ(kind, data, start))) {
+        start++;
+    }
+    while (end > start
+            && Py_UNICODE_ISSPACE(PyUnicode_READ(kind, data, end - 1))) {
+        end--;
+    }
+    size_t length = end - start;
+    if (length == 0) {
+        return true;
+    }
+    if (length > mf->max_length) {
+        return false;
+    }
+    size_t sentinel_start = 0;
+    for (int i = 0; i < mf->num_sentinels; i++) {
+        size_t sentinel_end = mf->ends[i];
+        if (sentinel_end - sentinel_start == length) {
+            size_t k = 0;
+            while (k < length && PyUnicode_READ(kind, data, start + k)
+                    == mf->chars[sentinel_start + k]) {
+                k++;
+            }
+            if (k == length) {
+                return true;
+            }
+        }
+        sentinel_start = sentinel_end;
+    }
+    return false;
+}
+
+
+/*
+ * Store the fill value of a missing field of type `ft` in `item_ptr` and
+ * record it as missing field `field` of `row`.  Returns -1 (without setting
+ * an error) if out of memory.
+ */
+int
+missing_field_fill(missing_state *ms, int field, npy_intp row,
+        field_type *ft, char *item_ptr, parser_config *pconfig);
+
+/*
+ * Only record the missing field `field` of `row` (if recording), e.g. for
+ * fields which are not filled.  Returns -1 (without setting an error) if
+ * out of memory.
+ */
+int
+missing_state_record(missing_state *ms, int field, npy_intp row);
+
+/*
+ * The length of the longest string fill value (0 if there is none or `ms`
+ * is NULL).
+ */
+size_t
+missing_state_fill_length(missing_state *ms);
+
+/*
+ * Returns a new tuple of two intp arrays with the rows and the fields of
+ * the recorded missing fields.
+ */
+PyObject *
+missing_state_positions(missing_state *ms);
+
+#endif
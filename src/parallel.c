@@ -0,0 +1,95 @@
+/*
+ * Minimal portable helper to run a few tasks on native threads.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <pthread.h>
+#endif
+
+#include "parallel.h"
+
+
+typedef struct {
+    parallel_task *task;
+    void *arg;
+    bool started;
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+} parallel_thread;
+
+
+#ifdef _WIN32
+static unsigned __stdcall
+thread_main(void *arg)
+{
+    parallel_thread *t = (parallel_thread *)arg;
+    t->task(t->arg);
+    return 0;
+}
+#else
+static void *
+thread_main(void *arg)
+{
+    parallel_thread *t = (parallel_thread *)arg;
+    t->task(t->arg);
+    return NULL;
+}
+#endif
+
+
+void
+parallel_run(int num_tasks, parallel_task *task, void *args, size_t arg_size)
+{
+    if (num_tasks <= 0) {
+        return;
+    }
+    parallel_thread *threads = malloc(num_tasks * sizeof(parallel_thread));
+    if (threads == NULL) {
+        /* No threads, but we can still run everything here. */
+        for (int i = 0; i < num_tasks; i++) {
+            task((char *)args + i * arg_size);
+        }
+        return;
+    }
+
+    /* The first task runs on the calling thread after starting the others */
+    for (int i = 1; i < num_tasks; i++) {
+        parallel_thread *t = &threads[i];
+        t->task = task;
+        t->arg = (char *)args + i * arg_size;
+#ifdef _WIN32
+        t->thread = (HANDLE)_beginthreadex(NULL, 0, &thread_main, t, 0, NULL);
+        t->started = t->thread != 0;
+#else
+        t->started = pthread_create(&t->thread, NULL, &thread_main, t) == 0;
+#endif
+        if (!t->started) {
+            task(t->arg);
+        }
+    }
+    task(args);
+
+    for (int i = 1; i < num_tasks; i++) {
+        parallel_thread *t = &threads[i];
+        if (!t->started) {
+            continue;
+        }
+#ifdef _WIN32
+        WaitForSingleObject(t->thread, INFINITE);
+        CloseHandle(t->thread);
+#else
+        pthread_join(t->thread, NULL);
+#endif
+    }
+    free(threads);
+}
+
@@ -0,0 +1,21 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <stddef.h>
+
+
+typedef void (parallel_task)(void *arg);
+
+/*
+ * Run `task` for each of the `num_tasks` arguments stored in `args` (each
+ * `arg_size` bytes long) on its own thread and wait for all of them to
+ * finish.  If a thread cannot be started, the task is run on the calling
+ * thread instead, so that this cannot fail.
+ *
+ * The tasks must not use the Python API without acquiring the GIL, and the
+ * caller should release the GIL if the tasks may need it.
+ */
+void
+parallel_run(int num_tasks, parallel_task *task, void *args, size_t arg_size);
+
+#endif
@@ -4,6 +4,10 @@
 
 #include <stdbool.h>
 
+/* The maximum number and length of multi-character comments */
+#define MAX_COMMENTS 4
+#define MAX_COMMENT_LENGTH 32
+
 typedef struct {
     /*
      *  Field delimiter character.
@@ -20,13 +24,22 @@ typedef struct {
     Py_UCS4 quote;
 
     /*
-     *  Character(s) that indicates the start of a comment.
+     *  Character that indicates the start of a comment.
      *  Typically '#', '%' or ';'.
      *  When encountered in a line and not inside quotes, all character
      *  from the comment character(s) to the end of the line are ignored.
      */
     Py_UCS4 comment;
 
+    /*
+     *  Multi-character (or multiple) comments such as `//` or `--`, unused
+     *  if `num_comments` is 0.  All of them start with the `comment`
+     *  character, which only starts a comment if one of them matches.
+     */
+    int num_comments;
+    int comment_lengths[MAX_COMMENTS];
+    Py_UCS4 comments[MAX_COMMENTS][MAX_COMMENT_LENGTH];
+
     /*
      *  Ignore whitespace at the beginning of a field (outside/before quotes).
      *  Is (and must be) set if `delimiter_is_whitespace`.
@@ -71,6 +84,17 @@ typedef struct {
       */
      bool python_byte_converters;
      bool c_byte_converters;
+     /*
+      * If true, Python converters are called once for a batch of rows with
+      * an array of the strings (bytes with `python_byte_converters`) of
+      * their column and return an array of the converted values.
+      */
+     bool batch_converters;
+     /*
+      * If true, the result is stored column by column (Fortran order for
+      * homogeneous results, one contiguous block per field otherwise).
+      */
+     bool column_major;
 } parser_config;
 
 
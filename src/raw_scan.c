@@ -0,0 +1,191 @@
+
+#include <string.h>
+#include <stdbool.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "numpy/ndarraytypes.h"
+
+#include "raw_scan.h"
+#include "parser_config.h"
+
+
+/*
+ * Find the first "\r" or "\n" (or `end`).
+ */
+static NPY_INLINE const char *
+find_line_end(const char *pos, const char *end)
+{
+    const char *nl = memchr(pos, '\n', end - pos);
+    if (nl == NULL) {
+        nl = end;
+    }
+    const char *cr = memchr(pos, '\r', nl - pos);
+    return cr != NULL ? cr : nl;
+}
+
+
+/*
+ * Advance past the line end character at `pos` (which must be "\r" or "\n").
+ */
+static NPY_INLINE const char *
+eat_line_end(const char *pos, const char *end)
+{
+    if (*pos == '\r' && pos + 1 < end && pos[1] == '\n') {
+        return pos + 2;
+    }
+    return pos + 1;
+}
+
+
+/*
+ * Whether the comment character at `pos` starts a comment, i.e. whether one
+ * of the multi-character comments (if any) matches.  Like the tokenizer at
+ * the end of the data, a comment cut off by `end` does not match.
+ */
+static NPY_INLINE bool
+raw_comment_at(const char *pos, const char *end, parser_config *pconfig)
+{
+    if (pconfig->num_comments == 0) {
+        return true;
+    }
+    for (int i = 0; i < pconfig->num_comments; i++) {
+        int length = pconfig->comment_lengths[i];
+        if (end - pos < length) {
+            continue;
+        }
+        int k = 0;
+        while (k < length
+                && (Py_UCS1)pos[k] == pconfig->comments[i][k]) {
+            k++;
+        }
+        if (k == length) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+const char *
+raw_skip_lines(const char *pos, const char *end, Py_ssize_t *num_lines)
+{
+    while (*num_lines > 0 && pos < end) {
+        pos = find_line_end(pos, end);
+        if (pos == end) {
+            break;  /* last line is not terminated, not counted as skipped */
+        }
+        pos = eat_line_end(pos, end);
+        *num_lines -= 1;
+    }
+    return pos;
+}
+
+
+bool
+raw_rows_may_span_lines(
+        const char *pos, const char *end, parser_config *pconfig)
+{
+    if (!pconfig->allow_embedded_newline || pconfig->quote > 255) {
+        return false;
+    }
+    return memchr(pos, (int)pconfig->quote, end - pos) != NULL;
+}
+
+
+const char *
+raw_row_end(const char *pos, const char *end,
+        parser_config *pconfig, bool quote_aware)
+{
+    if (!quote_aware) {
+        pos = find_line_end(pos, end);
+        return pos == end ? end : eat_line_end(pos, end);
+    }
+
+    /* A cut down version of the tokenizer state machine, ignores NUL */
+    enum {
+        FIELD_START, UNQUOTED, QUOTED, QUOTED_CHECK_DOUBLE_QUOTE
+    } state = FIELD_START;
+
+    const Py_UCS4 quote = pconfig->quote;
+    const Py_UCS4 delimiter = pconfig->delimiter;
+    const Py_UCS4 comment = pconfig->comment;
+
+    while (pos < end) {
+        Py_UCS1 c = (Py_UCS1)*pos;
+        switch (state) {
+            case FIELD_START:
+                if (pconfig->ignore_leading_whitespace &&
+                        Py_UNICODE_ISSPACE(c) && c != '\r' && c != '\n') {
+                    pos++;
+                }
+                else if (c == quote) {
+                    state = QUOTED;
+                    pos++;
+                }
+                else {
+                    state = UNQUOTED;
+                }
+                break;
+
+            case UNQUOTED:
+                if (c == '\r' || c == '\n') {
+                    return eat_line_end(pos, end);
+                }
+                else if (pconfig->delimiter_is_whitespace ?
+                            Py_UNICODE_ISSPACE(c) : c == delimiter) {
+                    state = FIELD_START;
+                }
+                else if (c == comment && raw_comment_at(pos, end, pconfig)) {
+                    /* the rest of the line is a comment */
+                    return raw_row_end(pos, end, pconfig, false);
+                }
+                pos++;
+                break;
+
+            case QUOTED:
+                /* only used when embedded newlines are allowed */
+                if (c == quote) {
+                    state = QUOTED_CHECK_DOUBLE_QUOTE;
+                }
+                pos++;
+                break;
+
+            case QUOTED_CHECK_DOUBLE_QUOTE:
+                if (c == quote) {
+                    state = QUOTED;
+                    pos++;
+                }
+                else {
+                    state = UNQUOTED;
+                }
+                break;
+        }
+    }
+    return end;
+}
+
+
+Py_ssize_t
+raw_count_rows(const char *pos, const char *end,
+        parser_config *pconfig, bool quote_aware)
+{
+    Py_ssize_t num_rows = 0;
+    while (pos < end) {
+        if (*pos == '\r' || *pos == '\n') {
+            /* empty lines are ignored by the tokenizer */
+            pos = eat_line_end(pos, end);
+            continue;
+        }
+        if ((Py_UCS1)*pos == pconfig->comment
+                && raw_comment_at(pos, end, pconfig)) {
+            /* as are lines which only contain a comment */
+            pos = raw_row_end(pos, end, pconfig, false);
+            continue;
+        }
+        pos = raw_row_end(pos, end, pconfig, quote_aware);
+        num_rows++;
+    }
+    return num_rows;
+}
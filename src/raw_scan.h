@@ -0,0 +1,52 @@
+#ifndef _RAW_SCAN_H_
+#define _RAW_SCAN_H_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdbool.h>
+
+#include "parser_config.h"
+
+/*
+ * Helpers scanning raw (1-byte kind) data without tokenizing it; used to
+ * find line and row boundaries, e.g. to split a file for parallel parsing.
+ * A row may span multiple lines if quoted fields contain newlines,
+ * the row scanning follows the same quoting rules as the tokenizer.
+ */
+
+/*
+ * Skip up to `*num_lines` lines (like `skiprows`, quotes are ignored).
+ * Returns the new position, `*num_lines` is decremented by the number of
+ * lines which were skipped (it is larger than 0 only if `end` was reached).
+ */
+const char *
+raw_skip_lines(const char *pos, const char *end, Py_ssize_t *num_lines);
+
+/*
+ * Whether the row boundaries in `[pos, end)` are not simply line ends
+ * because a quoted field may contain a newline.
+ */
+bool
+raw_rows_may_span_lines(
+        const char *pos, const char *end, parser_config *pconfig);
+
+/*
+ * Returns the position just after the end of the row starting at `pos`.
+ * If `quote_aware` is false, the row ends at the first line end.  Note that
+ * a "\r\n" is only eaten fully if both characters are within the range.
+ */
+const char *
+raw_row_end(const char *pos, const char *end,
+        parser_config *pconfig, bool quote_aware);
+
+/*
+ * Count the rows in `[pos, end)` (empty lines are not counted).  This is
+ * an upper bound for the number of rows the tokenizer returns, it may be
+ * larger since e.g. lines containing only whitespace are counted.  Rows
+ * end at line ends unless `quote_aware` (see `raw_rows_may_span_lines`).
+ */
+Py_ssize_t
+raw_count_rows(const char *pos, const char *end,
+        parser_config *pconfig, bool quote_aware);
+
+#endif
@@ -0,0 +1,80 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL npreadtext_ARRAY_API
+#include "numpy/ndarraytypes.h"
+
+#include "read_stats.h"
+
+
+int64_t
+read_stats_now(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency = {0};
+    LARGE_INTEGER count;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&count);
+    return (int64_t)(count.QuadPart * (1e9 / (double)frequency.QuadPart));
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+
+/* The counters in the order of the struct, which only holds `int64_t` */
+static const char *stats_names[] = {
+    "bytes_consumed", "buffer_refills", "nextbuf_ns",
+    "rows_tokenized", "fields_tokenized",
+    "field_buffer_regrowths", "fields_regrowths",
+    "count_rows_ns", "tokenize_ns",
+    "python_converter_calls", "python_converter_ns", "convert_ns",
+    "output_reallocs", "output_bytes_copied", "grow_ns",
+};
+
+#define NUM_STATS ((int)(sizeof(stats_names) / sizeof(stats_names[0])))
+
+/* Fails to compile if a counter was added to only one of them */
+typedef char stats_names_check[
+        sizeof(read_stats) == NUM_STATS * sizeof(int64_t) ? 1 : -1];
+
+
+void
+read_stats_add(read_stats *stats, const read_stats *other)
+{
+    int64_t *counters = (int64_t *)stats;
+    const int64_t *others = (const int64_t *)other;
+    for (int i = 0; i < NUM_STATS; i++) {
+        counters[i] += others[i];
+    }
+}
+
+
+int
+read_stats_to_dict(const read_stats *stats, PyObject *dict)
+{
+    const int64_t *counters = (const int64_t *)stats;
+    for (int i = 0; i < NUM_STATS; i++) {
+        PyObject *value = PyLong_FromLongLong(counters[i]);
+        if (value == NULL) {
+            return -1;
+        }
+        int res = PyDict_SetItemString(dict, stats_names[i], value);
+        Py_DECREF(value);
+        if (res < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
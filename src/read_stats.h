@@ -0,0 +1,69 @@
+#ifndef _READ_STATS_H_
+#define _READ_STATS_H_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+#include "numpy/ndarraytypes.h"
+
+/*
+ * Optional counters describing where the time of a read went.  The
+ * tokenizer and `read_rows` update them if `tokenizer_state.stats` is not
+ * NULL (which adds a clock read per row and phase).  The timers are in
+ * nanoseconds (summed over threads when reading in parallel),
+ * `tokenize_ns` includes `nextbuf_ns` and `convert_ns` includes
+ * `python_converter_ns`.
+ */
+typedef struct {
+    /* Stream */
+    int64_t bytes_consumed;
+    int64_t buffer_refills;
+    int64_t nextbuf_ns;
+    /* Tokenizer */
+    int64_t rows_tokenized;
+    int64_t fields_tokenized;
+    int64_t field_buffer_regrowths;
+    int64_t fields_regrowths;
+    int64_t count_rows_ns;
+    int64_t tokenize_ns;
+    /* Conversion (including the Python converters) */
+    int64_t python_converter_calls;
+    int64_t python_converter_ns;
+    int64_t convert_ns;
+    /* Result */
+    int64_t output_reallocs;
+    int64_t output_bytes_copied;
+    int64_t grow_ns;
+} read_stats;
+
+
+/* A monotonic clock in nanoseconds (valid without the GIL) */
+int64_t
+read_stats_now(void);
+
+static NPY_INLINE int64_t
+read_stats_start(read_stats *stats)
+{
+    return stats == NULL ? 0 : read_stats_now();
+}
+
+/* Add the time since `start` to the `timer` field of `stats` (if any) */
+#define READ_STATS_STOP(stats, timer, start)  \
+        do {  \
+            if ((stats) != NULL) {  \
+                (stats)->timer += read_stats_now() - (start);  \
+            }  \
+        } while (0)
+
+/* Add the counters of `other` (e.g. of a parallel chunk) to `stats` */
+void
+read_stats_add(read_stats *stats, const read_stats *other);
+
+/*
+ * Store the counters in the dictionary `dict` (replacing the previous
+ * values).  Returns -1 with an error set on failure.
+ */
+int
+read_stats_to_dict(const read_stats *stats, PyObject *dict);
+
+#endif
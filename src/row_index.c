@@ -0,0 +1,124 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <string.h>
+#include <stdbool.h>
+
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL npreadtext_ARRAY_API
+#include "numpy/arrayobject.h"
+
+#include "row_index.h"
+#include "raw_scan.h"
+#include "parser_config.h"
+
+
+/*
+ * Rows are always scanned quote aware if quotes may contain newlines (even
+ * if there are no quotes so far), so that the index stays valid when the
+ * file is appended to.
+ */
+static NPY_INLINE bool
+index_is_quote_aware(parser_config *pconfig)
+{
+    return pconfig->allow_embedded_newline && pconfig->quote <= 255;
+}
+
+
+/*
+ * Skip up to `*num_rows` rows, decrementing `*num_rows` by the number of
+ * rows skipped.  Like `raw_skip_lines`, an unterminated last row is skipped
+ * but not counted.
+ */
+static const char *
+skip_rows(const char *pos, const char *end, parser_config *pconfig,
+        bool quote_aware, Py_ssize_t *num_rows)
+{
+    while (*num_rows > 0 && pos < end) {
+        pos = raw_row_end(pos, end, pconfig, quote_aware);
+        if (pos == end && end[-1] != '\n' && end[-1] != '\r') {
+            break;
+        }
+        *num_rows -= 1;
+    }
+    return pos;
+}
+
+
+PyArrayObject *
+row_index_build(const char *start, const char *end,
+        parser_config *pconfig, npy_intp every)
+{
+    bool quote_aware = index_is_quote_aware(pconfig);
+    npy_intp num_offsets = 0;
+    npy_intp capacity = 1024;
+    npy_int64 *offsets = PyMem_RawMalloc(capacity * sizeof(npy_int64));
+    if (offsets == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    bool failed = false;
+    Py_BEGIN_ALLOW_THREADS;
+    const char *pos = start;
+    while (true) {
+        if (num_offsets == capacity) {
+            capacity *= 2;
+            npy_int64 *new_offsets = PyMem_RawRealloc(
+                    offsets, capacity * sizeof(npy_int64));
+            if (new_offsets == NULL) {
+                failed = true;
+                break;
+            }
+            offsets = new_offsets;
+        }
+        offsets[num_offsets++] = pos - start;
+        Py_ssize_t num_rows = every;
+        pos = skip_rows(pos, end, pconfig, quote_aware, &num_rows);
+        if (num_rows > 0) {
+            break;  /* the last block is incomplete */
+        }
+    }
+    Py_END_ALLOW_THREADS;
+
+    if (failed) {
+        PyMem_RawFree(offsets);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    PyArrayObject *res = (PyArrayObject *)PyArray_SimpleNew(
+            1, &num_offsets, NPY_INT64);
+    if (res != NULL) {
+        memcpy(PyArray_BYTES(res), offsets, num_offsets * sizeof(npy_int64));
+    }
+    PyMem_RawFree(offsets);
+    return res;
+}
+
+
+const char *
+row_index_find(const char *start, const char *end, parser_config *pconfig,
+        const npy_int64 *offsets, npy_intp num_offsets, npy_intp every,
+        Py_ssize_t row)
+{
+    if (num_offsets == 0 || every <= 0) {
+        PyErr_SetString(PyExc_ValueError, "the row index is empty.");
+        return NULL;
+    }
+    npy_intp i = row / every;
+    if (i >= num_offsets) {
+        i = num_offsets - 1;
+    }
+    npy_int64 offset = offsets[i];
+    /* A cheap check that the index was created for this file */
+    if (offset < 0 || offset > end - start || (offset > 0
+            && start[offset - 1] != '\n' && start[offset - 1] != '\r')) {
+        PyErr_Format(PyExc_ValueError,
+                "the row index does not match the file: row %zd is not "
+                "at byte %lld.", (Py_ssize_t)(i * every), (long long)offset);
+        return NULL;
+    }
+    Py_ssize_t num_rows = row - i * every;
+    return skip_rows(start + offset, end, pconfig,
+            index_is_quote_aware(pconfig), &num_rows);
+}
@@ -0,0 +1,41 @@
+#ifndef _ROW_INDEX_H_
+#define _ROW_INDEX_H_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "numpy/ndarraytypes.h"
+
+#include "parser_config.h"
+
+/*
+ * A row index stores the byte offset of every `every`-th row of a file, so
+ * that reading can start at any row by jumping to the closest offset and
+ * scanning at most `every` rows.  Unlike `skiprows` rows are found quote
+ * aware (a quoted field may contain newlines); empty and comment lines are
+ * counted as rows as well.  Offsets are relative to the first byte scanned,
+ * the data must be ASCII compatible.
+ */
+
+/*
+ * Returns a new 1-d int64 array with the offsets of rows 0, `every`,
+ * `2 * every`, ... of `[start, end)`.  The last offset may be `end - start`
+ * if the data ends with a complete block of rows.  Returns NULL with an
+ * error set on failure.
+ */
+PyArrayObject *
+row_index_build(const char *start, const char *end,
+        parser_config *pconfig, npy_intp every);
+
+/*
+ * Find the start of row `row` of `[start, end)` using the `num_offsets`
+ * offsets created by `row_index_build` (possibly for a shorter version of
+ * the data, e.g. before more rows were appended).  Returns `end` if there
+ * are fewer rows and NULL with an error set if the index does not match.
+ */
+const char *
+row_index_find(const char *start, const char *end, parser_config *pconfig,
+        const npy_int64 *offsets, npy_intp num_offsets, npy_intp every,
+        Py_ssize_t row);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef _ROW_LOOPS_H_
+#define _ROW_LOOPS_H_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "tokenize.h"
+#include "field_types.h"
+#include "parser_config.h"
+
+
+/*
+ * Specialized loops converting all fields of the row that was just
+ * tokenized, for homogeneous numeric results (native byte order) read
+ * without `usecols` or converters.  The converter is called directly (or
+ * inlined) and the per field checks of the generic `convert_row` in
+ * `rows.c` are not needed.  The row must have `num_fields` fields, field
+ * `i` is stored at `data_ptr + i * column_stride`.
+ *
+ * Returns 0 on success.  On failure returns -1 and sets `*err_col` to the
+ * column which failed (the GIL is not needed).
+ */
+typedef int (row_loop_function)(
+        tokenizer_state *ts, char *data_ptr, npy_intp column_stride,
+        int num_fields, PyArray_Descr *descr, parser_config *pconfig,
+        int *err_col);
+
+/*
+ * Returns the specialized row loop for the (homogeneous) field type or NULL
+ * if there is none.
+ */
+row_loop_function *
+get_row_loop(field_type *ft);
+
+#endif
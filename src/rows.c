@@ -21,6 +21,10 @@
 #include "field_types.h"
 #include "rows.h"
 #include "growth.h"
+#include "raw_scan.h"
+#include "parallel.h"
+#include "stream_file.h"
+#include "row_loops.h"
 
 /*
  * Minimum size to grow the allcoation by (or 25%). The 8KiB means the actual
@@ -113,73 +117,1039 @@ create_conv_funcs(
     return NULL;
 }
 
-/**
- * Read a file into the provided array, or create (and possibly grow) an
- * array to read into.
+
+static void
+category_tables_free(category_table **categories, int num_fields)
+{
+    if (categories == NULL) {
+        return;
+    }
+    for (int i = 0; i < num_fields; i++) {
+        category_table_free(categories[i]);
+    }
+    PyMem_FREE(categories);
+}
+
+
+/*
+ * Create the category tables for the `categorical` columns, which are
+ * given and mapped like the keys of the converters.
+ */
+static category_table **
+create_category_tables(PyObject *categorical, int num_fields,
+        int32_t *usecols, field_type *field_types, bool homogeneous,
+        PyObject **conv_funcs)
+{
+    category_table **categories = PyMem_Calloc(
+            num_fields > 0 ? num_fields : 1, sizeof(category_table *));
+    if (categories == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    PyObject *seq = PySequence_Fast(
+            categorical, "categorical must be a sequence of columns.");
+    if (seq == NULL) {
+        goto error;
+    }
+    for (Py_ssize_t k = 0; k < PySequence_Fast_GET_SIZE(seq); k++) {
+        PyObject *key = PySequence_Fast_GET_ITEM(seq, k);
+        Py_ssize_t column = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if (column == -1 && PyErr_Occurred()) {
+            PyErr_Format(PyExc_TypeError,
+                    "categorical columns must be integers; got %.100R", key);
+            goto error;
+        }
+        if (usecols != NULL) {
+            int i = 0;
+            for (; i < num_fields; i++) {
+                if (column == usecols[i]) {
+                    column = i;
+                    break;
+                }
+            }
+            if (i == num_fields) {
+                continue;  /* ignore unused column */
+            }
+        }
+        else {
+            if (column < -num_fields || column >= num_fields) {
+                PyErr_Format(PyExc_ValueError,
+                        "categorical column %zd is invalid for the number "
+                        "of fields %d.", column, num_fields);
+                goto error;
+            }
+            if (column < 0) {
+                column += num_fields;
+            }
+        }
+        if (conv_funcs[column] != NULL) {
+            PyErr_Format(PyExc_ValueError,
+                    "categorical column %R must not have a converter.", key);
+            goto error;
+        }
+        if (categories[column] != NULL) {
+            continue;  /* duplicated */
+        }
+        categories[column] = category_table_new(
+                key, field_types[homogeneous ? 0 : column].descr);
+        if (categories[column] == NULL) {
+            goto error;
+        }
+    }
+    Py_DECREF(seq);
+    return categories;
+
+  error:
+    Py_XDECREF(seq);
+    category_tables_free(categories, num_fields);
+    return NULL;
+}
+
+
+/*
+ * The number of rows to grow the result by when reading the whole file,
+ * increased depending on row size.  Note: later code grows assuming this is
+ * a power of two.
+ */
+static size_t
+rows_per_block_for_row_size(size_t row_size)
+{
+    if (row_size == 0) {
+        /* actual rows_per_block should not matter here */
+        return 512;
+    }
+    size_t rows_per_block = 1;
+    /* safe on overflow since min_rows will be 0 or 1 */
+    size_t min_rows = (MIN_BLOCK_SIZE + row_size - 1) / row_size;
+    while (rows_per_block < min_rows) {
+        rows_per_block *= 2;
+    }
+    return rows_per_block;
+}
+
+
+/*
+ * Column-major results
+ * --------------------
+ * With `pconfig->column_major`, the items of each field are stored
+ * contiguously: Field `i` starts at `allocated_rows * starts[i]`, where
+ * `starts[i]` is the sum of the item sizes of the fields before it.  For a
+ * homogeneous result this is exactly Fortran order.  `ptrs` point to the
+ * next item of each field.
+ */
+typedef struct {
+    int num_fields;
+    npy_intp *itemsizes;
+    npy_intp *starts;
+    char **ptrs;
+} column_layout;
+
+
+static void
+column_layout_free(column_layout *layout)
+{
+    if (layout == NULL) {
+        return;
+    }
+    PyMem_Free(layout->itemsizes);
+    PyMem_Free(layout->starts);
+    PyMem_Free(layout->ptrs);
+    PyMem_Free(layout);
+}
+
+
+static column_layout *
+column_layout_create(field_type *field_types, bool homogeneous,
+        int num_fields)
+{
+    column_layout *layout = PyMem_Calloc(1, sizeof(column_layout));
+    if (layout == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    size_t n = num_fields > 0 ? num_fields : 1;
+    layout->num_fields = num_fields;
+    layout->itemsizes = PyMem_Malloc(n * sizeof(npy_intp));
+    layout->starts = PyMem_Malloc(n * sizeof(npy_intp));
+    layout->ptrs = PyMem_Malloc(n * sizeof(char *));
+    if (layout->itemsizes == NULL || layout->starts == NULL
+            || layout->ptrs == NULL) {
+        column_layout_free(layout);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    npy_intp start = 0;
+    for (int i = 0; i < num_fields; i++) {
+        layout->itemsizes[i] = field_types[homogeneous ? 0 : i].descr->elsize;
+        layout->starts[i] = start;
+        start += layout->itemsizes[i];
+    }
+    return layout;
+}
+
+
+/* Point to row `row` of each field of `data` with `allocated_rows` rows */
+static void
+column_layout_set_row(column_layout *layout, char *data,
+        size_t allocated_rows, size_t row)
+{
+    for (int i = 0; i < layout->num_fields; i++) {
+        layout->ptrs[i] = data + allocated_rows * layout->starts[i]
+                + row * layout->itemsizes[i];
+    }
+}
+
+
+static NPY_INLINE void
+column_layout_next_row(column_layout *layout)
+{
+    for (int i = 0; i < layout->num_fields; i++) {
+        layout->ptrs[i] += layout->itemsizes[i];
+    }
+}
+
+
+/*
+ * Move the first `num_rows` items of each field of `data` from the layout
+ * for `old_rows` to the one for `new_rows` allocated rows.  When growing,
+ * `data` must already be large enough.
+ */
+static void
+column_layout_move(column_layout *layout, char *data,
+        size_t old_rows, size_t new_rows, size_t num_rows)
+{
+    /* The fields move towards the end when growing, so start at the end */
+    for (int k = 0; k < layout->num_fields; k++) {
+        int i = new_rows > old_rows ? layout->num_fields - 1 - k : k;
+        memmove(data + new_rows * layout->starts[i],
+                data + old_rows * layout->starts[i],
+                num_rows * layout->itemsizes[i]);
+    }
+}
+
+
+/*
+ * Create the data array for `num_rows` rows of `row_size` bytes.  Since
+ * it is only a container for the fields when not homogeneous, these may
+ * not include objects.
+ */
+static PyArrayObject *
+new_column_major_array(int ndim, npy_intp *shape, PyArray_Descr *descr)
+{
+    Py_INCREF(descr);
+    return (PyArrayObject *)PyArray_NewFromDescr(&PyArray_Type,
+            descr, ndim, shape, NULL, NULL, NPY_ARRAY_F_CONTIGUOUS, NULL);
+}
+
+
+/* Set the number of rows of the (column-major) array after moving data */
+static void
+set_column_major_rows(PyArrayObject *data_array, size_t num_rows)
+{
+    PyArrayObject_fields *fields = (PyArrayObject_fields *)data_array;
+    fields->dimensions[0] = num_rows;
+    if (PyArray_NDIM(data_array) == 2) {
+        fields->strides[1] = num_rows * PyArray_DESCR(data_array)->elsize;
+    }
+    PyArray_UpdateFlags(data_array,
+            NPY_ARRAY_C_CONTIGUOUS | NPY_ARRAY_F_CONTIGUOUS);
+}
+
+
+PyObject *
+column_major_fields(PyArrayObject *arr, int num_fields,
+        field_type *field_types)
+{
+    npy_intp num_rows = PyArray_DIM(arr, 0);
+    PyObject *res = PyTuple_New(num_fields);
+    if (res == NULL) {
+        return NULL;
+    }
+    char *data = PyArray_BYTES(arr);
+    for (int i = 0; i < num_fields; i++) {
+        PyArray_Descr *descr = field_types[i].descr;
+        Py_INCREF(descr);
+        PyObject *field = PyArray_NewFromDescr(&PyArray_Type,
+                descr, 1, &num_rows, NULL, data, NPY_ARRAY_CARRAY, NULL);
+        if (field == NULL) {
+            Py_DECREF(res);
+            return NULL;
+        }
+        Py_INCREF(arr);
+        if (PyArray_SetBaseObject(
+                (PyArrayObject *)field, (PyObject *)arr) < 0) {
+            Py_DECREF(field);
+            Py_DECREF(res);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(res, i, field);
+        data += num_rows * descr->elsize;
+    }
+    return res;
+}
+
+
+/*
+ * Batched converters
+ * ------------------
+ * With `pconfig->batch_converters`, the fields of the columns with a Python
+ * converter are collected for up to `CONVERTER_BATCH_ROWS` rows.  The
+ * converter is then called once with an array of the strings (`U`, or `S`
+ * holding latin1 for byte converters) and the result is cast into the
+ * column of the result.
+ */
+#define CONVERTER_BATCH_ROWS 4096
+
+typedef struct {
+    /* The characters of all fields and the end of each one */
+    Py_UCS4 *data;
+    size_t length;
+    size_t capacity;
+    size_t *ends;
+    size_t max_field_length;
+} converter_batch;
+
+
+static void
+converter_batches_free(converter_batch *batches, int num_fields)
+{
+    if (batches == NULL) {
+        return;
+    }
+    for (int i = 0; i < num_fields; i++) {
+        PyMem_Free(batches[i].data);
+        PyMem_Free(batches[i].ends);
+    }
+    PyMem_Free(batches);
+}
+
+
+/*
+ * Allocate the batches of the columns with converters (the other entries
+ * are unused).  Returns NULL with an error set on failure.
+ */
+static converter_batch *
+converter_batches_create(PyObject **conv_funcs, int num_fields)
+{
+    converter_batch *batches = PyMem_Calloc(
+            num_fields > 0 ? num_fields : 1, sizeof(converter_batch));
+    if (batches == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    for (int i = 0; i < num_fields; i++) {
+        if (conv_funcs[i] == NULL) {
+            continue;
+        }
+        batches[i].ends = PyMem_Malloc(CONVERTER_BATCH_ROWS * sizeof(size_t));
+        if (batches[i].ends == NULL) {
+            converter_batches_free(batches, num_fields);
+            PyErr_NoMemory();
+            return NULL;
+        }
+    }
+    return batches;
+}
+
+
+/*
+ * Append the field to the batch, returns -1 if out of memory (no error set,
+ * so that it is reported like a conversion error).
+ */
+static int
+converter_batch_append(converter_batch *batch, size_t row,
+        const Py_UCS4 *str, const Py_UCS4 *end)
+{
+    size_t length = end - str;
+    if (batch->data == NULL || batch->capacity - batch->length < length) {
+        size_t new_capacity = batch->capacity + batch->capacity / 4 + length;
+        if (new_capacity < 1024) {
+            new_capacity = 1024;
+        }
+        Py_UCS4 *new_data = PyMem_Realloc(
+                batch->data, new_capacity * sizeof(Py_UCS4));
+        if (new_data == NULL) {
+            return -1;
+        }
+        batch->data = new_data;
+        batch->capacity = new_capacity;
+    }
+    memcpy(batch->data + batch->length, str, length * sizeof(Py_UCS4));
+    batch->length += length;
+    batch->ends[row] = batch->length;
+    if (length > batch->max_field_length) {
+        batch->max_field_length = length;
+    }
+    return 0;
+}
+
+
+/*
+ * Create the array of the `num_rows` strings collected in the batch, which
+ * is then reset.
+ */
+static PyArrayObject *
+converter_batch_strings(converter_batch *batch, size_t num_rows, bool bytes)
+{
+    size_t length = batch->max_field_length > 0 ? batch->max_field_length : 1;
+    PyArray_Descr *descr = PyArray_DescrNewFromType(
+            bytes ? NPY_STRING : NPY_UNICODE);
+    if (descr == NULL) {
+        return NULL;
+    }
+    if (length > (size_t)(INT_MAX / 4)) {
+        Py_DECREF(descr);
+        PyErr_SetString(PyExc_ValueError,
+                "field too long for a batched converter.");
+        return NULL;
+    }
+    descr->elsize = (int)(bytes ? length : 4 * length);
+    npy_intp shape = (npy_intp)num_rows;
+    PyArrayObject *arr = (PyArrayObject *)PyArray_NewFromDescr(
+            &PyArray_Type, descr, 1, &shape, NULL, NULL, 0, NULL);
+    if (arr == NULL) {
+        return NULL;
+    }
+    memset(PyArray_BYTES(arr), 0, PyArray_NBYTES(arr));
+
+    size_t start = 0;
+    for (size_t row = 0; row < num_rows; row++) {
+        size_t end = batch->ends[row];
+        char *item = PyArray_BYTES(arr) + row * descr->elsize;
+        if (!bytes) {
+            memcpy(item, batch->data + start, (end - start) * sizeof(Py_UCS4));
+        }
+        for (size_t k = start; bytes && k < end; k++) {
+            if (batch->data[k] > 255) {
+                /* Set the same error as encoding the string would */
+                PyObject *str = PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND,
+                        batch->data + start, end - start);
+                if (str != NULL) {
+                    PyObject *encoded = PyUnicode_AsLatin1String(str);
+                    Py_XDECREF(encoded);
+                    Py_DECREF(str);
+                }
+                Py_DECREF(arr);
+                return NULL;
+            }
+            item[k - start] = (char)batch->data[k];
+        }
+        start = end;
+    }
+    batch->length = 0;
+    batch->max_field_length = 0;
+    return arr;
+}
+
+
+/*
+ * Call the converter `func` with the strings of the batch and store the
+ * result into the column starting at `item_ptr` (rows are `row_size` bytes
+ * apart).  Returns -1 with an error set on failure.
+ */
+static int
+call_batched_converter(PyObject *func, converter_batch *batch,
+        size_t num_rows, bool bytes, PyArray_Descr *descr, char *item_ptr,
+        size_t row_size)
+{
+    int res = -1;
+    PyObject *result = NULL;
+    PyArrayObject *values = NULL, *column = NULL;
+
+    PyArrayObject *strings = converter_batch_strings(batch, num_rows, bytes);
+    if (strings == NULL) {
+        return -1;
+    }
+    result = PyObject_CallFunctionObjArgs(func, (PyObject *)strings, NULL);
+    if (result == NULL) {
+        goto finish;
+    }
+    values = (PyArrayObject *)PyArray_FROM_O(result);
+    if (values == NULL) {
+        goto finish;
+    }
+    if (PyArray_NDIM(values) != 1
+            || PyArray_DIM(values, 0) != (npy_intp)num_rows) {
+        PyErr_Format(PyExc_ValueError,
+                "batched converter returned %zd values for %zu rows.",
+                PyArray_SIZE(values), num_rows);
+        goto finish;
+    }
+    /* A view of the column within the rows of the batch */
+    npy_intp shape = (npy_intp)num_rows;
+    npy_intp stride = (npy_intp)row_size;
+    Py_INCREF(descr);
+    column = (PyArrayObject *)PyArray_NewFromDescr(&PyArray_Type,
+            descr, 1, &shape, &stride, item_ptr, NPY_ARRAY_WRITEABLE, NULL);
+    if (column == NULL) {
+        goto finish;
+    }
+    res = PyArray_CopyInto(column, values);
+
+  finish:
+    Py_DECREF(strings);
+    Py_XDECREF(result);
+    Py_XDECREF(values);
+    Py_XDECREF(column);
+    return res;
+}
+
+
+/*
+ * Call the converters for the last `num_rows` rows of `data_array`, which
+ * start at row `first_row` of the file (for error messages).  `layout` is
+ * passed for column-major results and `stats` may be NULL.  Returns -1
+ * with an error set on failure.
+ */
+static int
+flush_converter_batches(converter_batch *batches, size_t num_rows,
+        PyObject **conv_funcs, int num_fields, int *usecols,
+        PyArrayObject *data_array, size_t row_count, size_t row_size,
+        column_layout *layout, field_type *field_types, bool homogeneous,
+        parser_config *pconfig, size_t first_row, read_stats *stats)
+{
+    if (num_rows == 0) {
+        return 0;
+    }
+    char *data_ptr = PyArray_BYTES(data_array)
+            + (row_count - num_rows) * row_size;
+    for (int i = 0; i < num_fields; i++) {
+        if (conv_funcs[i] == NULL) {
+            continue;
+        }
+        int f = homogeneous ? 0 : i;
+        PyArray_Descr *descr = field_types[f].descr;
+        char *item_ptr = data_ptr + (homogeneous ?
+                i * descr->elsize : field_types[f].structured_offset);
+        size_t item_stride = row_size;
+        if (layout != NULL) {
+            /* The rows of the batch end before the next item of the field */
+            item_stride = layout->itemsizes[i];
+            item_ptr = layout->ptrs[i] - num_rows * item_stride;
+        }
+        int64_t start = read_stats_start(stats);
+        int res = call_batched_converter(conv_funcs[i], &batches[i],
+                num_rows, pconfig->python_byte_converters, descr, item_ptr,
+                item_stride);
+        if (stats != NULL) {
+            READ_STATS_STOP(stats, python_converter_ns, start);
+            stats->python_converter_calls++;
+        }
+        if (res < 0) {
+            PyObject *exc, *val, *tb;
+            PyErr_Fetch(&exc, &val, &tb);
+            int col = usecols == NULL ? i : usecols[i];
+            PyErr_Format(PyExc_ValueError,
+                    "could not convert the strings of column %d at rows %zu "
+                    "to %zu to %S using the batched converter.",
+                    col < 0 ? col : col + 1, first_row,
+                    first_row + num_rows - 1, descr);
+            npy_PyErr_ChainExceptionsCause(exc, val, tb);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+/*
+ * Convert all fields of the row that was just tokenized into `data_ptr`.
+ * `conv_funcs` may be NULL if there are no Python converters, in which case
+ * this does not require the GIL unless some `field_types` need it.  If
+ * `batches` is passed, the fields with converters are added to row
+ * `batch_row` of their batch instead.  The fields of columns with a
+ * (non-NULL) entry in `categories` are stored as their category code.
+ * The fields with an entry in `strings` are appended to it (storing the
+ * offset).  If `missing` is passed, missing fields are filled (and recorded
+ * as part of `row`) instead of being converted, missing string fields are
+ * empty.  If `layout` is passed, the fields are stored at its `ptrs` instead of
+ * `data_ptr` (column-major result).
  *
- * @param s The stream object/struct providing reading capabilities used by
- *        the tokenizer.
- * @param max_rows The number of rows to read, or -1.  If negative
- *        all rows are read.
- * @param num_field_types The number of field types stored in `field_types`.
- * @param field_types Information about the dtype for each column (or one if
- *        `homogeneous`).
- * @param pconfig Pointer to the parser config object used by both the
- *        tokenizer and the conversion functions.
- * @param num_usecols The number of columns in `usecols`.
- * @param usecols An array of length `num_usecols` or NULL.  If given indicates
- *        which column is read for each individual row (negative columns are
- *        accepted).
- * @param skiplines The number of lines to skip, these lines are ignored.
- * @param converters Python dictionary of converters.  Finalizing converters
- *        is difficult without information about the number of columns.
- * @param data_array An array to be filled or NULL.  In either case a new
- *        reference is returned (the reference to `data_array` is not stolen).
- * @param out_descr The dtype used for allocating a new array.  This is not
- *        used if `data_array` is provided.  Note that the actual dtype of the
- *        returned array can differ for strings.
- * @param num_cols Pointer in which the actual (discovered) number of columns
- *        is returned.  This is only relevant if `homogeneous` is true.
- * @param homogeneous Whether the datatype of the array is not homogeneous,
- *        i.e. not structured.  In this case the number of columns has to be
- *        discovered an the returned array will be 2-dimensional rather than
- *        1-dimensional.
+ * Returns 0 on success.  On failure returns -1 and sets `*err_field` to the
+ * field that failed and `*err_col` to the column it was read from.  If the
+ * latter is -1, the `usecols` entry is not a valid column for this row.
+ */
+static NPY_INLINE int
+convert_row(tokenizer_state *ts, char *data_ptr, int actual_num_fields,
+        field_type *field_types, bool homogeneous, int *usecols,
+        PyObject **conv_funcs, converter_batch *batches, size_t batch_row,
+        category_table **categories, arrow_string_column **strings,
+        missing_state *missing, npy_intp row, column_layout *layout,
+        parser_config *pconfig, int *err_field, int *err_col)
+{
+    int current_num_fields = ts->num_fields;
+    field_info *fields = ts->fields;
+
+    for (int i = 0; i < actual_num_fields; ++i) {
+        int f;  /* The field, either 0 (if homogeneous) or i. */
+        int col;  /* The column as read, remapped by usecols */
+        char *item_ptr;
+        if (homogeneous) {
+            f = 0;
+            item_ptr = data_ptr + i * field_types[0].descr->elsize;
+        }
+        else {
+            f = i;
+            item_ptr = data_ptr + field_types[f].structured_offset;
+        }
+        if (layout != NULL) {
+            item_ptr = layout->ptrs[i];
+        }
+
+        if (usecols == NULL) {
+            col = i;
+        }
+        else {
+            col = usecols[i];
+            if (col < 0) {
+                // Python-like column indexing: k = -1 means the last column.
+                col += current_num_fields;
+            }
+            if (NPY_UNLIKELY((col < 0) || (col >= current_num_fields))) {
+                *err_field = i;
+                *err_col = -1;
+                return -1;
+            }
+        }
+
+        int res;
+        bool python_converter = conv_funcs != NULL && conv_funcs[i] != NULL;
+        bool categorical = categories != NULL && categories[i] != NULL;
+        bool string = strings != NULL && strings[i] != NULL;
+        if (missing != NULL && missing->fields[i] != NULL
+                && missing_field_matches(missing->fields[i], ts->row_kind,
+                        ts->row_data, fields[col].offset, fields[col].end)) {
+            if (string) {
+                res = arrow_string_append(strings[i], ts->row_kind,
+                        ts->row_data, 0, 0, item_ptr);
+                if (res == 0) {
+                    res = missing_state_record(missing, i, row);
+                }
+            }
+            else {
+                res = missing_field_fill(missing, i, row,
+                        &field_types[f], item_ptr, pconfig);
+            }
+        }
+        else if (string) {
+            res = arrow_string_append(strings[i], ts->row_kind,
+                    ts->row_data, fields[col].offset, fields[col].end,
+                    item_ptr);
+        }
+        else if (ts->row_kind == PyUnicode_1BYTE_KIND && !python_converter
+                && !categorical && field_types[f].set_from_ucs1 != NULL) {
+            const Py_UCS1 *data = (const Py_UCS1 *)ts->row_data;
+            res = field_types[f].set_from_ucs1(field_types[f].descr,
+                    data + fields[col].offset, data + fields[col].end,
+                    item_ptr, pconfig);
+        }
+        else if (ts->row_kind == PyUnicode_2BYTE_KIND && !python_converter
+                && !categorical && field_types[f].set_from_ucs2 != NULL) {
+            const Py_UCS2 *data = (const Py_UCS2 *)ts->row_data;
+            res = field_types[f].set_from_ucs2(field_types[f].descr,
+                    data + fields[col].offset, data + fields[col].end,
+                    item_ptr, pconfig);
+        }
+        else {
+            const Py_UCS4 *str, *end;
+            res = tokenizer_field_as_ucs4(ts, col, &str, &end);
+            if (res < 0) {
+                /* (no memory) reported as cause of the conversion error */
+            }
+            else if (categorical) {
+                res = category_table_store_code(categories[i],
+                        field_types[f].descr, str, end, item_ptr);
+            }
+            else if (!python_converter) {
+                res = field_types[f].set_from_ucs4(field_types[f].descr,
+                        str, end, item_ptr, pconfig);
+            }
+            else if (batches != NULL) {
+                res = converter_batch_append(
+                        &batches[i], batch_row, str, end);
+            }
+            else {
+                int64_t start = read_stats_start(ts->stats);
+                res = to_generic_with_converter(field_types[f].descr,
+                        str, end, item_ptr, pconfig, conv_funcs[i]);
+                if (ts->stats != NULL) {
+                    READ_STATS_STOP(ts->stats, python_converter_ns, start);
+                    ts->stats->python_converter_calls++;
+                }
+            }
+        }
+        if (NPY_UNLIKELY(res < 0)) {
+            *err_field = i;
+            *err_col = col;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+int
+rows_state_init(rows_state *rs, parser_config *pconfig, Py_ssize_t skiplines)
+{
+    rs->num_fields = -1;
+    rs->conv_funcs = NULL;
+    rs->categorical = NULL;
+    rs->categories = NULL;
+    rs->missing = NULL;
+    rs->record_missing = false;
+    rs->missing_state = NULL;
+    rs->strings = NULL;
+    rs->string_columns = NULL;
+    rs->skiplines = skiplines;
+    rs->row_count = 0;
+    rs->finished = false;
+    return tokenizer_init_from_arena(&rs->ts, pconfig);
+}
+
+
+void
+rows_state_clear(rows_state *rs)
+{
+    if (rs->conv_funcs != NULL) {
+        for (int i = 0; i < rs->num_fields; i++) {
+            Py_XDECREF(rs->conv_funcs[i]);
+        }
+        PyMem_FREE(rs->conv_funcs);
+        rs->conv_funcs = NULL;
+    }
+    category_tables_free(rs->categories, rs->num_fields);
+    rs->categories = NULL;
+    Py_CLEAR(rs->categorical);
+    missing_state_free(rs->missing_state);
+    rs->missing_state = NULL;
+    Py_CLEAR(rs->missing);
+    arrow_string_columns_free(rs->string_columns, rs->num_fields);
+    rs->string_columns = NULL;
+    Py_CLEAR(rs->strings);
+    tokenizer_clear_to_arena(&rs->ts);
+}
+
+
+/*
+ * Returns a new dictionary mapping the categorical columns (as passed in)
+ * to the array of their categories, empty if no row was read yet.
+ */
+PyObject *
+rows_state_categories(rows_state *rs)
+{
+    PyObject *res = PyDict_New();
+    if (res == NULL || rs->categories == NULL) {
+        return res;
+    }
+    for (int i = 0; i < rs->num_fields; i++) {
+        if (rs->categories[i] == NULL) {
+            continue;
+        }
+        PyArrayObject *uniques = category_table_uniques(rs->categories[i]);
+        if (uniques == NULL) {
+            Py_DECREF(res);
+            return NULL;
+        }
+        int r = PyDict_SetItem(
+                res, rs->categories[i]->key, (PyObject *)uniques);
+        Py_DECREF(uniques);
+        if (r < 0) {
+            Py_DECREF(res);
+            return NULL;
+        }
+    }
+    return res;
+}
+
+
+PyObject *
+rows_state_take_strings(rows_state *rs)
+{
+    PyObject *res = PyDict_New();
+    if (res == NULL || rs->string_columns == NULL) {
+        return res;
+    }
+    for (int i = 0; i < rs->num_fields; i++) {
+        if (rs->string_columns[i] == NULL) {
+            continue;
+        }
+        PyObject *data = arrow_string_column_take(rs->string_columns[i]);
+        if (data == NULL) {
+            Py_DECREF(res);
+            return NULL;
+        }
+        PyObject *key = PyLong_FromLong(i);
+        int r = key == NULL ? -1 : PyDict_SetItem(res, key, data);
+        Py_XDECREF(key);
+        Py_DECREF(data);
+        if (r < 0) {
+            Py_DECREF(res);
+            return NULL;
+        }
+    }
+    return res;
+}
+
+
+/*
+ * The number of fields the tokenizer needs to find in each row for
+ * `usecols`, or SIZE_MAX if all are needed (i.e. for negative indices).
+ */
+static size_t
+max_fields_needed(int num_usecols, int *usecols)
+{
+    if (usecols == NULL || num_usecols == 0) {
+        return SIZE_MAX;
+    }
+    size_t max_fields = 0;
+    for (int i = 0; i < num_usecols; i++) {
+        if (usecols[i] < 0) {
+            return SIZE_MAX;
+        }
+        if ((size_t)usecols[i] >= max_fields) {
+            max_fields = (size_t)usecols[i] + 1;
+        }
+    }
+    return max_fields;
+}
+
+
+/*
+ * Whether the rows can be converted without using the Python API.
+ */
+static bool
+has_native_conversion(
+        int num_field_types, field_type *field_types, PyObject *converters)
+{
+    if (converters != Py_None &&
+            !(PyDict_Check(converters) && PyDict_Size(converters) == 0)) {
+        return false;
+    }
+    for (int i = 0; i < num_field_types; i++) {
+        if (field_types[i].needs_pyapi) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*
+ * The specialized loop converting whole rows if one can be used (it needs
+ * native conversion, see above), otherwise NULL to use `convert_row`.
+ */
+static row_loop_function *
+select_row_loop(field_type *field_types, bool homogeneous, int *usecols)
+{
+    if (!homogeneous || usecols != NULL) {
+        return NULL;
+    }
+    return get_row_loop(&field_types[0]);
+}
+
+
+/*
+ * Whether the result is an unsized string ("S0" or "U0"), in which case the
+ * string length is discovered while reading: The result is widened whenever
+ * a longer field is found.
+ */
+static bool
+discovers_string_length(PyArray_Descr *out_descr, bool homogeneous)
+{
+    return (homogeneous && out_descr->elsize == 0
+            && PyDataType_ISSTRING(out_descr));
+}
+
+
+/*
+ * A new (unaligned) string descriptor like `descr` for strings of `length`
+ * characters.  Like NumPy, we use a length of at least one.
+ */
+static PyArray_Descr *
+string_descr_with_length(PyArray_Descr *descr, size_t length)
+{
+    size_t char_size = descr->type_num == NPY_UNICODE ? 4 : 1;
+    if (length == 0) {
+        length = 1;
+    }
+    if (length > INT_MAX / char_size) {
+        PyErr_SetString(PyExc_ValueError,
+                "a field is too long to be stored as a NumPy string");
+        return NULL;
+    }
+    PyArray_Descr *res = PyArray_DescrNew(descr);
+    if (res == NULL) {
+        return NULL;
+    }
+    res->elsize = (int)(length * char_size);
+    return res;
+}
+
+
+/*
+ * The length of the longest field used for the result in the row that was
+ * just tokenized.  Invalid `usecols` are ignored here (they are reported
+ * when converting).
+ */
+static size_t
+row_max_field_length(tokenizer_state *ts, int num_fields, int *usecols)
+{
+    size_t max_length = 0;
+    for (int i = 0; i < num_fields; i++) {
+        Py_ssize_t col = usecols == NULL ? i : usecols[i];
+        if (col < 0) {
+            col += ts->num_fields;
+        }
+        if (col < 0 || col >= (Py_ssize_t)ts->num_fields) {
+            continue;
+        }
+        size_t length = ts->fields[col].end - ts->fields[col].offset;
+        if (length > max_length) {
+            max_length = length;
+        }
+    }
+    return max_length;
+}
+
+
+/*
+ * Copy the first `num_items` strings of `arr` into a new array with the
+ * string descriptor `descr` (stolen) and `num_rows` rows.  Strings are
+ * padded with zeros (or truncated if they are known not to be longer).
+ */
+static PyArrayObject *
+copy_with_string_length(
+        PyArrayObject *arr, PyArray_Descr *descr, npy_intp num_rows,
+        npy_intp num_items)
+{
+    npy_intp shape[2] = {num_rows, PyArray_DIM(arr, 1)};
+    PyArrayObject *res = (PyArrayObject *)PyArray_SimpleNewFromDescr(
+            2, shape, descr);
+    if (res == NULL) {
+        return NULL;
+    }
+    size_t old_size = PyArray_ITEMSIZE(arr);
+    size_t new_size = PyArray_ITEMSIZE(res);
+    size_t copy_size = old_size < new_size ? old_size : new_size;
+    const char *src = PyArray_BYTES(arr);
+    char *dst = PyArray_BYTES(res);
+    for (npy_intp i = 0; i < num_items; i++) {
+        memcpy(dst, src, copy_size);
+        memset(dst + copy_size, '\0', new_size - copy_size);
+        src += old_size;
+        dst += new_size;
+    }
+    return res;
+}
+
+
+/**
+ * Read (up to `max_rows`) rows continuing with the state stored in `rs`,
+ * see `read_rows` for the other parameters.  This function may be called
+ * repeatedly with the same stream, state and parameters to read a stream
+ * in batches.  If the stream provides the raw data, the GIL is released
+ * while reading unless Python converters are used.
  *
- * @returns Returns the result as an array object or NULL on error.  The result
- *          is always a new reference (even when `data_array` was passed in).
+ * If `data_array` is passed, `rs->row_count` can be used to find the
+ * number of rows which were actually filled in.
  */
 PyArrayObject *
-read_rows(stream *s,
+read_rows_batch(stream *s, rows_state *rs,
         npy_intp max_rows, int num_field_types, field_type *field_types,
         parser_config *pconfig, int num_usecols, int *usecols,
-        Py_ssize_t skiplines, PyObject *converters,
+        PyObject *converters,
         PyArrayObject *data_array, PyArray_Descr *out_descr,
         bool homogeneous)
 {
     char *data_ptr = NULL;
     int current_num_fields;
+
+    bool discover_length = discovers_string_length(out_descr, homogeneous);
+    /* The longest string so far and the length the result can store */
+    size_t string_length = 0, string_capacity = 0;
+    PyArray_Descr *string_descr = NULL;
+    field_type string_ft;
+    if (discover_length) {
+        /* Fields are converted using the current (sized) string dtype */
+        string_ft = field_types[0];
+        field_types = &string_ft;
+        if (data_array != NULL) {
+            /* Strings are truncated to the length of the array we fill */
+            out_descr = PyArray_DESCR(data_array);
+            string_ft.descr = out_descr;
+            discover_length = false;
+        }
+    }
+
     size_t row_size = out_descr->elsize;
-    PyObject **conv_funcs = NULL;
+    tokenizer_state *ts = &rs->ts;
+    ts->max_fields = max_fields_needed(num_usecols, usecols);
+    read_stats *stats = ts->stats;
+    int64_t start_time;
+
+    char *start, *end;
+    bool raw_data = stream_rawdata(s, &start, &end);
+    bool native_conversion = has_native_conversion(
+            num_field_types, field_types, converters);
+    /* If neither the stream nor the conversion need the GIL, release it */
+    bool release_gil = raw_data && native_conversion;
+    row_loop_function *row_loop = NULL;
+    if (native_conversion && rs->categorical == NULL && rs->missing == NULL
+            && rs->strings == NULL) {
+        row_loop = select_row_loop(field_types, homogeneous, usecols);
+    }
+
+    npy_intp num_rows_hint = -1;
+    if (raw_data && max_rows < 0 && data_array == NULL) {
+        /*
+         * Count the rows first, so that the result is allocated only once.
+         * Growing it requires copying and at worst twice the final memory.
+         * Only done if quoted fields cannot contain newlines: then it is a
+         * fast scan for line ends, while following the quoting would cost
+         * about as much as tokenizing (so the result is grown instead).
+         */
+        const char *count_start = start;
+        if (ts->pos != NULL && ts->end == start) {
+            /*
+             * Include the rows of the stream buffer the tokenizer is still
+             * reading (of an earlier batch), it directly precedes the data.
+             */
+            count_start = ts->pos;
+        }
+        Py_BEGIN_ALLOW_THREADS;
+        start_time = read_stats_start(stats);
+        if (!raw_rows_may_span_lines(count_start, end, pconfig)) {
+            Py_ssize_t num_skip = rs->skiplines;
+            const char *pos = raw_skip_lines(count_start, end, &num_skip);
+            num_rows_hint = raw_count_rows(pos, end, pconfig, false);
+        }
+        READ_STATS_STOP(stats, count_rows_ns, start_time);
+        Py_END_ALLOW_THREADS;
+    }
 
     bool needs_init = PyDataType_FLAGCHK(out_descr, NPY_NEEDS_INIT);
+    NPY_BEGIN_THREADS_DEF;
 
     int ndim = homogeneous ? 2 : 1;
     npy_intp result_shape[2] = {0, 1};
 
     bool data_array_allocated = data_array == NULL;
+    /* The rows whose converted fields are still in the batches */
+    converter_batch *batches = NULL;
+    size_t batch_rows = 0;
+    /* Only a new result without objects is stored column by column */
+    bool column_major = (pconfig->column_major && data_array == NULL
+            && !discover_length && !needs_init);
+    column_layout *layout = NULL;
     /* Make sure we own `data_array` for the purpose of error handling */
     Py_XINCREF(data_array);
     size_t rows_per_block = 1;  /* will be increased depending on row size */
     Py_ssize_t data_allocated_rows = 0;
 
-    int ts_result = 0;
-    tokenizer_state ts;
-    if (tokenizer_init(&ts, pconfig) < 0) {
-        goto error;
-    }
+    int ts_result = rs->finished ? 1 : 0;
 
     /* Set the actual number of fields if it is already known, otherwise -1 */
-    int actual_num_fields = -1;
+    int actual_num_fields = rs->num_fields;
     if (usecols != NULL) {
         actual_num_fields = num_usecols;
     }
@@ -187,27 +1157,32 @@ read_rows(stream *s,
         actual_num_fields = num_field_types;
     }
 
-    for (; skiplines > 0; skiplines--) {
-        ts.state = TOKENIZE_GOTO_LINE_END;
-        ts_result = tokenize(s, &ts, pconfig);
+    if (release_gil) {
+        NPY_BEGIN_THREADS;
+    }
+
+    if (rs->skiplines > 0 && ts_result == 0) {
+        ts_result = tokenizer_skip_lines(s, ts, &rs->skiplines);
         if (ts_result < 0) {
             goto error;
         }
-        else if (ts_result != 0) {
-            /* Fewer lines than skiplines is acceptable */
-            break;
-        }
     }
+    /* Fewer lines than skiplines is acceptable */
+    rs->skiplines = 0;
 
     Py_ssize_t row_count = 0;  /* number of rows actually processed */
+    if (rs->missing_state != NULL) {
+        /* The missing fields are recorded per batch */
+        rs->missing_state->num_positions = 0;
+    }
     while ((max_rows < 0 || row_count < max_rows) && ts_result == 0) {
-        ts_result = tokenize(s, &ts, pconfig);
+        ts_result = tokenize(s, ts, pconfig);
         if (ts_result < 0) {
             goto error;
         }
-        current_num_fields = ts.num_fields;
-        field_info *fields = ts.fields;
-        if (ts.num_fields == 0) {
+        current_num_fields = ts->num_fields;
+        field_info *fields = ts->fields;
+        if (ts->num_fields == 0) {
             continue;  /* Ignore empty line */
         }
 
@@ -215,21 +1190,82 @@ read_rows(stream *s,
             // We've deferred some of the initialization tasks to here,
             // because we've now read the first line, and we definitively
             // know how many fields (i.e. columns) we will be processing.
+            NPY_END_THREADS;
             if (actual_num_fields == -1) {
                 actual_num_fields = current_num_fields;
             }
 
-            conv_funcs = create_conv_funcs(
-                    converters, actual_num_fields, usecols);
-            if (conv_funcs == NULL) {
-                goto error;
+            if (rs->conv_funcs == NULL) {
+                rs->conv_funcs = create_conv_funcs(
+                        converters, actual_num_fields, usecols);
+                if (rs->conv_funcs == NULL) {
+                    goto error;
+                }
+                rs->num_fields = actual_num_fields;
+            }
+            if (rs->categorical != NULL && rs->categories == NULL) {
+                rs->categories = create_category_tables(
+                        rs->categorical, actual_num_fields, usecols,
+                        field_types, homogeneous, rs->conv_funcs);
+                if (rs->categories == NULL) {
+                    goto error;
+                }
+            }
+            if (rs->strings != NULL && rs->string_columns == NULL) {
+                rs->string_columns = arrow_string_columns_create(
+                        rs->strings, actual_num_fields, field_types,
+                        homogeneous, rs->conv_funcs);
+                if (rs->string_columns == NULL) {
+                    goto error;
+                }
+            }
+            if (rs->missing != NULL && rs->missing_state == NULL) {
+                rs->missing_state = missing_state_create(
+                        rs->missing, actual_num_fields, usecols,
+                        field_types, homogeneous, rs->record_missing);
+                if (rs->missing_state == NULL) {
+                    goto error;
+                }
+            }
+            if (pconfig->batch_converters && !discover_length) {
+                batches = converter_batches_create(
+                        rs->conv_funcs, actual_num_fields);
+                if (batches == NULL) {
+                    goto error;
+                }
             }
 
             /* Note that result_shape[1] is only used if homogeneous is true */
             result_shape[1] = actual_num_fields;
+            if (discover_length) {
+                string_length = row_max_field_length(
+                        ts, actual_num_fields, usecols);
+                /* Make sure that string fill values are never truncated */
+                size_t fill_length = missing_state_fill_length(
+                        rs->missing_state);
+                if (fill_length > string_length) {
+                    string_length = fill_length;
+                }
+                string_capacity = string_length > 0 ? string_length : 1;
+                string_descr = string_descr_with_length(
+                        out_descr, string_capacity);
+                if (string_descr == NULL) {
+                    goto error;
+                }
+                out_descr = string_descr;
+                string_ft.descr = string_descr;
+                row_size = out_descr->elsize;
+            }
             if (homogeneous) {
                 row_size *= actual_num_fields;
             }
+            if (column_major) {
+                layout = column_layout_create(
+                        field_types, homogeneous, actual_num_fields);
+                if (layout == NULL) {
+                    goto error;
+                }
+            }
 
             if (data_array == NULL) {
                 if (max_rows < 0) {
@@ -237,33 +1273,32 @@ read_rows(stream *s,
                      * Negative max_rows denotes to read the whole file, we
                      * approach this by allocating ever larger blocks.
                      * Adds a number of rows based on `MIN_BLOCK_SIZE`.
-                     * Note: later code grows assuming this is a power of two.
+                     * If we know (an upper bound of) the number of rows,
+                     * the array should never need to grow.
                      */
-                    if (row_size == 0) {
-                        /* actual rows_per_block should not matter here */
-                        rows_per_block = 512;
-                    }
-                    else {
-                        /* safe on overflow since min_rows will be 0 or 1 */
-                        size_t min_rows = (
-                                (MIN_BLOCK_SIZE + row_size - 1) / row_size);
-                        while (rows_per_block < min_rows) {
-                            rows_per_block *= 2;
-                        }
-                    }
+                    rows_per_block = rows_per_block_for_row_size(row_size);
                     data_allocated_rows = rows_per_block;
+                    if (num_rows_hint > 0) {
+                        data_allocated_rows = num_rows_hint;
+                    }
                 }
                 else {
                     data_allocated_rows = max_rows;
                 }
                 result_shape[0] = data_allocated_rows;
-                Py_INCREF(out_descr);
-                /*
-                 * We do not use Empty, as it would fill with None
-                 * and requiring decref'ing if we shrink again.
-                 */
-                data_array = (PyArrayObject *)PyArray_SimpleNewFromDescr(
-                        ndim, result_shape, out_descr);
+                if (column_major) {
+                    data_array = new_column_major_array(
+                            ndim, result_shape, out_descr);
+                }
+                else {
+                    Py_INCREF(out_descr);
+                    /*
+                     * We do not use Empty, as it would fill with None
+                     * and requiring decref'ing if we shrink again.
+                     */
+                    data_array = (PyArrayObject *)PyArray_SimpleNewFromDescr(
+                            ndim, result_shape, out_descr);
+                }
                 if (data_array == NULL) {
                     goto error;
                 }
@@ -273,24 +1308,88 @@ read_rows(stream *s,
             }
             else {
                 assert(max_rows >=0);
+                if (homogeneous && PyArray_NDIM(data_array) == 2 &&
+                        PyArray_DIM(data_array, 1) != actual_num_fields) {
+                    PyErr_Format(PyExc_ValueError,
+                            "the output array has %zd columns but the rows "
+                            "have %d.", PyArray_DIM(data_array, 1),
+                            actual_num_fields);
+                    goto error;
+                }
                 data_allocated_rows = max_rows;
             }
             data_ptr = PyArray_BYTES(data_array);
+            if (layout != NULL) {
+                column_layout_set_row(layout, data_ptr, data_allocated_rows, 0);
+            }
+            if (release_gil) {
+                NPY_BEGIN_THREADS;
+            }
         }
 
         if (!usecols && (actual_num_fields != current_num_fields)) {
+            NPY_END_THREADS;
             PyErr_Format(PyExc_ValueError,
                     "the number of columns changed from %d to %d at row %zu; "
                     "use `usecols` to select a subset and avoid this error",
-                    actual_num_fields, current_num_fields, row_count+1);
+                    actual_num_fields, current_num_fields,
+                    rs->row_count + row_count + 1);
             goto error;
         }
 
+        if (discover_length) {
+            size_t length = row_max_field_length(
+                    ts, actual_num_fields, usecols);
+            if (length > string_length) {
+                string_length = length;
+            }
+            if (NPY_UNLIKELY(string_length > string_capacity)) {
+                /*
+                 * Widen the strings by at least ~25% to limit the number of
+                 * times the rows we already have need to be copied.
+                 */
+                NPY_END_THREADS;
+                size_t new_capacity = string_capacity + string_capacity / 4;
+                if (new_capacity < string_length) {
+                    new_capacity = string_length;
+                }
+                PyArray_Descr *new_descr = string_descr_with_length(
+                        out_descr, new_capacity);
+                if (new_descr == NULL) {
+                    goto error;
+                }
+                Py_SETREF(string_descr, new_descr);
+                Py_INCREF(string_descr);
+                start_time = read_stats_start(stats);
+                PyArrayObject *new_array = copy_with_string_length(
+                        data_array, string_descr, data_allocated_rows,
+                        row_count * actual_num_fields);
+                if (new_array == NULL) {
+                    goto error;
+                }
+                if (stats != NULL) {
+                    READ_STATS_STOP(stats, grow_ns, start_time);
+                    stats->output_reallocs++;
+                    stats->output_bytes_copied += row_count * row_size;
+                }
+                Py_SETREF(data_array, new_array);
+                out_descr = string_descr;
+                string_ft.descr = string_descr;
+                string_capacity = new_capacity;
+                row_size = out_descr->elsize * actual_num_fields;
+                data_ptr = PyArray_BYTES(data_array) + row_count * row_size;
+                if (release_gil) {
+                    NPY_BEGIN_THREADS;
+                }
+            }
+        }
+
         if (NPY_UNLIKELY(data_allocated_rows == row_count)) {
             /*
              * Grow by ~25% and rounded up to the next rows_per_block
              * NOTE: This is based on very crude timings and could be refined!
              */
+            NPY_END_THREADS;
             size_t new_rows = data_allocated_rows;
             npy_intp alloc_size = grow_size_and_multiply(
                     &new_rows, rows_per_block, row_size);
@@ -302,6 +1401,7 @@ read_rows(stream *s,
                 goto error;
             }
 
+            start_time = read_stats_start(stats);
             char *new_data = PyDataMem_RENEW(
                     PyArray_BYTES(data_array), alloc_size ? alloc_size : 1);
             if (new_data == NULL) {
@@ -312,86 +1412,134 @@ read_rows(stream *s,
             ((PyArrayObject_fields *)data_array)->data = new_data;
             ((PyArrayObject_fields *)data_array)->dimensions[0] = new_rows;
             data_ptr = new_data + row_count * row_size;
+            if (layout != NULL) {
+                column_layout_move(layout, new_data,
+                        data_allocated_rows, new_rows, row_count);
+                column_layout_set_row(layout, new_data, new_rows, row_count);
+                set_column_major_rows(data_array, new_rows);
+            }
             data_allocated_rows = new_rows;
             if (needs_init) {
                 memset(data_ptr, '\0', (new_rows - row_count) * row_size);
             }
-        }
-
-        for (int i = 0; i < actual_num_fields; ++i) {
-            int f;  /* The field, either 0 (if homogeneous) or i. */
-            int col;  /* The column as read, remapped by usecols */
-            char *item_ptr;
-            if (homogeneous) {
-                f = 0;
-                item_ptr = data_ptr + i * field_types[0].descr->elsize;
-            }
-            else {
-                f = i;
-                item_ptr = data_ptr + field_types[f].structured_offset;
+            if (stats != NULL) {
+                READ_STATS_STOP(stats, grow_ns, start_time);
+                stats->output_reallocs++;
+                stats->output_bytes_copied += row_count * row_size;
             }
-
-            if (usecols == NULL) {
-                col = i;
-            }
-            else {
-                col = usecols[i];
-                if (col < 0) {
-                    // Python-like column indexing: k = -1 means the last column.
-                    col += current_num_fields;
-                }
-                if (NPY_UNLIKELY((col < 0) || (col >= current_num_fields))) {
-                    PyErr_Format(PyExc_ValueError,
-                            "invalid column index %d at row %zu with %d "
-                            "columns",
-                            usecols[i], current_num_fields, row_count+1);
-                    goto error;
-                }
+            if (release_gil) {
+                NPY_BEGIN_THREADS;
             }
+        }
 
-            bool err = 0;
-            Py_UCS4 *str = ts.field_buffer + fields[col].offset;
-            Py_UCS4 *end = ts.field_buffer + fields[col + 1].offset - 1;
-            if (conv_funcs[i] == NULL) {
-                if (field_types[f].set_from_ucs4(field_types[f].descr,
-                        str, end, item_ptr, pconfig) < 0) {
-                    err = true;
-                }
-            }
-            else {
-                if (to_generic_with_converter(field_types[f].descr,
-                        str, end, item_ptr, pconfig, conv_funcs[i]) < 0) {
-                    err = true;
-                }
+        int res, err_field, err_col;
+        start_time = read_stats_start(stats);
+        if (row_loop != NULL && layout != NULL) {
+            /* Fortran order, the columns are `data_allocated_rows` apart */
+            res = row_loop(ts, layout->ptrs[0],
+                    data_allocated_rows * layout->itemsizes[0],
+                    actual_num_fields, field_types[0].descr, pconfig,
+                    &err_col);
+            err_field = err_col;
+        }
+        else if (row_loop != NULL) {
+            res = row_loop(ts, data_ptr, field_types[0].descr->elsize,
+                    actual_num_fields, field_types[0].descr, pconfig,
+                    &err_col);
+            err_field = err_col;
+        }
+        else {
+            res = convert_row(ts, data_ptr, actual_num_fields,
+                    field_types, homogeneous, usecols, rs->conv_funcs,
+                    batches, batch_rows, rs->categories, rs->string_columns,
+                    rs->missing_state, row_count, layout, pconfig, &err_field, &err_col);
+        }
+        READ_STATS_STOP(stats, convert_ns, start_time);
+        if (NPY_UNLIKELY(res < 0)) {
+            NPY_END_THREADS;
+            if (err_col < 0) {
+                PyErr_Format(PyExc_ValueError,
+                        "invalid column index %d at row %zu with %d "
+                        "columns",
+                        usecols[err_field], current_num_fields,
+                        rs->row_count + row_count + 1);
+                goto error;
             }
+            int f = homogeneous ? 0 : err_field;
+            PyObject *exc, *val, *tb;
+            PyErr_Fetch(&exc, &val, &tb);
 
-            if (NPY_UNLIKELY(err)) {
-                PyObject *exc, *val, *tb;
-                PyErr_Fetch(&exc, &val, &tb);
-
-                size_t length = end - str;
-                PyObject *string = PyUnicode_FromKindAndData(
-                        PyUnicode_4BYTE_KIND, str, length);
-                if (string == NULL) {
-                    npy_PyErr_ChainExceptions(exc, val, tb);
-                    goto error;
-                }
-                PyErr_Format(PyExc_ValueError,
-                        "could not convert string %.100R to %S at "
-                        "row %zu, column %d.",
-                        string, field_types[f].descr, row_count, col+1);
-                Py_DECREF(string);
-                npy_PyErr_ChainExceptionsCause(exc, val, tb);
+            const char *str = ts->row_data + fields[err_col].offset * ts->row_kind;
+            size_t length = fields[err_col].end - fields[err_col].offset;
+            PyObject *string = PyUnicode_FromKindAndData(
+                    ts->row_kind, str, length);
+            if (string == NULL) {
+                npy_PyErr_ChainExceptions(exc, val, tb);
                 goto error;
             }
+            PyErr_Format(PyExc_ValueError,
+                    "could not convert string %.100R to %S at "
+                    "row %zu, column %d.",
+                    string, field_types[f].descr, rs->row_count + row_count,
+                    err_col+1);
+            Py_DECREF(string);
+            npy_PyErr_ChainExceptionsCause(exc, val, tb);
+            goto error;
         }
 
         ++row_count;
         data_ptr += row_size;
+        if (layout != NULL) {
+            column_layout_next_row(layout);
+        }
+        if (batches != NULL && ++batch_rows == CONVERTER_BATCH_ROWS) {
+            if (flush_converter_batches(batches, batch_rows, rs->conv_funcs,
+                    actual_num_fields, usecols, data_array, row_count,
+                    row_size, layout, field_types, homogeneous, pconfig,
+                    rs->row_count + row_count - batch_rows, stats) < 0) {
+                goto error;
+            }
+            batch_rows = 0;
+        }
     }
+    NPY_END_THREADS;
 
-    tokenizer_clear(&ts);
-    PyMem_FREE(conv_funcs);
+    if (batches != NULL) {
+        if (flush_converter_batches(batches, batch_rows, rs->conv_funcs,
+                actual_num_fields, usecols, data_array, row_count,
+                row_size, layout, field_types, homogeneous, pconfig,
+                rs->row_count + row_count - batch_rows, stats) < 0) {
+            goto error;
+        }
+        converter_batches_free(batches, actual_num_fields);
+        batches = NULL;
+    }
+
+    if (discover_length && string_length < string_capacity &&
+            string_length > 0) {
+        /* The strings were widened too much, copy into the exact length */
+        PyArray_Descr *descr = string_descr_with_length(
+                out_descr, string_length);
+        if (descr == NULL) {
+            goto error;
+        }
+        start_time = read_stats_start(stats);
+        PyArrayObject *new_array = copy_with_string_length(
+                data_array, descr, row_count, row_count * actual_num_fields);
+        if (new_array == NULL) {
+            goto error;
+        }
+        if (stats != NULL) {
+            READ_STATS_STOP(stats, grow_ns, start_time);
+            stats->output_reallocs++;
+            stats->output_bytes_copied += row_count * row_size;
+        }
+        Py_SETREF(data_array, new_array);
+        data_allocated_rows = row_count;
+    }
+
+    rs->row_count += row_count;
+    rs->finished = ts_result != 0;
 
     if (data_array == NULL) {
         assert(row_count == 0 && result_shape[0] == 0);
@@ -407,9 +1555,16 @@ read_rows(stream *s,
         else {
             result_shape[1] = actual_num_fields;
         }
+        if (discover_length) {
+            string_descr = string_descr_with_length(out_descr, 0);
+            if (string_descr == NULL) {
+                return NULL;
+            }
+            out_descr = string_descr;
+        }
         Py_INCREF(out_descr);
         data_array = (PyArrayObject *)PyArray_Empty(
-                ndim, result_shape, out_descr, 0);
+                ndim, result_shape, out_descr, column_major);
     }
 
     /*
@@ -418,22 +1573,633 @@ read_rows(stream *s,
      */
     if (data_array_allocated && data_allocated_rows != row_count) {
         size_t size = row_count * row_size;
+        start_time = read_stats_start(stats);
+        if (layout != NULL) {
+            column_layout_move(layout, PyArray_BYTES(data_array),
+                    data_allocated_rows, row_count, row_count);
+        }
         char *new_data = PyDataMem_RENEW(
                 PyArray_BYTES(data_array), size ? size : 1);
         if (new_data == NULL) {
             Py_DECREF(data_array);
+            Py_XDECREF(string_descr);
+            column_layout_free(layout);
             PyErr_NoMemory();
             return NULL;
         }
         ((PyArrayObject_fields *)data_array)->data = new_data;
         ((PyArrayObject_fields *)data_array)->dimensions[0] = row_count;
+        if (layout != NULL) {
+            set_column_major_rows(data_array, row_count);
+        }
+        if (stats != NULL) {
+            READ_STATS_STOP(stats, grow_ns, start_time);
+            stats->output_reallocs++;
+            stats->output_bytes_copied += size;
+        }
     }
 
+    column_layout_free(layout);
+    Py_XDECREF(string_descr);
     return data_array;
 
   error:
-    PyMem_FREE(conv_funcs);
-    tokenizer_clear(&ts);
+    NPY_END_THREADS;
+    converter_batches_free(batches, actual_num_fields);
+    column_layout_free(layout);
     Py_XDECREF(data_array);
+    Py_XDECREF(string_descr);
     return NULL;
 }
+
+
+/*
+ * Parallel reading
+ * ----------------
+ * The (remaining) data is split into chunks at row boundaries, each chunk
+ * is tokenized and converted on its own thread into a block of memory.  The
+ * blocks are then copied into the result array (also in parallel).
+ * If anything fails in any chunk, the data is read again serially, which
+ * ensures that errors (and error messages) are identical to serial reading.
+ */
+
+/* Minimum number of bytes per chunk (smaller files are not split). */
+#define MIN_PARALLEL_CHUNK_SIZE (1 << 20)
+
+typedef struct {
+    /* The chunk of data to parse */
+    const char *start;
+    const char *end;
+    /* Shared (read-only) information about how to parse and convert */
+    parser_config *pconfig;
+    field_type *field_types;
+    bool homogeneous;
+    bool needs_init;
+    int *usecols;
+    row_loop_function *row_loop;
+    /* Input: number of fields if known or -1.  Output: discovered value. */
+    int num_fields;
+    /* Input: the row size, or the itemsize if `num_fields` is -1. */
+    size_t row_size;
+    /* Results */
+    char *block;
+    npy_intp num_rows;
+    bool failed;
+    /* Where to copy the block into the final result */
+    char *result_ptr;
+    /* The statistics of this chunk (if requested) */
+    bool collect_stats;
+    read_stats stats;
+} parallel_chunk;
+
+
+/*
+ * Tokenize and convert the rows of `chunk` with `ts`, which is reset first
+ * so that a thread can parse many chunks with one tokenizer.  Called
+ * without the GIL, failures only set `chunk->failed`.
+ */
+static void
+parse_chunk_rows(parallel_chunk *chunk, tokenizer_state *ts)
+{
+    int actual_num_fields = chunk->num_fields;
+    size_t row_size = chunk->row_size;
+    npy_intp allocated_rows = 0;
+    size_t rows_per_block = 1;
+    char *data_ptr = NULL;
+
+    stream *s = stream_memory(chunk->start, chunk->end);
+    if (s == NULL) {
+        goto fail;
+    }
+    tokenizer_reset(ts);
+    ts->max_fields = max_fields_needed(chunk->num_fields, chunk->usecols);
+    read_stats *stats = chunk->collect_stats ? &chunk->stats : NULL;
+    ts->stats = stats;
+    int64_t start_time;
+
+    int ts_result = 0;
+    while (ts_result == 0) {
+        ts_result = tokenize(s, ts, chunk->pconfig);
+        if (ts_result < 0) {
+            goto fail;
+        }
+        if (ts->num_fields == 0) {
+            continue;  /* Ignore empty line */
+        }
+
+        if (NPY_UNLIKELY(actual_num_fields == -1)) {
+            actual_num_fields = ts->num_fields;
+            row_size *= actual_num_fields;  /* only -1 if homogeneous */
+        }
+        if (chunk->usecols == NULL && actual_num_fields != ts->num_fields) {
+            goto fail;
+        }
+
+        if (NPY_UNLIKELY(allocated_rows == chunk->num_rows)) {
+            if (allocated_rows == 0) {
+                rows_per_block = rows_per_block_for_row_size(row_size);
+            }
+            size_t new_rows = allocated_rows;
+            npy_intp alloc_size = grow_size_and_multiply(
+                    &new_rows, rows_per_block, row_size);
+            if (alloc_size < 0) {
+                goto fail;
+            }
+            start_time = read_stats_start(stats);
+            char *new_block = PyMem_RawRealloc(
+                    chunk->block, alloc_size ? alloc_size : 1);
+            if (new_block == NULL) {
+                goto fail;
+            }
+            chunk->block = new_block;
+            allocated_rows = new_rows;
+            data_ptr = new_block + chunk->num_rows * row_size;
+            if (chunk->needs_init) {
+                memset(data_ptr, '\0',
+                       (new_rows - chunk->num_rows) * row_size);
+            }
+            if (stats != NULL) {
+                READ_STATS_STOP(stats, grow_ns, start_time);
+                stats->output_reallocs++;
+                stats->output_bytes_copied += chunk->num_rows * row_size;
+            }
+        }
+
+        int res, err_field, err_col;
+        start_time = read_stats_start(stats);
+        if (chunk->row_loop != NULL) {
+            res = chunk->row_loop(ts, data_ptr,
+                    chunk->field_types[0].descr->elsize, actual_num_fields,
+                    chunk->field_types[0].descr, chunk->pconfig, &err_col);
+        }
+        else {
+            res = convert_row(ts, data_ptr, actual_num_fields,
+                    chunk->field_types, chunk->homogeneous, chunk->usecols,
+                    NULL, NULL, 0, NULL, NULL, NULL, 0, NULL, chunk->pconfig,
+                    &err_field, &err_col);
+        }
+        READ_STATS_STOP(stats, convert_ns, start_time);
+        if (res < 0) {
+            goto fail;
+        }
+        chunk->num_rows += 1;
+        data_ptr += row_size;
+    }
+    chunk->num_fields = actual_num_fields;
+    chunk->row_size = row_size;
+
+  finish:
+    if (s != NULL) {
+        stream_close(s);
+    }
+    return;
+
+  fail:
+    chunk->failed = true;
+    goto finish;
+}
+
+
+static void
+parse_chunk(void *arg)
+{
+    parallel_chunk *chunk = (parallel_chunk *)arg;
+
+    /*
+     * Converters grab the GIL when they need it (errors or fallbacks), keep
+     * a thread state for this thread around so that this is cheap.
+     */
+    PyGILState_STATE gil_state = PyGILState_Ensure();
+    PyThreadState *thread_state = PyEval_SaveThread();
+
+    tokenizer_state ts;
+    if (tokenizer_init(&ts, chunk->pconfig) < 0) {
+        chunk->failed = true;
+    }
+    else {
+        parse_chunk_rows(chunk, &ts);
+        tokenizer_clear(&ts);
+    }
+
+    PyEval_RestoreThread(thread_state);
+    /* Errors are discarded, reading serially will raise them again */
+    PyErr_Clear();
+    PyGILState_Release(gil_state);
+}
+
+
+static void
+copy_chunk(void *arg)
+{
+    parallel_chunk *chunk = (parallel_chunk *)arg;
+    memcpy(chunk->result_ptr, chunk->block, chunk->num_rows * chunk->row_size);
+    PyMem_RawFree(chunk->block);
+    chunk->block = NULL;
+}
+
+
+/*
+ * Split `[pos, end)` into `num_chunks` chunks at row boundaries.  Chunks may
+ * end up empty.
+ */
+static void
+split_into_chunks(const char *pos, const char *end, parser_config *pconfig,
+        int num_chunks, parallel_chunk *chunks)
+{
+    bool quote_aware = raw_rows_may_span_lines(pos, end, pconfig);
+    size_t length = end - pos;
+
+    const char *row_start = pos;
+    for (int i = 0; i < num_chunks; i++) {
+        chunks[i].start = row_start;
+        if (i == num_chunks - 1) {
+            chunks[i].end = end;
+            break;
+        }
+        const char *target = pos + (length / num_chunks) * (i + 1);
+        if (!quote_aware) {
+            /* Every line end is a row end, search from the target */
+            if (row_start < target) {
+                row_start = raw_row_end(target, end, pconfig, false);
+            }
+        }
+        else {
+            /* Have to walk all rows to know which newlines are quoted */
+            while (row_start < target) {
+                row_start = raw_row_end(row_start, end, pconfig, true);
+            }
+        }
+        chunks[i].end = row_start;
+    }
+}
+
+
+/*
+ * Set up the information shared by all chunks about how to parse and
+ * convert the rows.
+ */
+static void
+init_chunks(int num_chunks, parallel_chunk *chunks,
+        int num_field_types, field_type *field_types,
+        parser_config *pconfig, int num_usecols, int *usecols,
+        PyArray_Descr *out_descr, bool homogeneous, bool collect_stats)
+{
+    int num_fields = -1;
+    if (usecols != NULL) {
+        num_fields = num_usecols;
+    }
+    else if (!homogeneous) {
+        num_fields = num_field_types;
+    }
+    size_t row_size = out_descr->elsize;
+    if (homogeneous && num_fields != -1) {
+        row_size *= num_fields;
+    }
+    bool needs_init = PyDataType_FLAGCHK(out_descr, NPY_NEEDS_INIT);
+    row_loop_function *row_loop = select_row_loop(
+            field_types, homogeneous, usecols);
+
+    for (int i = 0; i < num_chunks; i++) {
+        chunks[i].pconfig = pconfig;
+        chunks[i].field_types = field_types;
+        chunks[i].homogeneous = homogeneous;
+        chunks[i].usecols = usecols;
+        chunks[i].num_fields = num_fields;
+        chunks[i].row_size = row_size;
+        chunks[i].needs_init = needs_init;
+        chunks[i].row_loop = row_loop;
+        chunks[i].collect_stats = collect_stats;
+    }
+}
+
+
+/*
+ * Copy the blocks of the parsed chunks into a new result array (the blocks
+ * are freed).  Returns NULL without an error if any chunk failed, the
+ * number of columns differs between chunks or no rows were read.
+ */
+static PyArrayObject *
+concatenate_chunks(int num_chunks, parallel_chunk *chunks,
+        PyArray_Descr *out_descr, bool homogeneous, read_stats *stats)
+{
+    int num_fields = -1;
+    npy_intp row_count = 0;
+    for (int i = 0; i < num_chunks; i++) {
+        if (chunks[i].failed) {
+            return NULL;
+        }
+        if (chunks[i].num_rows == 0) {
+            continue;
+        }
+        if (num_fields == -1) {
+            num_fields = chunks[i].num_fields;
+        }
+        else if (num_fields != chunks[i].num_fields) {
+            return NULL;  /* number of columns changed between chunks */
+        }
+        row_count += chunks[i].num_rows;
+    }
+    if (row_count == 0) {
+        return NULL;  /* the serial version deals with this best */
+    }
+
+    npy_intp result_shape[2] = {row_count, num_fields};
+    Py_INCREF(out_descr);
+    PyArrayObject *data_array = (PyArrayObject *)PyArray_SimpleNewFromDescr(
+            homogeneous ? 2 : 1, result_shape, out_descr);
+    if (data_array == NULL) {
+        /* Clear the error, since we will try again serially. */
+        PyErr_Clear();
+        return NULL;
+    }
+
+    char *result_ptr = PyArray_BYTES(data_array);
+    for (int i = 0; i < num_chunks; i++) {
+        chunks[i].result_ptr = result_ptr;
+        result_ptr += chunks[i].num_rows * chunks[i].row_size;
+    }
+    Py_BEGIN_ALLOW_THREADS;
+    parallel_run(num_chunks,
+            &copy_chunk, chunks, sizeof(parallel_chunk));
+    Py_END_ALLOW_THREADS;
+
+    if (stats != NULL) {
+        /* Only a successful parallel read counts, otherwise we read again */
+        for (int i = 0; i < num_chunks; i++) {
+            read_stats_add(stats, &chunks[i].stats);
+            stats->output_bytes_copied += (
+                    chunks[i].num_rows * chunks[i].row_size);
+        }
+    }
+    return data_array;
+}
+
+
+static PyArrayObject *
+read_rows_parallel(const char *start, const char *end,
+        int num_field_types, field_type *field_types,
+        parser_config *pconfig, int num_usecols, int *usecols,
+        Py_ssize_t skiplines, PyArray_Descr *out_descr,
+        bool homogeneous, int num_threads, read_stats *stats)
+{
+    const char *pos = start;
+    pos = raw_skip_lines(pos, end, &skiplines);
+
+    int num_chunks = (int)((end - pos) / MIN_PARALLEL_CHUNK_SIZE);
+    if (num_chunks > num_threads) {
+        num_chunks = num_threads;
+    }
+    if (num_chunks < 2) {
+        return NULL;  /* not worth it, read serially (no error set) */
+    }
+
+    parallel_chunk *chunks = PyMem_Calloc(num_chunks, sizeof(parallel_chunk));
+    if (chunks == NULL) {
+        return NULL;  /* also fine, just read serially */
+    }
+    split_into_chunks(pos, end, pconfig, num_chunks, chunks);
+    init_chunks(num_chunks, chunks, num_field_types, field_types, pconfig,
+            num_usecols, usecols, out_descr, homogeneous, stats != NULL);
+
+    Py_BEGIN_ALLOW_THREADS;
+    parallel_run(num_chunks,
+            &parse_chunk, chunks, sizeof(parallel_chunk));
+    Py_END_ALLOW_THREADS;
+    /*
+     * A converter which needs Python for some strings (datetimes) may have
+     * set an error for this thread, any failure is reported when reading
+     * serially.
+     */
+    PyErr_Clear();
+
+    PyArrayObject *data_array = concatenate_chunks(
+            num_chunks, chunks, out_descr, homogeneous, stats);
+
+    for (int i = 0; i < num_chunks; i++) {
+        PyMem_RawFree(chunks[i].block);
+    }
+    PyMem_FREE(chunks);
+    return data_array;
+}
+
+
+/*
+ * Reading many files
+ * ------------------
+ * Each file (shard) is parsed like a parallel chunk.  The shards are
+ * distributed round-robin over at most `num_threads` threads, each of which
+ * parses all of its shards with one tokenizer.  The blocks are then copied
+ * into one result, placed by the row counts of the shards.  As above, if
+ * anything fails the files are read one by one instead.
+ */
+
+typedef struct {
+    /* The paths of all files and how to open them */
+    PyObject **files;
+    const char *encoding;
+    Py_ssize_t skiplines;
+    /* The shards parsed by this thread: `first`, `first + step`, ... */
+    parallel_chunk *shards;
+    int num_shards;
+    int first;
+    int step;
+} shard_worker;
+
+
+static void
+parse_shards(void *arg)
+{
+    shard_worker *worker = (shard_worker *)arg;
+
+    PyGILState_STATE gil_state = PyGILState_Ensure();
+    PyThreadState *thread_state = PyEval_SaveThread();
+
+    tokenizer_state ts;
+    if (tokenizer_init(&ts, worker->shards[0].pconfig) < 0) {
+        worker->shards[worker->first].failed = true;
+        goto finish;
+    }
+    for (int i = worker->first; i < worker->num_shards; i += worker->step) {
+        parallel_chunk *shard = &worker->shards[i];
+
+        /* Opening (and closing) the file uses the Python API */
+        PyEval_RestoreThread(thread_state);
+        stream *s = stream_native_file(worker->files[i], worker->encoding);
+        PyErr_Clear();
+        thread_state = PyEval_SaveThread();
+
+        char *start, *end;
+        if (s != NULL && stream_rawdata(s, &start, &end)) {
+            Py_ssize_t skiplines = worker->skiplines;
+            shard->start = raw_skip_lines(start, end, &skiplines);
+            shard->end = end;
+            parse_chunk_rows(shard, &ts);
+        }
+        else {
+            shard->failed = true;
+        }
+
+        if (s != NULL) {
+            PyEval_RestoreThread(thread_state);
+            stream_close(s);
+            thread_state = PyEval_SaveThread();
+        }
+        if (shard->failed) {
+            break;  /* the files are read one by one anyway */
+        }
+    }
+    tokenizer_clear(&ts);
+
+  finish:
+    PyEval_RestoreThread(thread_state);
+    /* Errors are discarded, reading the files one by one raises them */
+    PyErr_Clear();
+    PyGILState_Release(gil_state);
+}
+
+
+PyArrayObject *
+read_rows_many(int num_files, PyObject **files, const char *encoding,
+        int num_field_types, field_type *field_types,
+        parser_config *pconfig, int num_usecols, int *usecols,
+        Py_ssize_t skiplines, PyArray_Descr *out_descr,
+        bool homogeneous, int num_threads)
+{
+    if (num_files < 1 || pconfig->column_major
+            || discovers_string_length(out_descr, homogeneous)
+            || !has_native_conversion(num_field_types, field_types, Py_None)) {
+        return NULL;
+    }
+    int num_workers = num_threads < num_files ? num_threads : num_files;
+    if (num_workers < 1) {
+        num_workers = 1;
+    }
+
+    PyArrayObject *data_array = NULL;
+    shard_worker *workers = NULL;
+    parallel_chunk *shards = PyMem_Calloc(num_files, sizeof(parallel_chunk));
+    if (shards == NULL) {
+        return NULL;
+    }
+    workers = PyMem_Calloc(num_workers, sizeof(shard_worker));
+    if (workers == NULL) {
+        goto finish;
+    }
+    init_chunks(num_files, shards, num_field_types, field_types, pconfig,
+            num_usecols, usecols, out_descr, homogeneous, false);
+    for (int i = 0; i < num_workers; i++) {
+        workers[i].files = files;
+        workers[i].encoding = encoding;
+        workers[i].skiplines = skiplines;
+        workers[i].shards = shards;
+        workers[i].num_shards = num_files;
+        workers[i].first = i;
+        workers[i].step = num_workers;
+    }
+
+    Py_BEGIN_ALLOW_THREADS;
+    parallel_run(num_workers,
+            &parse_shards, workers, sizeof(shard_worker));
+    Py_END_ALLOW_THREADS;
+
+    data_array = concatenate_chunks(
+            num_files, shards, out_descr, homogeneous, NULL);
+
+  finish:
+    for (int i = 0; i < num_files; i++) {
+        PyMem_RawFree(shards[i].block);
+    }
+    PyMem_FREE(shards);
+    PyMem_FREE(workers);
+    return data_array;
+}
+
+
+/**
+ * Read a file into the provided array, or create (and possibly grow) an
+ * array to read into.
+ *
+ * @param s The stream object/struct providing reading capabilities used by
+ *        the tokenizer.
+ * @param max_rows The number of rows to read, or -1.  If negative
+ *        all rows are read.
+ * @param num_field_types The number of field types stored in `field_types`.
+ * @param field_types Information about the dtype for each column (or one if
+ *        `homogeneous`).
+ * @param pconfig Pointer to the parser config object used by both the
+ *        tokenizer and the conversion functions.
+ * @param num_usecols The number of columns in `usecols`.
+ * @param usecols An array of length `num_usecols` or NULL.  If given indicates
+ *        which column is read for each individual row (negative columns are
+ *        accepted).
+ * @param skiplines The number of lines to skip, these lines are ignored.
+ * @param converters Python dictionary of converters.  Finalizing converters
+ *        is difficult without information about the number of columns.
+ * @param data_array An array to be filled or NULL.  In either case a new
+ *        reference is returned (the reference to `data_array` is not stolen).
+ * @param out_descr The dtype used for allocating a new array.  This is not
+ *        used if `data_array` is provided.  Note that the actual dtype of the
+ *        returned array can differ for strings.
+ * @param num_cols Pointer in which the actual (discovered) number of columns
+ *        is returned.  This is only relevant if `homogeneous` is true.
+ * @param homogeneous Whether the datatype of the array is not homogeneous,
+ *        i.e. not structured.  In this case the number of columns has to be
+ *        discovered an the returned array will be 2-dimensional rather than
+ *        1-dimensional.
+ * @param num_threads The number of threads to use.  Only used when reading
+ *        the whole file into a new array from a raw stream when no Python
+ *        converters or other Python API is necessary.
+ * @param stats Counters to update while reading (see `read_stats.h`),
+ *        or NULL.
+ * @param row_count If not NULL, set to the number of rows read, which is
+ *        needed to know how much of `data_array` was filled in.
+ *
+ * @returns Returns the result as an array object or NULL on error.  The result
+ *          is always a new reference (even when `data_array` was passed in).
+ */
+PyArrayObject *
+read_rows(stream *s,
+        npy_intp max_rows, int num_field_types, field_type *field_types,
+        parser_config *pconfig, int num_usecols, int *usecols,
+        Py_ssize_t skiplines, PyObject *converters,
+        PyArrayObject *data_array, PyArray_Descr *out_descr,
+        bool homogeneous, int num_threads, read_stats *stats,
+        npy_intp *row_count)
+{
+    char *start, *end;
+    if (num_threads > 1 && max_rows < 0 && data_array == NULL
+            && !pconfig->column_major
+            && !discovers_string_length(out_descr, homogeneous)
+            && has_native_conversion(num_field_types, field_types, converters)
+            && stream_rawdata(s, &start, &end)) {
+        /*
+         * Returns NULL without an error if parallel reading is not possible
+         * or failed.  The stream is not consumed, so we can read serially.
+         */
+        PyArrayObject *res = read_rows_parallel(
+                start, end, num_field_types, field_types, pconfig,
+                num_usecols, usecols, skiplines, out_descr,
+                homogeneous, num_threads, stats);
+        if (res != NULL) {
+            if (row_count != NULL) {
+                *row_count = PyArray_DIM(res, 0);
+            }
+            return res;
+        }
+    }
+
+    rows_state rs;
+    if (rows_state_init(&rs, pconfig, skiplines) < 0) {
+        return NULL;
+    }
+    rs.ts.stats = stats;
+    PyArrayObject *res = read_rows_batch(
+            s, &rs, max_rows, num_field_types, field_types, pconfig,
+            num_usecols, usecols, converters,
+            data_array, out_descr, homogeneous);
+    if (row_count != NULL) {
+        *row_count = rs.row_count;
+    }
+    rows_state_clear(&rs);
+    return res;
+}
@@ -7,8 +7,83 @@
 #include <stdio.h>
 
 #include "stream.h"
+#include "tokenize.h"
 #include "field_types.h"
 #include "parser_config.h"
+#include "categories.h"
+#include "missing.h"
+#include "arrow.h"
+
+
+/*
+ * State which is kept when reading a stream in multiple batches.
+ */
+typedef struct {
+    tokenizer_state ts;
+    /* The number of fields (columns) once known, otherwise -1 */
+    int num_fields;
+    /* The converter for each field (entries may be NULL), once known */
+    PyObject **conv_funcs;
+    /* The columns to dictionary encode (a sequence or NULL, set by the user) */
+    PyObject *categorical;
+    /* The category table for each field (entries may be NULL), once known */
+    category_table **categories;
+    /*
+     * The missing values and fill values of the columns (a dictionary or
+     * NULL, set by the user, see `missing_state_create`), whether to record
+     * the positions of the missing fields, and the state once known.
+     */
+    PyObject *missing;
+    bool record_missing;
+    missing_state *missing_state;
+    /*
+     * The fields stored as variable-length strings (True, a sequence or
+     * NULL, set by the user, see `arrow_string_columns_create`) and their
+     * string columns once known.
+     */
+    PyObject *strings;
+    arrow_string_column **string_columns;
+    /* Lines which still have to be skipped */
+    Py_ssize_t skiplines;
+    /* The number of rows read so far */
+    Py_ssize_t row_count;
+    /* Whether the end of the stream was reached */
+    bool finished;
+} rows_state;
+
+
+int
+rows_state_init(rows_state *rs, parser_config *pconfig, Py_ssize_t skiplines);
+
+void
+rows_state_clear(rows_state *rs);
+
+PyObject *
+rows_state_categories(rows_state *rs);
+
+/*
+ * Returns a new dictionary mapping the string fields to the uint8 arrays of
+ * their UTF-8 data read since the last call (or the start), empty if no row
+ * was read yet.  The data of each field starts over empty.
+ */
+PyObject *
+rows_state_take_strings(rows_state *rs);
+
+/*
+ * Returns a new tuple with the 1-D arrays of the fields of the (not
+ * homogeneous) column-major result `arr`, which are views of it.
+ */
+PyObject *
+column_major_fields(PyArrayObject *arr, int num_fields,
+        field_type *field_types);
+
+PyArrayObject *
+read_rows_batch(stream *s, rows_state *rs,
+        npy_intp max_rows, int num_field_types, field_type *field_types,
+        parser_config *pconfig, int num_usecols, int *usecols,
+        PyObject *converters,
+        PyArrayObject *data_array, PyArray_Descr *out_descr,
+        bool homogeneous);
 
 
 PyArrayObject *
@@ -17,6 +92,22 @@ read_rows(stream *s,
         parser_config *pconfig, int num_usecols, int *usecols,
         Py_ssize_t skiplines, PyObject *converters,
         PyArrayObject *data_array, PyArray_Descr *out_descr,
-        bool homogeneous);
+        bool homogeneous, int num_threads, read_stats *stats,
+        npy_intp *row_count);
+
+/*
+ * Read the rows of the `num_files` native `files` (paths, skipping
+ * `skiplines` lines of each) into one new array, using up to `num_threads`
+ * threads (each of which reads whole files).  Returns NULL without an
+ * error if the files have to be read one by one, e.g. because Python
+ * converters are needed, a file cannot be read natively or any reading
+ * error occurred.
+ */
+PyArrayObject *
+read_rows_many(int num_files, PyObject **files, const char *encoding,
+        int num_field_types, field_type *field_types,
+        parser_config *pconfig, int num_usecols, int *usecols,
+        Py_ssize_t skiplines, PyArray_Descr *out_descr,
+        bool homogeneous, int num_threads);
 
 #endif
@@ -0,0 +1,129 @@
+
+#include <string.h>
+
+#include "simd_scan.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+    #define SCAN_HAVE_SSE2 1
+    #include <emmintrin.h>
+    #if (defined(__GNUC__) || defined(__clang__))
+        /* AVX2 is compiled for a target and only used if supported */
+        #define SCAN_HAVE_AVX2 1
+        #include <immintrin.h>
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define SCAN_HAVE_NEON 1
+    #include <arm_neon.h>
+#endif
+
+
+scan_block_mask_function *scan_block_mask = NULL;
+
+
+#ifdef SCAN_HAVE_SSE2
+static uint64_t
+block_mask_sse2(const Py_UCS1 *block, const scan_charset *charset)
+{
+    const __m128i c0 = _mm_set1_epi8((char)charset->chars[0]);
+    const __m128i c1 = _mm_set1_epi8((char)charset->chars[1]);
+    const __m128i c2 = _mm_set1_epi8((char)charset->chars[2]);
+    const __m128i c3 = _mm_set1_epi8((char)charset->chars[3]);
+
+    uint64_t mask = 0;
+    for (int i = 0; i < SCAN_BLOCK_SIZE / 16; i++) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(block + 16 * i));
+        __m128i m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, c0), _mm_cmpeq_epi8(v, c1)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, c2), _mm_cmpeq_epi8(v, c3)));
+        mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(m) << (16 * i);
+    }
+    return mask;
+}
+#endif
+
+
+#ifdef SCAN_HAVE_AVX2
+__attribute__((target("avx2")))
+static uint64_t
+block_mask_avx2(const Py_UCS1 *block, const scan_charset *charset)
+{
+    const __m256i c0 = _mm256_set1_epi8((char)charset->chars[0]);
+    const __m256i c1 = _mm256_set1_epi8((char)charset->chars[1]);
+    const __m256i c2 = _mm256_set1_epi8((char)charset->chars[2]);
+    const __m256i c3 = _mm256_set1_epi8((char)charset->chars[3]);
+
+    uint64_t mask = 0;
+    for (int i = 0; i < SCAN_BLOCK_SIZE / 32; i++) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(block + 32 * i));
+        __m256i m = _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(v, c0), _mm256_cmpeq_epi8(v, c1)),
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(v, c2), _mm256_cmpeq_epi8(v, c3)));
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(m) << (32 * i);
+    }
+    return mask;
+}
+#endif
+
+
+#ifdef SCAN_HAVE_NEON
+static uint64_t
+block_mask_neon(const Py_UCS1 *block, const scan_charset *charset)
+{
+    static const uint8_t bit_weights[16] = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t weights = vld1q_u8(bit_weights);
+    const uint8x16_t c0 = vdupq_n_u8(charset->chars[0]);
+    const uint8x16_t c1 = vdupq_n_u8(charset->chars[1]);
+    const uint8x16_t c2 = vdupq_n_u8(charset->chars[2]);
+    const uint8x16_t c3 = vdupq_n_u8(charset->chars[3]);
+
+    uint8x16_t m[4];
+    for (int i = 0; i < 4; i++) {
+        uint8x16_t v = vld1q_u8(block + 16 * i);
+        m[i] = vorrq_u8(
+                vorrq_u8(vceqq_u8(v, c0), vceqq_u8(v, c1)),
+                vorrq_u8(vceqq_u8(v, c2), vceqq_u8(v, c3)));
+        m[i] = vandq_u8(m[i], weights);
+    }
+    /* There is no movemask, add up the weighted bits pairwise instead */
+    uint8x16_t sum = vpaddq_u8(vpaddq_u8(m[0], m[1]), vpaddq_u8(m[2], m[3]));
+    sum = vpaddq_u8(sum, sum);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
+}
+#endif
+
+
+void
+simd_scan_init(void)
+{
+#ifdef SCAN_HAVE_SSE2
+    scan_block_mask = &block_mask_sse2;
+#endif
+#ifdef SCAN_HAVE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        scan_block_mask = &block_mask_avx2;
+    }
+#endif
+#ifdef SCAN_HAVE_NEON
+    scan_block_mask = &block_mask_neon;
+#endif
+}
+
+
+void
+scan_charset_init(scan_charset *charset, int n, const Py_UCS4 *chars)
+{
+    int num_valid = 0;
+    for (int i = 0; i < n; i++) {
+        if (chars[i] <= 0xFF) {
+            charset->chars[num_valid++] = (Py_UCS1)chars[i];
+        }
+    }
+    assert(num_valid > 0 && num_valid <= 4);
+    for (int i = num_valid; i < 4; i++) {
+        charset->chars[i] = charset->chars[0];
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef _SIMD_SCAN_H_
+#define _SIMD_SCAN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "numpy/ndarraytypes.h"
+
+/*
+ * Vectorized search for "structural" characters (line ends, delimiter,
+ * comment, quote) in 1-byte kind data, used by the tokenizer.
+ *
+ * Like simdjson/simdcsv, we build a bitmask of all matching characters in a
+ * block of 64 bytes.  The mask of the last block is cached so that finding
+ * the next structural character after a short field does not need to scan
+ * again.  The SIMD version (SSE2, AVX2 or NEON) is chosen at runtime by
+ * `simd_scan_init()`.
+ */
+
+#define SCAN_BLOCK_SIZE 64
+
+/* Up to four characters to search for (unused entries repeat one) */
+typedef struct {
+    Py_UCS1 chars[4];
+} scan_charset;
+
+typedef struct {
+    /* Start of the block `mask` belongs to (NULL if nothing is cached) */
+    const Py_UCS1 *block;
+    const scan_charset *charset;
+    uint64_t mask;
+} scan_cache;
+
+typedef uint64_t (scan_block_mask_function)(
+        const Py_UCS1 *block, const scan_charset *charset);
+
+/* The block mask implementation, NULL if no SIMD version is available */
+extern scan_block_mask_function *scan_block_mask;
+
+
+void
+simd_scan_init(void);
+
+/*
+ * Initialize a charset with `n` characters (at least one must be below 256),
+ * characters which cannot occur in 1-byte data are ignored.
+ */
+void
+scan_charset_init(scan_charset *charset, int n, const Py_UCS4 *chars);
+
+
+static NPY_INLINE int
+scan_trailing_zeros(uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(mask);
+#else
+    int n = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+
+/*
+ * Returns the first position in `[pos, end)` matching one of the characters
+ * in `charset` (or `end`).  The cache must be cleared (`block = NULL`)
+ * whenever the data `pos` points into may have changed.
+ */
+static NPY_INLINE const Py_UCS1 *
+scan_find_any(const Py_UCS1 *pos, const Py_UCS1 *end,
+        const scan_charset *charset, scan_cache *cache)
+{
+    if (scan_block_mask != NULL) {
+        const Py_UCS1 *block = cache->block;
+        uint64_t mask;
+        if (block != NULL && cache->charset == charset
+                && pos >= block && pos < block + SCAN_BLOCK_SIZE) {
+            mask = cache->mask;
+        }
+        else if (end - pos >= SCAN_BLOCK_SIZE) {
+            block = pos;
+            mask = scan_block_mask(block, charset);
+        }
+        else {
+            goto tail;
+        }
+
+        while (1) {
+            mask &= UINT64_MAX << (pos - block);
+            if (mask != 0) {
+                cache->block = block;
+                cache->charset = charset;
+                cache->mask = mask;
+                return block + scan_trailing_zeros(mask);
+            }
+            pos = block + SCAN_BLOCK_SIZE;
+            if (end - pos < SCAN_BLOCK_SIZE) {
+                break;
+            }
+            block = pos;
+            mask = scan_block_mask(block, charset);
+        }
+        cache->block = NULL;
+    }
+
+  tail:
+    for (; pos < end; pos++) {
+        Py_UCS1 c = *pos;
+        if (c == charset->chars[0] || c == charset->chars[1]
+                || c == charset->chars[2] || c == charset->chars[3]) {
+            break;
+        }
+    }
+    return pos;
+}
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef STR_TO_DOUBLE_H
+#define STR_TO_DOUBLE_H
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <float.h>
+
+#include "numpy/ndarraytypes.h"
+
+
+/*
+ * Must be called once (with the GIL held) before parsing, fetches the exact
+ * NaN values Python produces.
+ */
+int
+str_to_double_init(void);
+
+/*
+ * Parse a floating point number at the start of `str`, accepting exactly
+ * what `PyOS_string_to_double` accepts and producing the identical result
+ * (i.e. it is correctly rounded).  Leading whitespace is not skipped.
+ * Most numbers are parsed natively (Eisel-Lemire), only for very long
+ * mantissas or the rare cases it cannot decide the Python parser is used
+ * (the GIL is grabbed for this if necessary).
+ *
+ * Returns 0 on success, setting `p_end` to the first character not parsed.
+ * Returns -1 if `str` does not start with a number (an error may be set if
+ * the Python parser failed).
+ */
+#define DECLARE_STR_TO_DOUBLE_PROTOTYPE(type)                           \
+    int                                                                 \
+    str_to_double_##type(const type *str, const type *end,              \
+            double *result, const type **p_end);
+
+DECLARE_STR_TO_DOUBLE_PROTOTYPE(Py_UCS1)
+DECLARE_STR_TO_DOUBLE_PROTOTYPE(Py_UCS2)
+DECLARE_STR_TO_DOUBLE_PROTOTYPE(Py_UCS4)
+
+
+#define MAX_EXPONENT_FAST_PATH 22
+#define MAX_MANTISSA_FAST_PATH ((uint64_t)2 << 52)
+
+/*
+ * Clinger's fast path relies on double arithmetic being exact (correctly
+ * rounded) which is not the case e.g. on x87 without SSE2.
+ */
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+    #define HAVE_CLINGER_FAST_PATH 1
+#else
+    #define HAVE_CLINGER_FAST_PATH 0
+#endif
+
+/* 1e0 to 1e22, which are exact doubles */
+extern NPY_NO_EXPORT const double exact_powers_of_ten[];
+
+/*
+ * Parse a plain decimal (between optional whitespace) which Clinger's fast
+ * path computes exactly, so that the result is identical to `to_double`.
+ * It is in the header, so that it can be inlined into the row loops.
+ * Returns -1 for all other strings (also valid numbers, e.g. with more
+ * than 19 digits or "inf"), which should then be parsed by `to_double`.
+ */
+#define DEFINE_STR_TO_DOUBLE_FAST(type)                                 \
+    static NPY_INLINE int                                               \
+    str_to_double_fast_##type(                                          \
+            const type *p, const type *p_end, double *result)           \
+    {                                                                   \
+        if (!HAVE_CLINGER_FAST_PATH) {                                  \
+            return -1;                                                  \
+        }                                                               \
+        while (p < p_end && Py_UNICODE_ISSPACE(*p)) {                   \
+            p++;                                                        \
+        }                                                               \
+        bool negative = false;                                          \
+        if (p < p_end && (*p == '-' || *p == '+')) {                    \
+            negative = *p == '-';                                       \
+            p++;                                                        \
+        }                                                               \
+                                                                        \
+        /* Like `str_to_double`, leading zeros are not counted */      \
+        uint64_t mantissa = 0;                                          \
+        int64_t exponent = 0;                                           \
+        int num_digits = 0;                                             \
+        const type *p_digits = p;                                       \
+        for (; p < p_end && *p >= '0' && *p <= '9'; p++) {              \
+            if (num_digits == 19) {                                     \
+                return -1;                                              \
+            }                                                           \
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');            \
+            num_digits += mantissa != 0;                                \
+        }                                                               \
+        bool has_digits = p != p_digits;                                \
+        if (p < p_end && *p == '.') {                                   \
+            p_digits = ++p;                                             \
+            for (; p < p_end && *p >= '0' && *p <= '9'; p++) {          \
+                if (num_digits == 19) {                                 \
+                    return -1;                                          \
+                }                                                       \
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');        \
+                num_digits += mantissa != 0;                            \
+                exponent--;                                             \
+            }                                                           \
+            has_digits = has_digits || p != p_digits;                   \
+        }                                                               \
+        if (!has_digits) {                                              \
+            return -1;                                                  \
+        }                                                               \
+        if (p < p_end && (*p == 'e' || *p == 'E')) {                    \
+            p++;                                                        \
+            bool negative_exponent = false;                             \
+            if (p < p_end && (*p == '-' || *p == '+')) {                \
+                negative_exponent = *p == '-';                          \
+                p++;                                                    \
+            }                                                           \
+            if (!(p < p_end && *p >= '0' && *p <= '9')) {               \
+                return -1;                                              \
+            }                                                           \
+            int64_t exp_value = 0;                                      \
+            for (; p < p_end && *p >= '0' && *p <= '9'; p++) {          \
+                if (exp_value < 10000) {                                \
+                    exp_value = exp_value * 10 + (*p - '0');            \
+                }                                                       \
+            }                                                           \
+            exponent += negative_exponent ? -exp_value : exp_value;     \
+        }                                                               \
+        while (p < p_end && Py_UNICODE_ISSPACE(*p)) {                   \
+            p++;                                                        \
+        }                                                               \
+        if (p != p_end || exponent < -MAX_EXPONENT_FAST_PATH            \
+                || exponent > MAX_EXPONENT_FAST_PATH                    \
+                || mantissa > MAX_MANTISSA_FAST_PATH) {                 \
+            return -1;                                                  \
+        }                                                               \
+        double value = (double)mantissa;                                \
+        if (exponent < 0) {                                             \
+            value = value / exact_powers_of_ten[-exponent];             \
+        }                                                               \
+        else {                                                          \
+            value = value * exact_powers_of_ten[exponent];              \
+        }                                                               \
+        *result = negative ? -value : value;                            \
+        return 0;                                                       \
+    }
+
+DEFINE_STR_TO_DOUBLE_FAST(Py_UCS1)
+DEFINE_STR_TO_DOUBLE_FAST(Py_UCS2)
+DEFINE_STR_TO_DOUBLE_FAST(Py_UCS4)
+
+#endif
@@ -10,19 +10,26 @@
 NPY_NO_EXPORT PyArray_Descr *double_descr = NULL;
 
 // TODO: The float fallbacks are seriously awkward, why? Or at least why this way?
-#define DECLARE_TO_INT(intw, INT_MIN, INT_MAX)                                      \
+#define DECLARE_TO_INT(intw, INT_MIN, INT_MAX, type)                                \
     int                                                                             \
-    to_##intw(PyArray_Descr *descr,                                                 \
-            const Py_UCS4 *str, const Py_UCS4 *end, char *dataptr,                  \
+    to_##intw##_##type(PyArray_Descr *descr,                                        \
+            const type *str, const type *end, char *dataptr,                        \
             parser_config *pconfig)                                                 \
     {                                                                               \
+        bool isneg;                                                                 \
+        uint64_t magnitude;                                                         \
         int64_t parsed;                                                             \
         intw##_t x;                                                                 \
                                                                                     \
-        if (str_to_int64(str, end, INT_MIN, INT_MAX, &parsed) < 0) {                \
+        /* Also parses simple floats (if allowed), avoiding `to_double` */          \
+        if (str_to_magnitude_##type(str, end, pconfig->allow_float_for_int,         \
+                    &isneg, &magnitude) < 0                                         \
+                || int64_from_magnitude(                                            \
+                    isneg, magnitude, INT_MIN, INT_MAX, &parsed) < 0) {             \
             if (pconfig->allow_float_for_int) {                                     \
                 double fx;                                                          \
-                if (to_double(double_descr, str, end, (char *)&fx, pconfig) < 0) {  \
+                if (to_double_##type(                                               \
+                        double_descr, str, end, (char *)&fx, pconfig) < 0) {        \
                     return -1;                                                      \
                 }                                                                   \
                 else {                                                              \
@@ -43,19 +50,26 @@ NPY_NO_EXPORT PyArray_Descr *double_descr = NULL;
         return 0;                                                                   \
     }
 
-#define DECLARE_TO_UINT(uintw, UINT_MAX)                                            \
+#define DECLARE_TO_UINT(uintw, UINT_MAX, type)                                      \
     int                                                                             \
-    to_##uintw(PyArray_Descr *descr,                                                \
-            const Py_UCS4 *str, const Py_UCS4 *end, char *dataptr,                  \
+    to_##uintw##_##type(PyArray_Descr *descr,                                       \
+            const type *str, const type *end, char *dataptr,                        \
             parser_config *pconfig)                                                 \
     {                                                                               \
+        bool isneg;                                                                 \
+        uint64_t magnitude;                                                         \
         uint64_t parsed;                                                            \
         uintw##_t x;                                                                \
                                                                                     \
-        if (str_to_uint64(str, end, UINT_MAX, &parsed) < 0) {                       \
+        /* Also parses simple floats (if allowed), avoiding `to_double` */          \
+        if (str_to_magnitude_##type(str, end, pconfig->allow_float_for_int,         \
+                    &isneg, &magnitude) < 0                                         \
+                || uint64_from_magnitude(                                           \
+                    isneg, magnitude, UINT_MAX, &parsed) < 0) {                     \
             if (pconfig->allow_float_for_int) {                                     \
                 double fx;                                                          \
-                if (to_double(double_descr, str, end, (char *)&fx, pconfig) < 0) {  \
+                if (to_double_##type(                                               \
+                        double_descr, str, end, (char *)&fx, pconfig) < 0) {        \
                     return -1;                                                      \
                 }                                                                   \
                 else {                                                              \
@@ -76,12 +90,17 @@ NPY_NO_EXPORT PyArray_Descr *double_descr = NULL;
         return 0;                                                                   \
     }
 
-DECLARE_TO_INT(int8, INT8_MIN, INT8_MAX)
-DECLARE_TO_INT(int16, INT16_MIN, INT16_MAX)
-DECLARE_TO_INT(int32, INT32_MIN, INT32_MAX)
-DECLARE_TO_INT(int64, INT64_MIN, INT64_MAX)
+#define DECLARE_TO_INTS(type)                                                       \
+    DECLARE_TO_INT(int8, INT8_MIN, INT8_MAX, type)                                  \
+    DECLARE_TO_INT(int16, INT16_MIN, INT16_MAX, type)                               \
+    DECLARE_TO_INT(int32, INT32_MIN, INT32_MAX, type)                               \
+    DECLARE_TO_INT(int64, INT64_MIN, INT64_MAX, type)                               \
+                                                                                    \
+    DECLARE_TO_UINT(uint8, UINT8_MAX, type)                                         \
+    DECLARE_TO_UINT(uint16, UINT16_MAX, type)                                       \
+    DECLARE_TO_UINT(uint32, UINT32_MAX, type)                                       \
+    DECLARE_TO_UINT(uint64, UINT64_MAX, type)
 
-DECLARE_TO_UINT(uint8, UINT8_MAX)
-DECLARE_TO_UINT(uint16, UINT16_MAX)
-DECLARE_TO_UINT(uint32, UINT32_MAX)
-DECLARE_TO_UINT(uint64, UINT64_MAX)
+DECLARE_TO_INTS(Py_UCS1)
+DECLARE_TO_INTS(Py_UCS2)
+DECLARE_TO_INTS(Py_UCS4)
@@ -2,6 +2,10 @@
 #define STR_TO_INT_H
 
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
 #include "parser_config.h"
 
 #define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
@@ -13,166 +17,265 @@
 extern NPY_NO_EXPORT PyArray_Descr *double_descr;
 
 /*
- * The following two string conversion functions are largely equivalent
- * in Pandas.  They are in the header file here, to ensure they can be easily
- * inline in the other function.
+ * The following string conversion functions were largely equivalent to the
+ * ones in Pandas.  They are in the header file here, to ensure they can be
+ * easily inline in the other function.
  * Unlike pandas, pass in end-pointer (do not rely on \0) and return 0 or -1.
  *
- * The actual functions are defined using macro templating below.
+ * The digits are parsed eight at a time where possible (SWAR, for the
+ * 1-byte kind) and overflow is checked only once at the end.
+ *
+ * The actual functions are defined using macro templating below, for each
+ * of the unicode kinds (`Py_UCS1`, `Py_UCS2` and `Py_UCS4`).
+ */
+#define STR_IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+
+/* Up to 19 digits always fit into a uint64 */
+#define UINT64_SAFE_DIGITS 19
+
+/*
+ * Parse eight digits at `str` into `*value`, returns 0 if they are not all
+ * digits (or on big endian machines, where this is not implemented).
  */
 static NPY_INLINE int
-str_to_int64(
-        const Py_UCS4 *p_item, const Py_UCS4 *p_end,
-        int64_t int_min, int64_t int_max, int64_t *result)
+parse_eight_digits(const void *str, uint64_t *value)
 {
-    const Py_UCS4 *p = (const Py_UCS4 *)p_item;
-    bool isneg = 0;
-    int64_t number = 0;
-
-    // Skip leading spaces.
-    while (Py_UNICODE_ISSPACE(*p)) {
-        ++p;
+#if NPY_BYTE_ORDER == NPY_LITTLE_ENDIAN
+    uint64_t v;
+    memcpy(&v, str, 8);
+    /* All bytes are in '0'...'9' (0x30-0x39), i.e. 0x3? and stay < 0x40 */
+    if ((((v & 0xF0F0F0F0F0F0F0F0) |
+            (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))
+                != 0x3333333333333333)) {
+        return 0;
     }
+    /* Combine pairs of digits, then pairs of those, etc. */
+    v = ((v & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+    v = ((v & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+    *value = ((v & 0x0000FFFF0000FFFF) * 42949672960001) >> 32;
+    return 1;
+#else
+    return 0;
+#endif
+}
 
-    // Handle sign.
-    if (*p == '-') {
-        isneg = true;
-        ++p;
-    }
-    else if (*p == '+') {
-        p++;
+/*
+ * Parse the digits starting at `p` into `*result`, returns the end of the
+ * digits.  `*num_digits` is set to the number of digits excluding leading
+ * zeros, `*result` is only valid if `*overflow` is false.
+ */
+#define DEFINE_PARSE_DIGITS(type)                                       \
+    static NPY_INLINE const type *                                      \
+    parse_digits_##type(const type *p, const type *p_end,               \
+            uint64_t *result, int *num_digits, bool *overflow)          \
+    {                                                                   \
+        uint64_t number = 0;                                            \
+        int n = 0;                                                      \
+        *overflow = false;                                              \
+                                                                        \
+        while (p < p_end && *p == '0') {                                \
+            p++;                                                        \
+        }                                                               \
+        if (sizeof(type) == 1) {                                        \
+            uint64_t eight;                                             \
+            while (p_end - p >= 8 && n + 8 <= UINT64_SAFE_DIGITS        \
+                    && parse_eight_digits(p, &eight)) {                 \
+                number = number * 100000000 + eight;                    \
+                n += 8;                                                 \
+                p += 8;                                                 \
+            }                                                           \
+        }                                                               \
+        for (; p < p_end && STR_IS_DIGIT(*p); p++, n++) {               \
+            int d = *p - '0';                                           \
+            if (n < UINT64_SAFE_DIGITS) {                               \
+                number = number * 10 + d;                               \
+            }                                                           \
+            else if (n == UINT64_SAFE_DIGITS                            \
+                    && (number < UINT64_MAX / 10 ||                     \
+                        (number == UINT64_MAX / 10                      \
+                         && d <= (int)(UINT64_MAX % 10)))) {            \
+                number = number * 10 + d;                               \
+            }                                                           \
+            else {                                                      \
+                *overflow = true;                                       \
+            }                                                           \
+        }                                                               \
+        *result = number;                                               \
+        *num_digits = n;                                                \
+        return p;                                                       \
     }
 
-    // Check that there is a first digit.
-    if (!isdigit(*p)) {
-        return -1;
+
+/*
+ * Parse an unsigned integer between optional whitespace, returns -1 if the
+ * string is not an integer or the absolute value does not fit a uint64.
+ * If `allow_fraction` is true, a fractional part is accepted (and ignored)
+ * if the result is the same as parsing the number as a double and casting
+ * it to an integer (truncation).  This is the case when there are at most
+ * 15 significant digits; otherwise -1 is returned, so that the caller can
+ * fall back to parsing the double.
+ */
+#define DEFINE_STR_TO_MAGNITUDE(type)                                   \
+    static NPY_INLINE int                                               \
+    str_to_magnitude_##type(                                            \
+            const type *p, const type *p_end, bool allow_fraction,      \
+            bool *isneg, uint64_t *result)                              \
+    {                                                                   \
+        /* Skip leading spaces. */                                      \
+        while (p < p_end && Py_UNICODE_ISSPACE(*p)) {                   \
+            ++p;                                                        \
+        }                                                               \
+                                                                        \
+        /* Handle sign. */                                              \
+        *isneg = false;                                                 \
+        if (p < p_end && *p == '-') {                                   \
+            *isneg = true;                                              \
+            ++p;                                                        \
+        }                                                               \
+        else if (p < p_end && *p == '+') {                              \
+            p++;                                                        \
+        }                                                               \
+                                                                        \
+        const type *p_digits = p;                                       \
+        int num_digits;                                                 \
+        bool overflow;                                                  \
+        p = parse_digits_##type(                                        \
+                p, p_end, result, &num_digits, &overflow);              \
+        bool has_digits = p != p_digits;                                \
+                                                                        \
+        if (allow_fraction && p < p_end && *p == '.') {                 \
+            /* Float syntax, e.g. "1.0" (also "1." or ".5") */          \
+            const type *p_fraction = ++p;                               \
+            while (p < p_end && STR_IS_DIGIT(*p)) {                     \
+                p++;                                                    \
+            }                                                           \
+            has_digits = has_digits || p != p_fraction;                 \
+            if (num_digits + (p - p_fraction) > 15) {                   \
+                /* The double may round up to the next integer */       \
+                return -1;                                              \
+            }                                                           \
+        }                                                               \
+                                                                        \
+        /* Check that there was a digit. */                             \
+        if (!has_digits || overflow) {                                  \
+            return -1;                                                  \
+        }                                                               \
+                                                                        \
+        /* Skip trailing spaces. */                                     \
+        while (p < p_end && Py_UNICODE_ISSPACE(*p)) {                   \
+            ++p;                                                        \
+        }                                                               \
+                                                                        \
+        /* Did we use up all the characters? */                         \
+        if (p != p_end) {                                               \
+            return -1;                                                  \
+        }                                                               \
+        return 0;                                                       \
     }
 
+
+/*
+ * Convert the sign and magnitude to an int64 if it is within the range.
+ */
+static NPY_INLINE int
+int64_from_magnitude(bool isneg, uint64_t number,
+        int64_t int_min, int64_t int_max, int64_t *result)
+{
     if (isneg) {
-        // If number is greater than pre_min, at least one more digit
-        // can be processed without overflowing.
-        int dig_pre_min = -(int_min % 10);
-        int64_t pre_min = int_min / 10;
-
-        // Process the digits.
-        int d = *p;
-        while (isdigit(d)) {
-            if ((number > pre_min) || ((number == pre_min) && (d - '0' <= dig_pre_min))) {
-                number = number * 10 - (d - '0');
-                d = *++p;
-            }
-            else {
-                return -1;
-            }
+        if (number > (uint64_t)(-(int_min + 1)) + 1) {
+            return -1;
         }
+        /* Avoids computing `-number` for INT64_MIN */
+        *result = number == 0 ? 0 : -(int64_t)(number - 1) - 1;
     }
     else {
-        // If number is less than pre_max, at least one more digit
-        // can be processed without overflowing.
-        int64_t pre_max = int_max / 10;
-        int dig_pre_max = int_max % 10;
-
-        // Process the digits.
-        int d = *p;
-        while (isdigit(d)) {
-            if ((number < pre_max) || ((number == pre_max) && (d - '0' <= dig_pre_max))) {
-                number = number * 10 + (d - '0');
-                d = *++p;
-            }
-            else {
-                return -1;
-            }
+        if (number > (uint64_t)int_max) {
+            return -1;
         }
+        *result = (int64_t)number;
     }
-
-    // Skip trailing spaces.
-    while (Py_UNICODE_ISSPACE(*p)) {
-        ++p;
-    }
-
-    // Did we use up all the characters?
-    if (p != p_end) {
-        return -1;
-    }
-
-    *result = number;
     return 0;
 }
 
 
 static NPY_INLINE int
-str_to_uint64(
-        const Py_UCS4 *p_item, const Py_UCS4 *p_end,
+uint64_from_magnitude(bool isneg, uint64_t number,
         uint64_t uint_max, uint64_t *result)
 {
-    const Py_UCS4 *p = (const Py_UCS4 *)p_item;
-    uint64_t number = 0;
-    int d;
-
-    // Skip leading spaces.
-    while (Py_UNICODE_ISSPACE(*p)) {
-        ++p;
-    }
-
-    // Handle sign.
-    if (*p == '-') {
+    /* Note that "-0" is rejected, like any other negative number */
+    if (isneg || number > uint_max) {
         return -1;
     }
-    if (*p == '+') {
-        p++;
-    }
+    *result = number;
+    return 0;
+}
 
-    // Check that there is a first digit.
-    if (!isdigit(*p)) {
-        return -1;
-    }
 
-    // If number is less than pre_max, at least one more digit
-    // can be processed without overflowing.
-    uint64_t pre_max = uint_max / 10;
-    int dig_pre_max = uint_max % 10;
-
-    // Process the digits.
-    d = *p;
-    while (isdigit(d)) {
-        if ((number < pre_max) || ((number == pre_max) && (d - '0' <= dig_pre_max))) {
-            number = number * 10 + (d - '0');
-            d = *++p;
-        }
-        else {
-            return -1;
-        }
+#define DEFINE_STR_TO_INT64(type)                                       \
+    static NPY_INLINE int                                               \
+    str_to_int64_##type(                                                \
+            const type *p_item, const type *p_end,                      \
+            int64_t int_min, int64_t int_max, int64_t *result)          \
+    {                                                                   \
+        bool isneg;                                                     \
+        uint64_t number;                                                \
+        if (str_to_magnitude_##type(                                    \
+                p_item, p_end, false, &isneg, &number) < 0) {           \
+            return -1;                                                  \
+        }                                                               \
+        return int64_from_magnitude(                                    \
+                isneg, number, int_min, int_max, result);               \
     }
 
-    // Skip trailing spaces.
-    while (Py_UNICODE_ISSPACE(*p)) {
-        ++p;
-    }
 
-    // Did we use up all the characters?
-    if (p != p_end) {
-        return -1;
+#define DEFINE_STR_TO_UINT64(type)                                      \
+    static NPY_INLINE int                                               \
+    str_to_uint64_##type(                                               \
+            const type *p_item, const type *p_end,                      \
+            uint64_t uint_max, uint64_t *result)                        \
+    {                                                                   \
+        bool isneg;                                                     \
+        uint64_t number;                                                \
+        if (str_to_magnitude_##type(                                    \
+                p_item, p_end, false, &isneg, &number) < 0) {           \
+            return -1;                                                  \
+        }                                                               \
+        return uint64_from_magnitude(isneg, number, uint_max, result);  \
     }
 
-    *result = number;
-    return 0;
-}
+DEFINE_PARSE_DIGITS(Py_UCS1)
+DEFINE_PARSE_DIGITS(Py_UCS2)
+DEFINE_PARSE_DIGITS(Py_UCS4)
+DEFINE_STR_TO_MAGNITUDE(Py_UCS1)
+DEFINE_STR_TO_MAGNITUDE(Py_UCS2)
+DEFINE_STR_TO_MAGNITUDE(Py_UCS4)
+DEFINE_STR_TO_INT64(Py_UCS1)
+DEFINE_STR_TO_INT64(Py_UCS2)
+DEFINE_STR_TO_INT64(Py_UCS4)
+DEFINE_STR_TO_UINT64(Py_UCS1)
+DEFINE_STR_TO_UINT64(Py_UCS2)
+DEFINE_STR_TO_UINT64(Py_UCS4)
 
 
-#define DECLARE_TO_INT_PROTOTYPE(intw)                                  \
+#define DECLARE_TO_INT_PROTOTYPE(intw, type)                            \
     int                                                                 \
-    to_##intw(PyArray_Descr *descr,                                     \
-            const Py_UCS4 *str, const Py_UCS4 *end, char *dataptr,      \
+    to_##intw##_##type(PyArray_Descr *descr,                            \
+            const type *str, const type *end, char *dataptr,            \
             parser_config *pconfig);
 
-DECLARE_TO_INT_PROTOTYPE(int8)
-DECLARE_TO_INT_PROTOTYPE(int16)
-DECLARE_TO_INT_PROTOTYPE(int32)
-DECLARE_TO_INT_PROTOTYPE(int64)
+#define DECLARE_TO_INT_PROTOTYPES(type)                                 \
+    DECLARE_TO_INT_PROTOTYPE(int8, type)                                \
+    DECLARE_TO_INT_PROTOTYPE(int16, type)                               \
+    DECLARE_TO_INT_PROTOTYPE(int32, type)                               \
+    DECLARE_TO_INT_PROTOTYPE(int64, type)                               \
+                                                                        \
+    DECLARE_TO_INT_PROTOTYPE(uint8, type)                               \
+    DECLARE_TO_INT_PROTOTYPE(uint16, type)                              \
+    DECLARE_TO_INT_PROTOTYPE(uint32, type)                              \
+    DECLARE_TO_INT_PROTOTYPE(uint64, type)
 
-DECLARE_TO_INT_PROTOTYPE(uint8)
-DECLARE_TO_INT_PROTOTYPE(uint16)
-DECLARE_TO_INT_PROTOTYPE(uint32)
-DECLARE_TO_INT_PROTOTYPE(uint64)
+DECLARE_TO_INT_PROTOTYPES(Py_UCS1)
+DECLARE_TO_INT_PROTOTYPES(Py_UCS2)
+DECLARE_TO_INT_PROTOTYPES(Py_UCS4)
 
 #endif
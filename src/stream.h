@@ -19,11 +19,22 @@ typedef struct _stream {
     // Note that the first argument to stream_close is the stream pointer
     // itself, not the stream_data pointer.
     int (*stream_close)(struct _stream *strm);
+    // Optional (may be NULL), returns 1 and sets start and end if all data
+    // not yet returned by `stream_nextbuf` is available as one raw 1-byte
+    // kind (latin1 compatible) buffer, which is valid until the stream is
+    // closed.  The data is not consumed.  Returns 0 otherwise, also while
+    // a buffer returned by `stream_nextbuf` is not raw data (so that the
+    // data of the stream buffer being read is always raw if it returns 1).
+    // If it returned 1, `stream_nextbuf` does not need the GIL.
+    int (*stream_rawdata)(void *sdata, char **start, char **end);
 } stream;
 
 
 #define stream_nextbuf(s, start, end, kind)  \
         ((s)->stream_nextbuf((s)->stream_data, start, end, kind))
 #define stream_close(s)    ((s)->stream_close((s)))
+#define stream_rawdata(s, start, end)  \
+        ((s)->stream_rawdata != NULL &&  \
+         (s)->stream_rawdata((s)->stream_data, start, end))
 
 #endif
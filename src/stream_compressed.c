@@ -0,0 +1,730 @@
+/*
+ * C side stream reading a gzip, bz2 or xz compressed file directly (by path
+ * or file descriptor).  A helper thread reads and decompresses the file into
+ * a ring of `NUM_BUFFERS` buffers which the tokenizer consumes, so that the
+ * decompression overlaps with the parsing.  The decompressed bytes are
+ * handed out like the ones of `stream_native_file` (see `raw_bytes_nextbuf`).
+ *
+ * Which compressions are available depends on the libraries found when
+ * building (`HAVE_ZLIB`, `HAVE_BZLIB` and `HAVE_LZMA`).  If the helper thread
+ * cannot be started, the buffers are filled when they are needed instead.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#ifdef _WIN32
+    #include <io.h>
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <unistd.h>
+    #include <pthread.h>
+#endif
+
+#ifdef HAVE_ZLIB
+    #include <zlib.h>
+#endif
+#ifdef HAVE_BZLIB
+    #include <bzlib.h>
+#endif
+#ifdef HAVE_LZMA
+    #include <lzma.h>
+#endif
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL npreadtext_ARRAY_API
+#include "numpy/arrayobject.h"
+
+#include "stream.h"
+#include "stream_file.h"
+#include "stream_compressed.h"
+
+#define NUM_BUFFERS 4
+#define BUFFER_SIZE (1 << 20)
+#define INPUT_SIZE (1 << 16)
+/* The bytes of an incomplete utf-8 character moved to the next buffer */
+#define MAX_CARRY MAX_INCOMPLETE_CHAR_LENGTH
+
+
+typedef enum {
+    COMPRESSION_GZIP,
+    COMPRESSION_BZ2,
+    COMPRESSION_XZ,
+} compression_format;
+
+static const struct {
+    const char *name;
+    compression_format format;
+} compression_formats[] = {
+#ifdef HAVE_ZLIB
+    {"gzip", COMPRESSION_GZIP},
+#endif
+#ifdef HAVE_BZLIB
+    {"bz2", COMPRESSION_BZ2},
+#endif
+#ifdef HAVE_LZMA
+    {"xz", COMPRESSION_XZ},
+#endif
+    {NULL, 0},
+};
+
+
+/* Result of a decompression step */
+typedef enum {
+    STEP_OK,
+    STEP_STREAM_END,
+    STEP_ERROR,
+} step_result;
+
+
+typedef struct {
+    int fd;
+    bool owns_fd;
+
+    /* The decompressor and its input, used only by the filling thread */
+    compression_format format;
+    union {
+#ifdef HAVE_ZLIB
+        z_stream z;
+#endif
+#ifdef HAVE_BZLIB
+        bz_stream bz;
+#endif
+#ifdef HAVE_LZMA
+        lzma_stream xz;
+#endif
+        char unused;
+    } strm;
+    bool strm_initialized;
+    /* Whether a (gzip or bz2) member was started and a new one must be */
+    bool member_started;
+    bool needs_reset;
+    char *input;
+    char *in_next;
+    size_t in_avail;
+    bool input_eof;
+    /* The end of the current buffer which must go into the next one */
+    char carry[MAX_CARRY];
+    size_t carry_length;
+
+    /*
+     * The ring of buffers.  `num_filled` buffers starting at `read_index`
+     * are ready, `finished` is set once the last one was filled (and
+     * `error` if that failed).  Protected by the mutex.
+     */
+    char *buffers[NUM_BUFFERS];
+    size_t lengths[NUM_BUFFERS];
+    int read_index;
+    int num_filled;
+    bool finished;
+    bool stop;
+    PyObject *error_type;  /* borrowed exception class */
+    const char *error;
+    int error_errno;
+
+#ifdef _WIN32
+    SRWLOCK mutex;
+    CONDITION_VARIABLE filled;
+    CONDITION_VARIABLE freed;
+    HANDLE thread;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t filled;
+    pthread_cond_t freed;
+    pthread_t thread;
+#endif
+    bool sync_initialized;
+    bool thread_started;
+
+    /* The consumer side, the buffer at `read_index` is used if `pos` set */
+    char *pos;
+    char *end;
+    bool raw_bytes;
+    const char *encoding;
+    PyObject *chunk;
+} compressed_file;
+
+
+#ifdef _WIN32
+static void lock(compressed_file *cf) { AcquireSRWLockExclusive(&cf->mutex); }
+static void unlock(compressed_file *cf) { ReleaseSRWLockExclusive(&cf->mutex); }
+static void wait_filled(compressed_file *cf) {
+    SleepConditionVariableSRW(&cf->filled, &cf->mutex, INFINITE, 0);
+}
+static void wait_freed(compressed_file *cf) {
+    SleepConditionVariableSRW(&cf->freed, &cf->mutex, INFINITE, 0);
+}
+static void signal_filled(compressed_file *cf) {
+    WakeConditionVariable(&cf->filled);
+}
+static void signal_freed(compressed_file *cf) {
+    WakeConditionVariable(&cf->freed);
+}
+#else
+static void lock(compressed_file *cf) { pthread_mutex_lock(&cf->mutex); }
+static void unlock(compressed_file *cf) { pthread_mutex_unlock(&cf->mutex); }
+static void wait_filled(compressed_file *cf) {
+    pthread_cond_wait(&cf->filled, &cf->mutex);
+}
+static void wait_freed(compressed_file *cf) {
+    pthread_cond_wait(&cf->freed, &cf->mutex);
+}
+static void signal_filled(compressed_file *cf) {
+    pthread_cond_signal(&cf->filled);
+}
+static void signal_freed(compressed_file *cf) {
+    pthread_cond_signal(&cf->freed);
+}
+#endif
+
+
+/*
+ * Initialize (or reset for the next gzip or bz2 member) the decompressor.
+ * Returns -1 on failure.
+ */
+static int
+decompressor_init(compressed_file *cf)
+{
+    switch (cf->format) {
+#ifdef HAVE_ZLIB
+        case COMPRESSION_GZIP:
+            if (cf->strm_initialized) {
+                return inflateReset(&cf->strm.z) == Z_OK ? 0 : -1;
+            }
+            /* Decode gzip and zlib headers */
+            if (inflateInit2(&cf->strm.z, 15 + 32) != Z_OK) {
+                return -1;
+            }
+            break;
+#endif
+#ifdef HAVE_BZLIB
+        case COMPRESSION_BZ2:
+            if (cf->strm_initialized) {
+                BZ2_bzDecompressEnd(&cf->strm.bz);
+                cf->strm_initialized = false;
+            }
+            if (BZ2_bzDecompressInit(&cf->strm.bz, 0, 0) != BZ_OK) {
+                return -1;
+            }
+            break;
+#endif
+#ifdef HAVE_LZMA
+        case COMPRESSION_XZ:
+            /* xz and legacy lzma files, concatenated streams are read */
+            if (lzma_auto_decoder(&cf->strm.xz,
+                    UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+                return -1;
+            }
+            break;
+#endif
+        default:
+            return -1;
+    }
+    cf->strm_initialized = true;
+    return 0;
+}
+
+
+static void
+decompressor_end(compressed_file *cf)
+{
+    if (!cf->strm_initialized) {
+        return;
+    }
+    switch (cf->format) {
+#ifdef HAVE_ZLIB
+        case COMPRESSION_GZIP:
+            inflateEnd(&cf->strm.z);
+            break;
+#endif
+#ifdef HAVE_BZLIB
+        case COMPRESSION_BZ2:
+            BZ2_bzDecompressEnd(&cf->strm.bz);
+            break;
+#endif
+#ifdef HAVE_LZMA
+        case COMPRESSION_XZ:
+            lzma_end(&cf->strm.xz);
+            break;
+#endif
+        default:
+            break;
+    }
+    cf->strm_initialized = false;
+}
+
+
+/*
+ * Decompress the available input into `[*out, *out + *avail)`, advancing
+ * both.  `*avail` and the input are small enough for all libraries.
+ */
+static step_result
+decompressor_step(compressed_file *cf, char **out, size_t *avail)
+{
+    switch (cf->format) {
+#ifdef HAVE_ZLIB
+        case COMPRESSION_GZIP: {
+            z_stream *z = &cf->strm.z;
+            z->next_in = (Bytef *)cf->in_next;
+            z->avail_in = (uInt)cf->in_avail;
+            z->next_out = (Bytef *)*out;
+            z->avail_out = (uInt)*avail;
+            int ret = inflate(z, Z_NO_FLUSH);
+            cf->in_next = (char *)z->next_in;
+            cf->in_avail = z->avail_in;
+            *out = (char *)z->next_out;
+            *avail = z->avail_out;
+            if (ret == Z_STREAM_END) {
+                return STEP_STREAM_END;
+            }
+            return ret == Z_OK || ret == Z_BUF_ERROR ? STEP_OK : STEP_ERROR;
+        }
+#endif
+#ifdef HAVE_BZLIB
+        case COMPRESSION_BZ2: {
+            bz_stream *bz = &cf->strm.bz;
+            bz->next_in = cf->in_next;
+            bz->avail_in = (unsigned int)cf->in_avail;
+            bz->next_out = *out;
+            bz->avail_out = (unsigned int)*avail;
+            int ret = BZ2_bzDecompress(bz);
+            cf->in_next = bz->next_in;
+            cf->in_avail = bz->avail_in;
+            *out = bz->next_out;
+            *avail = bz->avail_out;
+            if (ret == BZ_STREAM_END) {
+                return STEP_STREAM_END;
+            }
+            return ret == BZ_OK ? STEP_OK : STEP_ERROR;
+        }
+#endif
+#ifdef HAVE_LZMA
+        case COMPRESSION_XZ: {
+            lzma_stream *xz = &cf->strm.xz;
+            xz->next_in = (const uint8_t *)cf->in_next;
+            xz->avail_in = cf->in_avail;
+            xz->next_out = (uint8_t *)*out;
+            xz->avail_out = *avail;
+            lzma_ret ret = lzma_code(
+                    xz, cf->input_eof ? LZMA_FINISH : LZMA_RUN);
+            cf->in_next = (char *)xz->next_in;
+            cf->in_avail = xz->avail_in;
+            *out = (char *)xz->next_out;
+            *avail = xz->avail_out;
+            if (ret == LZMA_STREAM_END) {
+                return STEP_STREAM_END;
+            }
+            return ret == LZMA_OK || ret == LZMA_BUF_ERROR ?
+                    STEP_OK : STEP_ERROR;
+        }
+#endif
+        default:
+            return STEP_ERROR;
+    }
+}
+
+
+/*
+ * Record the error of the filling thread, it is raised by the consumer.
+ */
+static int
+fill_error(compressed_file *cf, PyObject *type, const char *message)
+{
+    cf->error_type = type;
+    cf->error = message;
+    return -1;
+}
+
+
+static int
+read_input(compressed_file *cf)
+{
+    while (1) {
+        Py_ssize_t n = read(cf->fd, cf->input, INPUT_SIZE);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            cf->error_errno = errno;
+            return fill_error(cf, PyExc_OSError, NULL);
+        }
+        cf->in_next = cf->input;
+        cf->in_avail = (size_t)n;
+        cf->input_eof = n == 0;
+        return 0;
+    }
+}
+
+
+/*
+ * Decompress up to `size` bytes into `out`.  Returns 1 at the end of the
+ * data, 0 if the buffer is full and -1 on error (see `fill_error`).  Does
+ * not use the Python API.
+ */
+static int
+decompress(compressed_file *cf, char *out, size_t size, size_t *length)
+{
+    char *pos = out;
+    size_t avail = size;
+    int res = 0;
+    while (avail > 0) {
+        if (cf->in_avail == 0 && !cf->input_eof) {
+            if (read_input(cf) < 0) {
+                res = -1;
+                break;
+            }
+        }
+        if (cf->in_avail == 0 && cf->input_eof && !cf->member_started) {
+            res = 1;  /* also an empty file */
+            break;
+        }
+        if (cf->needs_reset) {
+            if (decompressor_init(cf) < 0) {
+                res = fill_error(cf, PyExc_MemoryError,
+                        "could not reset the decompressor");
+                break;
+            }
+            cf->needs_reset = false;
+        }
+        cf->member_started = true;
+
+        size_t avail_before = avail;
+        step_result step = decompressor_step(cf, &pos, &avail);
+        if (step == STEP_ERROR) {
+            res = fill_error(cf, PyExc_OSError,
+                    "invalid or corrupted compressed data");
+            break;
+        }
+        else if (step == STEP_STREAM_END) {
+            /* A new (gzip or bz2) member may follow */
+            cf->member_started = false;
+            cf->needs_reset = true;
+        }
+        else if (avail == avail_before && cf->in_avail == 0
+                    && cf->input_eof) {
+            res = fill_error(cf, PyExc_EOFError,
+                    "Compressed file ended before the end-of-stream marker "
+                    "was reached");
+            break;
+        }
+    }
+    *length = pos - out;
+    return res;
+}
+
+
+/*
+ * Fill the buffer at `index`, returns true if it is the last one.
+ */
+static bool
+fill_buffer(compressed_file *cf, int index)
+{
+    char *buf = cf->buffers[index];
+    memcpy(buf, cf->carry, cf->carry_length);
+    size_t length;
+    int res = decompress(cf, buf + cf->carry_length, BUFFER_SIZE, &length);
+    length += cf->carry_length;
+    cf->carry_length = 0;
+    if (res <= 0 && !cf->raw_bytes) {
+        /* (if decompression failed, the last character is dropped) */
+        cf->carry_length = incomplete_char_length(buf, length);
+        length -= cf->carry_length;
+        memcpy(cf->carry, buf + length, cf->carry_length);
+    }
+
+    lock(cf);
+    cf->lengths[index] = length;
+    cf->num_filled++;
+    cf->finished = res != 0;
+    signal_filled(cf);
+    unlock(cf);
+    return res != 0;
+}
+
+
+static void
+fill_buffers(compressed_file *cf)
+{
+    int index = 0;
+    while (1) {
+        lock(cf);
+        while (cf->num_filled == NUM_BUFFERS && !cf->stop) {
+            wait_freed(cf);
+        }
+        bool stop = cf->stop;
+        unlock(cf);
+        if (stop || fill_buffer(cf, index)) {
+            return;
+        }
+        index = (index + 1) % NUM_BUFFERS;
+    }
+}
+
+
+#ifdef _WIN32
+static unsigned __stdcall
+thread_main(void *arg)
+{
+    fill_buffers((compressed_file *)arg);
+    return 0;
+}
+#else
+static void *
+thread_main(void *arg)
+{
+    fill_buffers((compressed_file *)arg);
+    return NULL;
+}
+#endif
+
+
+/*
+ * Release the current buffer and wait for the next one.  Returns 1 at the
+ * end of the data and -1 with an error set on error.  Needs the GIL.
+ */
+static int
+next_buffer(compressed_file *cf)
+{
+    bool wait = false;
+
+    lock(cf);
+    if (cf->pos != NULL) {
+        cf->pos = NULL;
+        cf->read_index = (cf->read_index + 1) % NUM_BUFFERS;
+        cf->num_filled--;
+        signal_freed(cf);
+    }
+    wait = cf->num_filled == 0 && !cf->finished;
+    unlock(cf);
+
+    if (wait && !cf->thread_started) {
+        /* There is no helper thread, fill the (empty) ring here */
+        Py_BEGIN_ALLOW_THREADS;
+        fill_buffer(cf, cf->read_index);
+        Py_END_ALLOW_THREADS;
+    }
+    else if (wait) {
+        Py_BEGIN_ALLOW_THREADS;
+        lock(cf);
+        while (cf->num_filled == 0 && !cf->finished) {
+            wait_filled(cf);
+        }
+        unlock(cf);
+        Py_END_ALLOW_THREADS;
+    }
+
+    /* The filling thread only changes the counts and flags */
+    lock(cf);
+    int num_filled = cf->num_filled;
+    unlock(cf);
+    if (num_filled > 0) {
+        cf->pos = cf->buffers[cf->read_index];
+        cf->end = cf->pos + cf->lengths[cf->read_index];
+        return 0;
+    }
+    if (cf->error_type == NULL) {
+        return 1;
+    }
+    if (cf->error == NULL) {
+        errno = cf->error_errno;
+        PyErr_SetFromErrno(cf->error_type);
+    }
+    else {
+        PyErr_SetString(cf->error_type, cf->error);
+    }
+    return -1;
+}
+
+
+static int
+cf_nextbuf(compressed_file *cf, char **start, char **end, int *kind)
+{
+    Py_CLEAR(cf->chunk);
+
+    while (cf->pos == NULL || cf->pos == cf->end) {
+        int res = next_buffer(cf);
+        if (res < 0) {
+            return -1;
+        }
+        else if (res > 0) {
+            *start = cf->input;
+            *end = cf->input;
+            *kind = PyUnicode_1BYTE_KIND;
+            return BUFFER_IS_FILEEND;
+        }
+    }
+    return raw_bytes_nextbuf(&cf->pos, cf->end, cf->raw_bytes,
+            cf->encoding, &cf->chunk, start, end, kind);
+}
+
+
+static int
+cf_del(stream *strm)
+{
+    compressed_file *cf = (compressed_file *)strm->stream_data;
+
+    if (cf->thread_started) {
+        lock(cf);
+        cf->stop = true;
+        signal_freed(cf);
+        unlock(cf);
+        Py_BEGIN_ALLOW_THREADS;
+#ifdef _WIN32
+        WaitForSingleObject(cf->thread, INFINITE);
+        CloseHandle(cf->thread);
+#else
+        pthread_join(cf->thread, NULL);
+#endif
+        Py_END_ALLOW_THREADS;
+    }
+#ifndef _WIN32
+    if (cf->sync_initialized) {
+        pthread_mutex_destroy(&cf->mutex);
+        pthread_cond_destroy(&cf->filled);
+        pthread_cond_destroy(&cf->freed);
+    }
+#endif
+    Py_XDECREF(cf->chunk);
+    decompressor_end(cf);
+    for (int i = 0; i < NUM_BUFFERS; i++) {
+        PyMem_RawFree(cf->buffers[i]);
+    }
+    PyMem_RawFree(cf->input);
+    if (cf->owns_fd && cf->fd >= 0) {
+        close(cf->fd);
+    }
+
+    free(cf);
+    free(strm);
+
+    return 0;
+}
+
+
+PyObject *
+compressed_stream_formats(void)
+{
+    Py_ssize_t num = sizeof(compression_formats)
+            / sizeof(compression_formats[0]) - 1;
+    PyObject *names = PyTuple_New(num);
+    if (names == NULL) {
+        return NULL;
+    }
+    for (Py_ssize_t i = 0; i < num; i++) {
+        PyObject *name = PyUnicode_FromString(compression_formats[i].name);
+        if (name == NULL) {
+            Py_DECREF(names);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(names, i, name);
+    }
+    return names;
+}
+
+
+stream *
+stream_compressed_file(
+        PyObject *file, const char *encoding, const char *compression)
+{
+    compressed_file *cf;
+    stream *strm;
+
+    bool raw_bytes;
+    if (native_encoding_check(encoding, &raw_bytes) < 0) {
+        return NULL;
+    }
+    int i = 0;
+    while (compression_formats[i].name != NULL
+            && strcmp(compression_formats[i].name, compression) != 0) {
+        i++;
+    }
+    if (compression_formats[i].name == NULL) {
+        PyErr_Format(PyExc_ValueError,
+                "internal error: compression %s not supported for native "
+                "file reading.", compression);
+        return NULL;
+    }
+
+    cf = (compressed_file *)malloc(sizeof(compressed_file));
+    if (cf == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    memset(cf, 0, sizeof(compressed_file));
+    cf->fd = -1;
+    cf->format = compression_formats[i].format;
+    cf->raw_bytes = raw_bytes;
+    cf->encoding = encoding;
+
+    strm = (stream *)malloc(sizeof(stream));
+    if (strm == NULL) {
+        PyErr_NoMemory();
+        free(cf);
+        return NULL;
+    }
+    strm->stream_data = (void *)cf;
+    strm->stream_nextbuf = (void *)&cf_nextbuf;
+    strm->stream_close = &cf_del;
+    strm->stream_rawdata = NULL;
+
+    cf->input = PyMem_RawMalloc(INPUT_SIZE);
+    if (cf->input == NULL) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+    for (i = 0; i < NUM_BUFFERS; i++) {
+        cf->buffers[i] = PyMem_RawMalloc(BUFFER_SIZE + MAX_CARRY);
+        if (cf->buffers[i] == NULL) {
+            PyErr_NoMemory();
+            goto fail;
+        }
+    }
+    if (decompressor_init(cf) < 0) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+
+    cf->fd = native_file_open(file, &cf->owns_fd);
+    if (cf->fd < 0) {
+        goto fail;
+    }
+
+#ifdef _WIN32
+    InitializeSRWLock(&cf->mutex);
+    InitializeConditionVariable(&cf->filled);
+    InitializeConditionVariable(&cf->freed);
+    cf->sync_initialized = true;
+    cf->thread = (HANDLE)_beginthreadex(NULL, 0, &thread_main, cf, 0, NULL);
+    cf->thread_started = cf->thread != 0;
+#else
+    if (pthread_mutex_init(&cf->mutex, NULL) != 0) {
+        PyErr_NoMemory();
+        goto fail;
+    }
+    if (pthread_cond_init(&cf->filled, NULL) != 0) {
+        pthread_mutex_destroy(&cf->mutex);
+        PyErr_NoMemory();
+        goto fail;
+    }
+    if (pthread_cond_init(&cf->freed, NULL) != 0) {
+        pthread_mutex_destroy(&cf->mutex);
+        pthread_cond_destroy(&cf->filled);
+        PyErr_NoMemory();
+        goto fail;
+    }
+    cf->sync_initialized = true;
+    cf->thread_started = pthread_create(
+            &cf->thread, NULL, &thread_main, cf) == 0;
+#endif
+    return strm;
+
+fail:
+    cf_del(strm);
+    return NULL;
+}
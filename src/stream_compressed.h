@@ -0,0 +1,26 @@
+#ifndef _STREAM_COMPRESSED_H_
+#define _STREAM_COMPRESSED_H_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "stream.h"
+
+/*
+ * Open the compressed `file` (a path or file descriptor, see
+ * `stream_native_file`), which is decompressed on a helper thread.
+ * `compression` is one of the names returned by
+ * `compressed_stream_formats`.
+ */
+stream *
+stream_compressed_file(
+        PyObject *file, const char *encoding, const char *compression);
+
+/*
+ * Returns a new tuple with the names of the compressions supported by this
+ * build ("gzip", "bz2" and "xz" if the libraries were found).
+ */
+PyObject *
+compressed_stream_formats(void);
+
+#endif
@@ -0,0 +1,574 @@
+/*
+ * C side stream reading a file directly (by path or file descriptor),
+ * bypassing the Python file object, its `read()` calls and the per-chunk
+ * decoding.  Regular files are memory mapped, anything else (pipes, special
+ * files) is read fully into memory.
+ *
+ * The tokenizer is handed the raw bytes as a `PyUnicode_1BYTE_KIND` buffer.
+ * This is exact for latin1 (where bytes and code points coincide) and for
+ * every ASCII character.  For ASCII compatible encodings (utf-8, ascii) only
+ * the non-ASCII parts of the file are decoded through Python in windows of
+ * `DECODE_CHUNKSIZE` bytes (ASCII bytes are always character boundaries for
+ * these encodings), so that pure ASCII files are never copied.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#ifdef _WIN32
+    #include <io.h>
+    #include <windows.h>
+#else
+    #include <unistd.h>
+    #include <sys/mman.h>
+#endif
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL npreadtext_ARRAY_API
+#include "numpy/arrayobject.h"
+
+#include "stream.h"
+#include "stream_file.h"
+
+#define DECODE_CHUNKSIZE (1 << 20)
+#define READ_CHUNKSIZE (1 << 16)
+
+
+typedef struct {
+    /* The file descriptor and whether we opened it (and must close it) */
+    int fd;
+    bool owns_fd;
+
+    /* Start and size of the mapped (or allocated) file contents */
+    char *data;
+    size_t size;
+    bool is_mapped;
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+
+    /* The next unread byte and the end of the file contents */
+    char *pos;
+    char *end;
+
+    /*
+     * If true all bytes are handed out unmodified (latin1), otherwise
+     * non-ASCII parts are decoded using `encoding`.
+     */
+    bool raw_bytes;
+    const char *encoding;
+
+    /* Python str object holding the most recently decoded window. */
+    PyObject *chunk;
+
+    /* Set once the remaining data was found to be pure ASCII */
+    bool rest_is_ascii;
+    /*
+     * The first non-ASCII byte at or after `pos` found by `nf_rawdata`
+     * (NULL if not searched yet), only searched again once `pos` passed it.
+     */
+    char *next_non_ascii;
+} native_file;
+
+
+static NPY_INLINE bool
+encoding_is_latin1(const char *encoding)
+{
+    static const char *aliases[] = {
+            "latin1", "latin-1", "latin_1", "iso8859-1", "iso-8859-1",
+            "iso8859_1", "l1", NULL};
+    for (const char **alias = aliases; *alias != NULL; alias++) {
+        if (PyOS_stricmp(encoding, *alias) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+static NPY_INLINE bool
+encoding_is_ascii_compatible(const char *encoding)
+{
+    static const char *aliases[] = {
+            "utf-8", "utf8", "utf_8", "ascii", "us-ascii", NULL};
+    for (const char **alias = aliases; *alias != NULL; alias++) {
+        if (PyOS_stricmp(encoding, *alias) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/*
+ * Find the first byte which is not ASCII, checking 8 bytes at a time.
+ */
+static NPY_INLINE char *
+find_non_ascii(char *pos, char *end)
+{
+    while (end - pos >= 8) {
+        uint64_t word;
+        memcpy(&word, pos, 8);
+        if (word & 0x8080808080808080ULL) {
+            break;
+        }
+        pos += 8;
+    }
+    while (pos < end && !((unsigned char)*pos & 0x80)) {
+        pos++;
+    }
+    return pos;
+}
+
+
+int
+native_encoding_check(const char *encoding, bool *raw_bytes)
+{
+    if (encoding == NULL) {
+        PyErr_SetString(PyExc_ValueError,
+                "internal error: native file reading requires an encoding.");
+        return -1;
+    }
+    *raw_bytes = encoding_is_latin1(encoding);
+    if (!*raw_bytes && !encoding_is_ascii_compatible(encoding)) {
+        PyErr_Format(PyExc_ValueError,
+                "internal error: encoding %s not supported for native "
+                "file reading.", encoding);
+        return -1;
+    }
+    return 0;
+}
+
+
+int
+raw_bytes_nextbuf(char **pos, char *end, bool raw_bytes,
+        const char *encoding, PyObject **chunk,
+        char **buf_start, char **buf_end, int *kind)
+{
+    char *stop = end;
+    if (!raw_bytes) {
+        stop = find_non_ascii(*pos, end);
+    }
+    if (stop != *pos) {
+        /* Hand out the (ASCII or latin1) bytes without any copy */
+        *buf_start = *pos;
+        *buf_end = stop;
+        *kind = PyUnicode_1BYTE_KIND;
+        *pos = stop;
+        return BUFFER_MAY_CONTAIN_NEWLINE;
+    }
+
+    /* Decode a window that starts and ends on a character boundary */
+    stop = *pos + DECODE_CHUNKSIZE;
+    if (stop >= end) {
+        stop = end;
+    }
+    while (stop < end && ((unsigned char)*stop & 0x80)) {
+        stop++;
+    }
+    *chunk = PyUnicode_Decode(*pos, stop - *pos, encoding, NULL);
+    if (*chunk == NULL) {
+        return -1;
+    }
+    *pos = stop;
+
+    Py_ssize_t length = PyUnicode_GET_LENGTH(*chunk);
+    *kind = PyUnicode_KIND(*chunk);
+    *buf_start = (char *)PyUnicode_DATA(*chunk);
+    *buf_end = *buf_start + length * *kind;
+    return BUFFER_MAY_CONTAIN_NEWLINE;
+}
+
+
+size_t
+incomplete_char_length(const char *start, size_t length)
+{
+    size_t n = 0;
+    while (n < length && n < MAX_INCOMPLETE_CHAR_LENGTH
+            && ((unsigned char)start[length - 1 - n] & 0xC0) == 0x80) {
+        n++;
+    }
+    if (n == length) {
+        return 0;
+    }
+    unsigned char lead = (unsigned char)start[length - 1 - n];
+    size_t needed = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    return n + 1 < needed ? n + 1 : 0;
+}
+
+
+static int
+nf_nextbuf(native_file *nf, char **start, char **end, int *kind)
+{
+    Py_CLEAR(nf->chunk);
+
+    if (nf->pos == nf->end) {
+        *start = nf->end;
+        *end = nf->end;
+        *kind = PyUnicode_1BYTE_KIND;
+        return BUFFER_IS_FILEEND;
+    }
+    return raw_bytes_nextbuf(&nf->pos, nf->end, nf->raw_bytes,
+            nf->encoding, &nf->chunk, start, end, kind);
+}
+
+
+static int
+nf_rawdata(native_file *nf, char **start, char **end)
+{
+    if (nf->chunk != NULL) {
+        /*
+         * The tokenizer may still be reading the decoded chunk and the next
+         * `nf_nextbuf` has to release it, which needs the GIL.
+         */
+        return 0;
+    }
+    if (!nf->raw_bytes && !nf->rest_is_ascii) {
+        if (nf->next_non_ascii == NULL || nf->next_non_ascii < nf->pos) {
+            nf->next_non_ascii = find_non_ascii(nf->pos, nf->end);
+        }
+        if (nf->next_non_ascii != nf->end) {
+            return 0;
+        }
+        nf->rest_is_ascii = true;
+    }
+    *start = nf->pos;
+    *end = nf->end;
+    return 1;
+}
+
+
+static int
+nf_del(stream *strm)
+{
+    native_file *nf = (native_file *)strm->stream_data;
+
+    Py_XDECREF(nf->chunk);
+    if (nf->is_mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile(nf->data);
+        CloseHandle(nf->mapping);
+#else
+        munmap(nf->data, nf->size);
+#endif
+    }
+    else {
+        PyMem_RawFree(nf->data);
+    }
+    if (nf->owns_fd && nf->fd >= 0) {
+        close(nf->fd);
+    }
+
+    free(nf);
+    free(strm);
+
+    return 0;
+}
+
+
+/*
+ * Map the whole file into memory, this only works for (non-empty) regular
+ * files.  Returns 0 if mapping is not possible (without error).
+ */
+static int
+nf_map(native_file *nf, size_t size)
+{
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(nf->fd);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+    nf->mapping = CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (nf->mapping == NULL) {
+        return 0;
+    }
+    nf->data = MapViewOfFile(nf->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (nf->data == NULL) {
+        CloseHandle(nf->mapping);
+        return 0;
+    }
+#else
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, nf->fd, 0);
+    if (data == MAP_FAILED) {
+        return 0;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(data, size, MADV_SEQUENTIAL);
+#endif
+    nf->data = data;
+#endif
+    nf->size = size;
+    nf->is_mapped = true;
+    return 1;
+}
+
+
+/*
+ * Fallback for files that cannot be mapped: read everything into memory.
+ */
+static int
+nf_read_all(native_file *nf)
+{
+    size_t allocated = 0;
+    size_t size = 0;
+
+    while (1) {
+        if (allocated - size < READ_CHUNKSIZE) {
+            allocated = allocated * 2 + READ_CHUNKSIZE;
+            char *grown = PyMem_RawRealloc(nf->data, allocated);
+            if (grown == NULL) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            nf->data = grown;
+        }
+        Py_ssize_t n;
+        Py_BEGIN_ALLOW_THREADS;
+        n = read(nf->fd, nf->data + size, (unsigned int)(allocated - size));
+        Py_END_ALLOW_THREADS;
+        if (n < 0) {
+            if (errno == EINTR) {
+                if (PyErr_CheckSignals() < 0) {
+                    return -1;
+                }
+                continue;
+            }
+            PyErr_SetFromErrno(PyExc_OSError);
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        size += n;
+    }
+    nf->size = size;
+    return 0;
+}
+
+
+int
+native_file_open(PyObject *file, bool *owns_fd)
+{
+    int fd = -1;
+    if (PyLong_Check(file)) {
+        long value = PyLong_AsLong(file);
+        if (value == -1 && PyErr_Occurred()) {
+            return -1;
+        }
+        if (value < 0 || value > INT_MAX) {
+            PyErr_SetString(PyExc_ValueError, "invalid file descriptor.");
+            return -1;
+        }
+        *owns_fd = false;
+        return (int)value;
+    }
+#ifdef _WIN32
+    PyObject *path = NULL;
+    if (!PyUnicode_FSDecoder(file, &path)) {
+        return -1;
+    }
+    wchar_t *wpath = PyUnicode_AsWideCharString(path, NULL);
+    if (wpath == NULL) {
+        Py_DECREF(path);
+        return -1;
+    }
+    Py_BEGIN_ALLOW_THREADS;
+    fd = _wopen(wpath, _O_RDONLY | _O_BINARY);
+    Py_END_ALLOW_THREADS;
+    PyMem_Free(wpath);
+#else
+    PyObject *path = NULL;
+    if (!PyUnicode_FSConverter(file, &path)) {
+        return -1;
+    }
+    Py_BEGIN_ALLOW_THREADS;
+    fd = open(PyBytes_AS_STRING(path), O_RDONLY);
+    Py_END_ALLOW_THREADS;
+#endif
+    if (fd < 0) {
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path);
+        Py_DECREF(path);
+        return -1;
+    }
+    Py_DECREF(path);
+    *owns_fd = true;
+    return fd;
+}
+
+
+/*
+ * Open `file` which must be a path (str, bytes or `os.PathLike`) or an
+ * integer file descriptor.  File descriptors are read starting at their
+ * current position and are not closed.
+ */
+stream *
+stream_native_file(PyObject *file, const char *encoding)
+{
+    native_file *nf;
+    stream *strm;
+
+    bool raw_bytes;
+    if (native_encoding_check(encoding, &raw_bytes) < 0) {
+        return NULL;
+    }
+
+    nf = (native_file *)malloc(sizeof(native_file));
+    if (nf == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    memset(nf, 0, sizeof(native_file));
+    nf->fd = -1;
+    nf->raw_bytes = raw_bytes;
+    nf->encoding = encoding;
+
+    strm = (stream *)malloc(sizeof(stream));
+    if (strm == NULL) {
+        PyErr_NoMemory();
+        free(nf);
+        return NULL;
+    }
+    strm->stream_data = (void *)nf;
+    strm->stream_nextbuf = (void *)&nf_nextbuf;
+    strm->stream_close = &nf_del;
+    strm->stream_rawdata = (void *)&nf_rawdata;
+
+    off_t offset = 0;
+    nf->fd = native_file_open(file, &nf->owns_fd);
+    if (nf->fd < 0) {
+        goto fail;
+    }
+    if (!nf->owns_fd) {
+        offset = lseek(nf->fd, 0, SEEK_CUR);
+        if (offset < 0) {
+            /* Not seekable (e.g. a pipe), just read from where we are */
+            offset = 0;
+        }
+    }
+
+    struct stat st;
+    if (fstat(nf->fd, &st) < 0) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        goto fail;
+    }
+    if (S_ISREG(st.st_mode) && st.st_size > 0
+            && (uint64_t)st.st_size <= (uint64_t)PY_SSIZE_T_MAX
+            && nf_map(nf, (size_t)st.st_size)) {
+        if (offset > st.st_size) {
+            offset = st.st_size;
+        }
+    }
+    else {
+        /* the (remaining) file is read fully, starting at offset */
+        offset = 0;
+        if (nf_read_all(nf) < 0) {
+            goto fail;
+        }
+    }
+
+    nf->pos = nf->data + offset;
+    nf->end = nf->data + nf->size;
+
+    return strm;
+
+fail:
+    nf_del(strm);
+    return NULL;
+}
+
+
+void
+stream_native_file_bytes(stream *strm, char **start, char **end)
+{
+    native_file *nf = (native_file *)strm->stream_data;
+    *start = nf->pos;
+    *end = nf->end;
+}
+
+
+void
+stream_native_file_skip_to(stream *strm, char *pos)
+{
+    native_file *nf = (native_file *)strm->stream_data;
+    assert(nf->chunk == NULL && pos >= nf->pos && pos <= nf->end);
+    nf->pos = pos;
+}
+
+
+/*
+ * Stream over a raw 1-byte kind (latin1 compatible) buffer which must stay
+ * valid while the stream is used.  Does not use the Python API, so that it
+ * can be used without holding the GIL.
+ */
+typedef struct {
+    char *pos;
+    char *end;
+} memory_buffer;
+
+
+static int
+mb_nextbuf(memory_buffer *mb, char **start, char **end, int *kind)
+{
+    *start = mb->pos;
+    *end = mb->end;
+    *kind = PyUnicode_1BYTE_KIND;
+    if (mb->pos == mb->end) {
+        return BUFFER_IS_FILEEND;
+    }
+    mb->pos = mb->end;
+    return BUFFER_MAY_CONTAIN_NEWLINE;
+}
+
+
+static int
+mb_rawdata(memory_buffer *mb, char **start, char **end)
+{
+    *start = mb->pos;
+    *end = mb->end;
+    return 1;
+}
+
+
+static int
+mb_del(stream *strm)
+{
+    free(strm->stream_data);
+    free(strm);
+    return 0;
+}
+
+
+/*
+ * Note that this returns NULL without an error set if allocation fails.
+ */
+stream *
+stream_memory(const char *start, const char *end)
+{
+    memory_buffer *mb = malloc(sizeof(memory_buffer));
+    if (mb == NULL) {
+        return NULL;
+    }
+    stream *strm = malloc(sizeof(stream));
+    if (strm == NULL) {
+        free(mb);
+        return NULL;
+    }
+    mb->pos = (char *)start;
+    mb->end = (char *)end;
+
+    strm->stream_data = (void *)mb;
+    strm->stream_nextbuf = (void *)&mb_nextbuf;
+    strm->stream_close = &mb_del;
+    strm->stream_rawdata = (void *)&mb_rawdata;
+    return strm;
+}
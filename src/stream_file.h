@@ -0,0 +1,74 @@
+
+#ifndef _STREAM_FILE_H_
+#define _STREAM_FILE_H_
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdbool.h>
+
+#include "stream.h"
+
+stream *
+stream_native_file(PyObject *file, const char *encoding);
+
+/*
+ * The bytes of a stream returned by `stream_native_file` which were not
+ * read yet.  They are not decoded, but all native encodings are ASCII
+ * compatible, so that e.g. line ends can be found in them.
+ */
+void
+stream_native_file_bytes(stream *strm, char **start, char **end);
+
+/*
+ * Continue reading the (unread) stream at `pos` within the bytes returned
+ * by `stream_native_file_bytes`, which must be the start of a line.
+ */
+void
+stream_native_file_skip_to(stream *strm, char *pos);
+
+/*
+ * Helpers shared with the other streams reading files natively.
+ */
+
+/*
+ * Open `file` (a path or an integer file descriptor) for reading, sets
+ * `*owns_fd` if the file descriptor must be closed.  Returns the file
+ * descriptor or -1 with an error set.
+ */
+int
+native_file_open(PyObject *file, bool *owns_fd);
+
+/*
+ * Check that `encoding` can be read natively; `*raw_bytes` is set if all
+ * bytes are handed out unmodified (latin1).  Returns -1 with an error set
+ * if not.
+ */
+int
+native_encoding_check(const char *encoding, bool *raw_bytes);
+
+/*
+ * Return the next buffer of the bytes in `[*pos, end)` (which must not be
+ * empty) and advance `*pos`.  ASCII (with `raw_bytes` all) bytes are handed
+ * out as they are, otherwise a window is decoded into `*chunk` (which
+ * must be cleared before the next call).  `end` must not cut a character.
+ */
+int
+raw_bytes_nextbuf(char **pos, char *end, bool raw_bytes,
+        const char *encoding, PyObject **chunk,
+        char **buf_start, char **buf_end, int *kind);
+
+/* The longest incomplete utf-8 character (in bytes) */
+#define MAX_INCOMPLETE_CHAR_LENGTH 3
+
+/*
+ * The number of bytes at the end of `[start, start + length)` which are an
+ * incomplete utf-8 character (these must not be decoded separately).
+ */
+size_t
+incomplete_char_length(const char *start, size_t length);
+
+stream *
+stream_memory(const char *start, const char *end);
+
+#endif
@@ -1,7 +1,8 @@
 /*
  * C side structures to provide capabilities to read Python file like objects
- * in chunks, or iterate through iterables with each result representing a
- * single line of a file.
+ * in chunks (text files with `read`, binary files with `readinto`), or
+ * iterate through iterables with each result representing a single line of
+ * a file.
  */
 
 #include <stdio.h>
@@ -19,9 +20,21 @@
 #include "numpy/arrayobject.h"
 
 #include "stream.h"
+#include "stream_file.h"
+#include "read_stats.h"
 
 #define READ_CHUNKSIZE 1 << 14
 
+/*
+ * Binary files are read into a buffer of at least `MIN_READINTO_SIZE` bytes
+ * which is doubled (up to `MAX_READINTO_SIZE`) whenever a read filled it in
+ * less than `READINTO_TARGET_NS`, i.e. the read size follows the speed of
+ * the file.  Latency bound sources thus end up with few large reads.
+ */
+#define MIN_READINTO_SIZE (1 << 16)
+#define MAX_READINTO_SIZE (1 << 24)
+#define READINTO_TARGET_NS (20 * 1000 * 1000)
+
 
 typedef struct {
     /* The Python file object being read. */
@@ -170,6 +183,7 @@ stream_python_file(PyObject *obj, char *encoding)
     strm->stream_data = (void *)fb;
     strm->stream_nextbuf = (void *)&fb_nextbuf;
     strm->stream_close = &fb_del;
+    strm->stream_rawdata = NULL;
 
     return strm;
 
@@ -179,6 +193,221 @@ fail:
 }
 
 
+/*
+ * Stream from a binary Python file object using `readinto` with a reused
+ * buffer.  The bytes are handed out like the ones of `stream_native_file`
+ * (see `raw_bytes_nextbuf`), so that ASCII (and all latin1) data is never
+ * decoded into a `str`.
+ */
+typedef struct {
+    /* The Python file object being read and its `readinto` attribute. */
+    PyObject *file;
+    PyObject *readinto;
+
+    /*
+     * A bytearray holding an incomplete character of the last read in its
+     * first `MAX_INCOMPLETE_CHAR_LENGTH` bytes, followed by the data which
+     * is read into through the memoryview `view`.
+     */
+    PyObject *buffer;
+    PyObject *view;
+    Py_ssize_t size;
+    /* The size for the next read (the buffer grows to it) */
+    Py_ssize_t read_size;
+
+    /* The unread bytes of the last read and whether the file ended */
+    char *pos;
+    char *end;
+    bool finished;
+
+    /* The incomplete utf-8 character at the end of the last read */
+    char carry[MAX_INCOMPLETE_CHAR_LENGTH];
+    size_t carry_length;
+
+    bool raw_bytes;
+    const char *encoding;
+
+    /* Python str object holding the most recently decoded window. */
+    PyObject *chunk;
+} python_binary_file;
+
+
+/*
+ * Replace the buffer with one of `read_size` bytes (the unread data is
+ * gone, only the carried bytes are kept).
+ */
+static int
+bf_resize_buffer(python_binary_file *bf)
+{
+    if (bf->view != NULL) {
+        /* (fails if the file kept a reference to it, which is fine) */
+        PyObject *res = PyObject_CallMethod(bf->view, "release", NULL);
+        if (res == NULL) {
+            PyErr_Clear();
+        }
+        Py_XDECREF(res);
+        Py_CLEAR(bf->view);
+    }
+    Py_CLEAR(bf->buffer);
+
+    bf->buffer = PyByteArray_FromStringAndSize(
+            NULL, MAX_INCOMPLETE_CHAR_LENGTH + bf->read_size);
+    if (bf->buffer == NULL) {
+        return -1;
+    }
+    PyObject *full_view = PyMemoryView_FromObject(bf->buffer);
+    if (full_view == NULL) {
+        return -1;
+    }
+    bf->view = PySequence_GetSlice(full_view, MAX_INCOMPLETE_CHAR_LENGTH,
+            MAX_INCOMPLETE_CHAR_LENGTH + bf->read_size);
+    Py_DECREF(full_view);
+    if (bf->view == NULL) {
+        return -1;
+    }
+    bf->size = bf->read_size;
+    return 0;
+}
+
+
+/*
+ * Read the next bytes into the buffer (after the carried bytes).
+ */
+static int
+bf_fill(python_binary_file *bf)
+{
+    if (bf->size != bf->read_size && bf_resize_buffer(bf) < 0) {
+        return -1;
+    }
+    char *data = (PyByteArray_AS_STRING(bf->buffer)
+                  + MAX_INCOMPLETE_CHAR_LENGTH);
+
+    int64_t start_time = read_stats_now();
+    PyObject *res = PyObject_CallFunctionObjArgs(bf->readinto, bf->view, NULL);
+    if (res == NULL) {
+        return -1;
+    }
+    int64_t elapsed = read_stats_now() - start_time;
+    Py_ssize_t length = PyNumber_AsSsize_t(res, PyExc_OverflowError);
+    Py_DECREF(res);
+    if (length == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    if (length < 0 || length > bf->size) {
+        PyErr_Format(PyExc_ValueError,
+                "readinto() returned %zd, which is not between 0 and the "
+                "buffer size.", length);
+        return -1;
+    }
+
+    if (length == bf->size && elapsed < READINTO_TARGET_NS
+            && bf->read_size < MAX_READINTO_SIZE) {
+        bf->read_size *= 2;
+    }
+
+    bf->pos = data - bf->carry_length;
+    memcpy(bf->pos, bf->carry, bf->carry_length);
+    bf->end = data + length;
+    bf->carry_length = 0;
+    if (length == 0) {
+        /* An incomplete last character is decoded (and raises) */
+        bf->finished = true;
+    }
+    else if (!bf->raw_bytes) {
+        bf->carry_length = incomplete_char_length(bf->pos, bf->end - bf->pos);
+        bf->end -= bf->carry_length;
+        memcpy(bf->carry, bf->end, bf->carry_length);
+    }
+    return 0;
+}
+
+
+static int
+bf_nextbuf(python_binary_file *bf, char **start, char **end, int *kind)
+{
+    Py_CLEAR(bf->chunk);
+
+    while (bf->pos == bf->end) {
+        if (bf->finished) {
+            *start = bf->end;
+            *end = bf->end;
+            *kind = PyUnicode_1BYTE_KIND;
+            return BUFFER_IS_FILEEND;
+        }
+        if (bf_fill(bf) < 0) {
+            return -1;
+        }
+    }
+    return raw_bytes_nextbuf(&bf->pos, bf->end, bf->raw_bytes,
+            bf->encoding, &bf->chunk, start, end, kind);
+}
+
+
+static int
+bf_del(stream *strm)
+{
+    python_binary_file *bf = (python_binary_file *)strm->stream_data;
+
+    Py_XDECREF(bf->file);
+    Py_XDECREF(bf->readinto);
+    Py_XDECREF(bf->view);
+    Py_XDECREF(bf->buffer);
+    Py_XDECREF(bf->chunk);
+
+    free(bf);
+    free(strm);
+
+    return 0;
+}
+
+
+stream *
+stream_python_binary_file(PyObject *obj, const char *encoding)
+{
+    python_binary_file *bf;
+    stream *strm;
+
+    bool raw_bytes;
+    if (native_encoding_check(encoding, &raw_bytes) < 0) {
+        return NULL;
+    }
+
+    bf = (python_binary_file *)malloc(sizeof(python_binary_file));
+    if (bf == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    memset(bf, 0, sizeof(python_binary_file));
+    bf->raw_bytes = raw_bytes;
+    bf->encoding = encoding;
+    bf->read_size = MIN_READINTO_SIZE;
+
+    strm = (stream *)malloc(sizeof(stream));
+    if (strm == NULL) {
+        PyErr_NoMemory();
+        free(bf);
+        return NULL;
+    }
+    strm->stream_data = (void *)bf;
+    strm->stream_nextbuf = (void *)&bf_nextbuf;
+    strm->stream_close = &bf_del;
+    strm->stream_rawdata = NULL;
+
+    bf->file = obj;
+    Py_INCREF(bf->file);
+
+    bf->readinto = PyObject_GetAttrString(obj, "readinto");
+    if (bf->readinto == NULL || bf_resize_buffer(bf) < 0) {
+        goto fail;
+    }
+    return strm;
+
+fail:
+    bf_del(strm);
+    return NULL;
+}
+
+
 /*
  * Stream from a Python iterable by interpreting each item as a line in a file
  */
@@ -267,6 +496,7 @@ stream_python_iterable(PyObject *obj, char *encoding)
     strm->stream_data = (void *)it;
     strm->stream_nextbuf = (void *)&it_nextbuf;
     strm->stream_close = &it_del;
+    strm->stream_rawdata = NULL;
 
     return strm;
 
@@ -10,6 +10,13 @@
 stream *
 stream_python_file(PyObject *obj, char *encoding);
 
+/*
+ * Read the binary file object `obj` with `readinto`, `encoding` must be one
+ * which can be read natively (see `native_encoding_check`).
+ */
+stream *
+stream_python_binary_file(PyObject *obj, const char *encoding);
+
 stream *
 stream_python_iterable(PyObject *obj, char *encoding);
 
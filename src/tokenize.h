@@ -5,6 +5,8 @@
 #include <Python.h>
 #include "stream.h"
 #include "parser_config.h"
+#include "simd_scan.h"
+#include "read_stats.h"
 
 
 typedef enum {
@@ -14,19 +16,30 @@ typedef enum {
     /* Main field parsing states */
     TOKENIZE_UNQUOTED,
     TOKENIZE_UNQUOTED_WHITESPACE,
+    /* A multi-character comment may continue in the next buffer */
+    TOKENIZE_CHECK_COMMENT,
     TOKENIZE_QUOTED,
     /* Handling of two character control sequences (except "\r\n") */
     TOKENIZE_QUOTED_CHECK_DOUBLE_QUOTE,
+    /* Embedded "\r\n" within a quoted field (the "\r" was translated) */
+    TOKENIZE_QUOTED_EAT_CRLF,
     /* Line end handling */
     TOKENIZE_LINE_END,
     TOKENIZE_EAT_CRLF,  /* "\r\n" support (carriage return, line feed) */
     TOKENIZE_GOTO_LINE_END,
+    /* The remaining fields of the row are not needed */
+    TOKENIZE_SKIP_FIELDS,
 } tokenizer_parsing_state;
 
 
 
+/*
+ * A field spans `[offset, end)` of the row data (in characters).  The data
+ * is not necessarily NUL terminated.
+ */
 typedef struct {
     size_t offset;
+    size_t end;
     bool quoted;
 } field_info;
 
@@ -38,6 +51,24 @@ typedef struct {
     int unicode_kind;
     int buf_state;
     size_t num_fields;
+    /*
+     * The number of fields needed (SIZE_MAX if all are), the remaining
+     * fields of a row are skipped if possible (so the row may report fewer
+     * fields than it has).  Set by the user after `tokenizer_init`.
+     */
+    size_t max_fields;
+    /* Counters to update or NULL, set by the user after `tokenizer_init` */
+    read_stats *stats;
+    /* Internal: whether fields of the current row were skipped */
+    bool skipped_fields;
+    /*
+     * Internal: the characters at the end of the last buffer which may
+     * start a multi-character comment (`TOKENIZE_CHECK_COMMENT`), and the
+     * unquoted state to continue with if they do not.
+     */
+    Py_UCS4 comment_candidate[MAX_COMMENT_LENGTH];
+    int comment_candidate_length;
+    tokenizer_parsing_state comment_return_state;
     /* the buffer we are currently working on */
     char *pos;
     char *end;
@@ -54,13 +85,34 @@ typedef struct {
 
     /*
      * Fields, including information about the field being quoted.  This
-     * always includes one "additional" empty field.  The length of a field
-     * is equal to `fields[i+1].offset - fields[i].offset - 1`.
+     * always includes one "additional" empty field.
      *
      * The tokenizer assumes at least one field is allocated.
      */
     field_info *fields;
     size_t fields_size;
+
+    /*
+     * The data of the fields of the last row: Either the stream buffer
+     * (valid until the next call to `tokenize`) or the field buffer if the
+     * row was copied.  `row_kind` is the unicode kind of the data.
+     */
+    char *row_data;
+    int row_kind;
+    /* Internal: whether the row is being copied and where it started */
+    bool copy_fields;
+    char *row_start;
+
+    /*
+     * Characters ending an unquoted field, a quoted field or a comment
+     * (scanned for with SIMD in 1-byte kind data).
+     */
+    scan_charset unquoted_chars;
+    scan_charset quoted_chars;
+    scan_charset line_end_chars;
+    /* Line ends and the quote (when skipping the rest of a row) */
+    scan_charset skip_chars;
+    scan_cache scan_cache;
 } tokenizer_state;
 
 
@@ -71,7 +123,43 @@ tokenizer_clear(tokenizer_state *ts);
 int
 tokenizer_init(tokenizer_state *ts, parser_config *config);
 
+/*
+ * Like `tokenizer_init` and `tokenizer_clear`, but take the buffers from
+ * (and give them back to) the arena of the current thread, see `arena.h`.
+ * Both need the GIL.
+ */
+int
+tokenizer_init_from_arena(tokenizer_state *ts, parser_config *config);
+
+void
+tokenizer_clear_to_arena(tokenizer_state *ts);
+
+/*
+ * Prepare an initialized tokenizer for reading the next stream (with the
+ * same config), keeping its buffers.
+ */
+void
+tokenizer_reset(tokenizer_state *ts);
+
 int
 tokenize(stream *s, tokenizer_state *ts, parser_config *const config);
 
+/*
+ * Skip up to `*num_lines` lines (quotes are ignored, like `skiprows`) by
+ * searching for the line ends only.  `*num_lines` is decremented by the
+ * number of lines skipped.  Returns -1 on error and like `tokenize` 1 if
+ * the end of the file was reached and 0 otherwise.
+ */
+int
+tokenizer_skip_lines(stream *s, tokenizer_state *ts, Py_ssize_t *num_lines);
+
+/*
+ * Get field `i` of the last row as UCS4 (for row data of a different kind
+ * it is copied into the field buffer, overwriting the previous result).
+ * The string is NUL terminated only if it was copied.
+ */
+int
+tokenizer_field_as_ucs4(tokenizer_state *ts, size_t i,
+        const Py_UCS4 **str, const Py_UCS4 **end);
+
 #endif